@@ -0,0 +1,283 @@
+#ifndef MYOPENPROJECT_ANTIALIASING_H
+#define MYOPENPROJECT_ANTIALIASING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Buffers/RenderTarget.h"
+#include "FrameGraph.h"
+#include "Shader.h"
+#include "TemporalAA.h"
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+
+// How the scene's edges get smoothed,switchable at runtime:
+//   msaa:            the multisampled scene and its resolving blit (main.cpp,not this class),
+//   fxaa:            FXAA 3.11 (Lottes) on the single sampled scene,one pass (fxaa.fs): finds the edge through
+//                    the pixel from the luma around it,searches along it for its ends and samples across it,
+//   smaa:            morphological AA like SMAA 1x (Jimenez et al.),three passes: luma edges with local contrast
+//                    adaptation (smaaedges.fs),the coverage of every edge pixel by the line through its pattern
+//                    (smaaweights.fs),blending with the neighbors by it (smaablend.fs),
+//   temporal:        TemporalAA,
+//   temporalUpscale: TemporalAA with the scene rendered at upscaleScale of the output.
+// Every mode but msaa draws the scene into one single sampled RGBA16F target with a depth texture,
+// getFrameBufferID(),and skips the blit;addTo() adds the mode's passes between the scene and the post chain.
+// The target has an RG16F velocity attachment too,off the draw buffers but in renderVelocity() of the temporal modes.
+// recordFrame() keeps the average GPU frame time of every mode,and switching prints them next to what
+// the mode's render targets take,so the modes can be compared on the same view.
+class AntiAliasing
+{
+public:
+    enum class Mode
+    {
+        msaa,
+        fxaa,
+        smaa,
+        temporal,
+        temporalUpscale,
+    };
+
+    static constexpr std::size_t modeCount{5};
+    static constexpr unsigned int settleFrames{8}; // after a switch,before the frame times count (they come back late)
+
+    inline static Mode mode{Mode::msaa};
+
+    // what the mode hands to the post chain
+    struct Output {
+        FrameGraph::Handle texture;
+        unsigned int width;
+        unsigned int height;
+    };
+
+    // msaaBytes: what the multisampled scene and its resolved copy take,for the comparison
+    AntiAliasing(const unsigned int width,const unsigned int height,const float upscaleScale,const std::size_t msaaBytes)
+        : scene{width,height,{{GL_RGBA16F,GL_RGBA,GL_HALF_FLOAT},{GL_RG16F,GL_RG,GL_HALF_FLOAT}}},temporalAA{width,height},
+          width{width},height{height},upscaleScale{upscaleScale},msaaBytes{msaaBytes}
+    {
+        scene.attachDepthTexture();
+        supported = scene.isComplete();
+        glBindFramebuffer(GL_FRAMEBUFFER,scene.getFrameBufferID());
+        glDrawBuffers(1,&colorOnly); // the scene's shaders only write the color
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+
+        for (const Shader* shader : {&fxaaPass,&edgesPass,&blendPass})
+        {
+            shader->use();
+            shader->setInt("scene",0);
+        }
+        weightsPass.use();
+        weightsPass.setInt("edges",0);
+        blendPass.use();
+        blendPass.setInt("weights",1);
+    }
+
+    [[nodiscard]] static const char* nameOf(const Mode mode)
+    {
+        constexpr std::array<const char*,modeCount> names{"msaa","fxaa","smaa","temporal","temporal upscale"};
+        return names[static_cast<std::size_t>(mode)];
+    }
+
+    // whether the scene goes into getFrameBufferID() this frame instead of the multisampled one
+    [[nodiscard]] bool isSingleSampled() const
+    {
+        return mode != Mode::msaa && supported;
+    }
+
+    // of the output the scene is rendered at,at most
+    [[nodiscard]] float renderScale() const
+    {
+        return isSingleSampled() && mode == Mode::temporalUpscale ? upscaleScale : 1.0f;
+    }
+
+    [[nodiscard]] unsigned int getFrameBufferID() const
+    {
+        return scene.getFrameBufferID();
+    }
+
+    // the projection the scene is drawn with,jittered in the temporal modes;projection and view are the
+    // unjittered ones,culling and shadows keep using those
+    [[nodiscard]] glm::mat4 beginFrame(const glm::mat4& projection,const glm::mat4& view,const unsigned int renderWidth,const unsigned int renderHeight)
+    {
+        frameMode = isSingleSampled() ? mode : Mode::msaa; // the mode may change before endFrame()
+        if (frameMode != lastMode)
+        {
+            lastMode = frameMode;
+            framesInMode = 0;
+            printComparison();
+        }
+        if (!isTemporal())
+        {
+            temporalAA.invalidate();
+            return projection;
+        }
+        return temporalAA.beginFrame(projection,view,renderWidth,renderHeight);
+    }
+
+    // TemporalAA::renderVelocity into the scene's velocity attachment,in the temporal modes;after the opaque passes,
+    // with getFrameBufferID() bound
+    template<typename DrawMoving>
+    void renderVelocity(DrawMoving&& drawMoving)
+    {
+        if (!isTemporal())
+            return;
+        constexpr std::array<GLenum,2> velocityOnly{GL_NONE,GL_COLOR_ATTACHMENT1};
+        constexpr std::array<float,4> noVelocity{};
+        glDrawBuffers(2,velocityOnly.data());
+        glClearBufferfv(GL_COLOR,1,noVelocity.data());
+        temporalAA.renderVelocity(drawMoving);
+        glDrawBuffers(1,&colorOnly);
+    }
+
+    // the mode's passes,reading the scene's bottom left renderWidth x renderHeight (scene is the graph's
+    // handle of getFrameBufferID());only for the single sampled modes
+    Output addTo(FrameGraph& graph,const FrameGraph::Handle sceneHandle,const unsigned int renderWidth,
+                 const unsigned int renderHeight,const unsigned int quadVAO)
+    {
+        const FrameGraph::Handle colors{graph.importTexture("sceneColor",scene.getTextureID(0))};
+        if (isTemporal())
+        {
+            const FrameGraph::Handle velocity{graph.importTexture("sceneVelocity",scene.getTextureID(1))};
+            const FrameGraph::Handle depth{graph.importTexture("sceneDepth",scene.getDepthTextureID())};
+            return {temporalAA.addTo(graph,sceneHandle,colors,velocity,depth,quadVAO),width,height};
+        }
+
+        const glm::vec2 texelSize{1.0f / static_cast<float>(width),1.0f / static_cast<float>(height)}; // of the scene texture
+        const glm::vec2 renderSize{static_cast<float>(renderWidth),static_cast<float>(renderHeight)};
+        FrameGraph::Handle result{};
+        if (frameMode == Mode::fxaa)
+        {
+            graph.addPass("fxaa",[&](FrameGraph::Builder& builder){
+                builder.read(sceneHandle);
+                builder.read(colors);
+                result = builder.create("antialiased",{renderWidth,renderHeight,GL_RGBA16F});
+            },[this,colors,texelSize,renderSize,quadVAO](const FrameGraph::Context& context){
+                fxaaPass.use();
+                fxaaPass.setVec2("texelSize",texelSize.x,texelSize.y);
+                fxaaPass.setVec2("renderSize",renderSize.x,renderSize.y);
+                FrameGraph::drawQuad(quadVAO,{context.texture(colors)});
+            });
+            return {result,renderWidth,renderHeight};
+        }
+
+        FrameGraph::Handle edges{};
+        graph.addPass("smaaEdges",[&](FrameGraph::Builder& builder){
+            builder.read(sceneHandle);
+            builder.read(colors);
+            edges = builder.create("smaaEdges",{renderWidth,renderHeight,GL_RG8});
+        },[this,colors,renderSize,quadVAO](const FrameGraph::Context& context){
+            edgesPass.use();
+            edgesPass.setVec2("renderSize",renderSize.x,renderSize.y);
+            FrameGraph::drawQuad(quadVAO,{context.texture(colors)});
+        });
+        FrameGraph::Handle weights{};
+        graph.addPass("smaaWeights",[&](FrameGraph::Builder& builder){
+            builder.read(edges);
+            weights = builder.create("smaaWeights",{renderWidth,renderHeight,GL_RGBA8});
+        },[this,edges,quadVAO](const FrameGraph::Context& context){
+            weightsPass.use();
+            FrameGraph::drawQuad(quadVAO,{context.texture(edges)});
+        });
+        graph.addPass("smaaBlend",[&](FrameGraph::Builder& builder){
+            builder.read(colors);
+            builder.read(weights);
+            result = builder.create("antialiased",{renderWidth,renderHeight,GL_RGBA16F});
+        },[this,colors,weights,renderSize,quadVAO](const FrameGraph::Context& context){
+            blendPass.use();
+            blendPass.setVec2("renderSize",renderSize.x,renderSize.y);
+            FrameGraph::drawQuad(quadVAO,{context.texture(colors),context.texture(weights)});
+        });
+        return {result,renderWidth,renderHeight};
+    }
+
+    // after the frame's passes ran
+    void endFrame()
+    {
+        if (isTemporal())
+            temporalAA.endFrame();
+    }
+
+    // the GPU time of a frame,DynamicResolution::gpuMilliseconds(),for the comparison
+    void recordFrame(const double gpuMilliseconds)
+    {
+        if (++framesInMode <= settleFrames)
+            return;
+        Timing& timing{timings[static_cast<std::size_t>(frameMode)]};
+        timing.milliseconds += gpuMilliseconds;
+        ++timing.frames;
+    }
+
+    // the render targets a mode needs at the full size,the scene's included (its velocity attachment only counts for the temporal modes)
+    [[nodiscard]] std::size_t memoryOf(const Mode of) const
+    {
+        const auto bytes = [&](const GLenum format,const unsigned int w = 0,const unsigned int h = 0){
+            return FrameGraph::bytesOf({w ? w : width,h ? h : height,format});
+        };
+        const std::size_t singleSampled{bytes(GL_RGBA16F) + bytes(GL_DEPTH_COMPONENT32F)};
+        const auto scaled = [&](const unsigned int size){ return static_cast<unsigned int>(static_cast<float>(size) * upscaleScale); };
+        switch (of)
+        {
+            case Mode::msaa:
+                return msaaBytes;
+            case Mode::fxaa:
+                return singleSampled + bytes(GL_RGBA16F);
+            case Mode::smaa:
+                return singleSampled + bytes(GL_RG8) + bytes(GL_RGBA8) + bytes(GL_RGBA16F);
+            case Mode::temporal:
+                return singleSampled + 2 * bytes(GL_RG16F) + 2 * bytes(GL_RGBA16F); // velocity,motion,two histories
+            case Mode::temporalUpscale: // only the rendered part of the scene target is used,it still takes its full size
+                return singleSampled + bytes(GL_RG16F) + bytes(GL_RG16F,scaled(width),scaled(height)) + 2 * bytes(GL_RGBA16F);
+        }
+        return 0;
+    }
+
+private:
+    struct Timing {
+        double milliseconds{0.0};
+        unsigned int frames{0};
+    };
+
+    static constexpr GLenum colorOnly{GL_COLOR_ATTACHMENT0};
+
+    RenderTarget scene;
+    TemporalAA temporalAA;
+    Shader fxaaPass{"frameBufferShader.vs","fxaa.fs"};
+    Shader edgesPass{"frameBufferShader.vs","smaaedges.fs"};
+    Shader weightsPass{"frameBufferShader.vs","smaaweights.fs"};
+    Shader blendPass{"frameBufferShader.vs","smaablend.fs"};
+    unsigned int width;
+    unsigned int height;
+    float upscaleScale;
+    std::size_t msaaBytes;
+    bool supported{false};
+
+    Mode frameMode{Mode::msaa};
+    Mode lastMode{Mode::msaa};
+    unsigned int framesInMode{0};
+    std::array<Timing,modeCount> timings{};
+
+    [[nodiscard]] bool isTemporal() const
+    {
+        return frameMode == Mode::temporal || frameMode == Mode::temporalUpscale;
+    }
+
+    void printComparison() const
+    {
+        std::cout << "ANTI-ALIASING: " << nameOf(frameMode) << '\n';
+        for (std::size_t i{0}; i < modeCount; ++i)
+        {
+            const auto of{static_cast<Mode>(i)};
+            std::cout << "  " << std::left << std::setw(18) << nameOf(of) << std::right << std::fixed << std::setprecision(2);
+            if (timings[i].frames)
+                std::cout << timings[i].milliseconds / timings[i].frames << " ms GPU over " << timings[i].frames << " frames,";
+            else
+                std::cout << "not measured yet,";
+            std::cout << ' ' << static_cast<double>(memoryOf(of)) / (1024.0 * 1024.0) << " MB of targets\n" << std::defaultfloat;
+        }
+    }
+};
+
+#endif //MYOPENPROJECT_ANTIALIASING_H
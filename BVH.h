@@ -0,0 +1,494 @@
+#ifndef MYOPENPROJECT_BVH_H
+#define MYOPENPROJECT_BVH_H
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+#include "Frustum.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Bounding volume hierarchy over the AABBs of scene objects. The primitive ids are the indices
+// of the bounds given to build(),and that is what every query hands back.
+//
+// build() splits with a binned surface area heuristic;with a ThreadPool the top levels are split
+// on the calling thread and the subtrees below them are built in parallel. Objects that move keep
+// the topology:update() their bounds and refit() once per frame,which is a single backwards pass
+// because children are always stored after their parent. Rebuild when the tree gets too loose.
+class BVH
+{
+public:
+    struct Node {
+        glm::vec3 min{};
+        std::uint32_t leftOrFirst{}; // first child if count == 0,else first entry of primitiveIndices
+        glm::vec3 max{};
+        std::uint32_t count{};       // primitives in the leaf
+
+        [[nodiscard]] bool isLeaf() const
+        {
+            return count > 0;
+        }
+    };
+
+    struct Ray {
+        glm::vec3 origin{};
+        glm::vec3 direction{}; // doesn't have to be normalized,distances are in multiples of it
+    };
+
+    struct RayHit {
+        std::uint32_t primitive{};
+        float distance{};
+    };
+
+    void build(const std::vector<AABB>& bounds,ThreadPool* pool = nullptr)
+    {
+        primitiveBounds = bounds;
+        const auto count{static_cast<std::uint32_t>(bounds.size())};
+
+        primitiveIndices.resize(count);
+        std::iota(primitiveIndices.begin(),primitiveIndices.end(),0u);
+        centroids.resize(count);
+        for (std::uint32_t i{0}; i < count; ++i)
+            centroids[i] = bounds[i].center();
+
+        if (!count) // nothing to query,refit or update (a model that didn't load)
+        {
+            nodes.clear();
+            return;
+        }
+        nodes.assign(2 * count - 1,Node{});
+
+        std::atomic<std::uint32_t> nodesUsed{1};
+        nodes[0].leftOrFirst = 0;
+        nodes[0].count = count;
+        updateNodeBounds(nodes[0]);
+
+        if (!pool || count < parallelThreshold)
+            subdivide(0,0,nodesUsed);
+        else
+        {
+            // split breadth first until every thread has a few subtrees to take
+            std::vector<std::uint32_t> frontier{0};
+            std::vector<std::uint32_t> subtrees;
+            const std::size_t wanted{4 * (pool->size() + 1)};
+            std::uint32_t depth{0};
+            while (!frontier.empty() && frontier.size() + subtrees.size() < wanted)
+            {
+                std::vector<std::uint32_t> next;
+                for (const std::uint32_t node : frontier)
+                {
+                    if (nodes[node].count < parallelThreshold || !split(node,nodesUsed))
+                    {
+                        subtrees.push_back(node);
+                        continue;
+                    }
+                    next.push_back(nodes[node].leftOrFirst);
+                    next.push_back(nodes[node].leftOrFirst + 1);
+                }
+                frontier = std::move(next);
+                ++depth;
+            }
+            subtrees.insert(subtrees.end(),frontier.begin(),frontier.end());
+
+            std::vector<std::future<void>> pending;
+            pending.reserve(subtrees.size());
+            for (const std::uint32_t node : subtrees)
+                pending.push_back(pool->submit([this,node,depth,&nodesUsed]{ subdivide(node,depth,nodesUsed); }));
+            for (std::future<void>& done : pending)
+                done.get();
+        }
+
+        nodes.resize(nodesUsed.load());
+    }
+
+    // new bounds for a primitive that moved;the tree is only correct again after refit()
+    void update(const std::uint32_t primitive,const AABB& bounds)
+    {
+        if (primitive >= primitiveBounds.size()) // not in the tree,an empty one has none
+            return;
+        primitiveBounds[primitive] = bounds;
+    }
+
+    void refit()
+    {
+        for (std::size_t i{nodes.size()}; i-- > 0;)
+        {
+            Node& node = nodes[i];
+            if (node.isLeaf())
+                updateNodeBounds(node);
+            else
+            {
+                const Node& left = nodes[node.leftOrFirst];
+                const Node& right = nodes[node.leftOrFirst + 1];
+                node.min = glm::min(left.min,right.min);
+                node.max = glm::max(left.max,right.max);
+            }
+        }
+    }
+
+    // visit(primitive) for every primitive whose box is at least partly inside the frustum;
+    // subtrees that are completely inside are reported without testing them any further
+    template<typename F>
+    void query(const Frustum& frustum,F&& visit) const
+    {
+        if (nodes.empty())
+            return;
+
+        constexpr std::uint32_t allPlanes{(1u << Frustum::count) - 1};
+        std::array<std::pair<std::uint32_t,std::uint32_t>,stackSize> stack; // (node,planes still crossing its parent)
+        std::size_t size{0};
+        stack[size++] = {0,allPlanes};
+        while (size)
+        {
+            const auto [index,parentPlanes] = stack[--size];
+            const Node& node = nodes[index];
+
+            std::uint32_t planes{parentPlanes};
+            if (!classify(frustum,node,planes))
+                continue;
+
+            if (!planes)
+                visitSubtree(index,visit);
+            else if (node.isLeaf())
+            {
+                for (std::uint32_t i{0}; i < node.count; ++i)
+                {
+                    const std::uint32_t primitive{primitiveIndices[node.leftOrFirst + i]};
+                    if (frustum.intersects(primitiveBounds[primitive]))
+                        visit(primitive);
+                }
+            }
+            else
+            {
+                stack[size++] = {node.leftOrFirst,planes};
+                stack[size++] = {node.leftOrFirst + 1,planes};
+            }
+        }
+    }
+
+    // visit(primitive) for every primitive whose box touches the sphere
+    template<typename F>
+    void query(const BoundingSphere& sphere,F&& visit) const
+    {
+        if (nodes.empty())
+            return;
+
+        const float radiusSquared{sphere.radius * sphere.radius};
+        std::array<std::uint32_t,stackSize> stack;
+        std::size_t size{0};
+        stack[size++] = 0;
+        while (size)
+        {
+            const Node& node = nodes[stack[--size]];
+            if (distanceSquared(sphere.center,node.min,node.max) > radiusSquared)
+                continue;
+
+            if (node.isLeaf())
+            {
+                for (std::uint32_t i{0}; i < node.count; ++i)
+                {
+                    const std::uint32_t primitive{primitiveIndices[node.leftOrFirst + i]};
+                    const AABB& box = primitiveBounds[primitive];
+                    if (distanceSquared(sphere.center,box.min,box.max) <= radiusSquared)
+                        visit(primitive);
+                }
+            }
+            else
+            {
+                stack[size++] = node.leftOrFirst;
+                stack[size++] = node.leftOrFirst + 1;
+            }
+        }
+    }
+
+    // closest primitive along the ray. intersect(primitive,ray) returns the distance to the real
+    // surface (or nothing),it is only called for primitives whose box the ray goes through
+    template<typename F>
+    [[nodiscard]] std::optional<RayHit> raycast(const Ray& ray,float maxDistance,F&& intersect) const
+    {
+        if (nodes.empty())
+            return std::nullopt;
+
+        const glm::vec3 inverseDirection{1.0f / ray.direction.x,1.0f / ray.direction.y,1.0f / ray.direction.z};
+        std::optional<RayHit> closest;
+        std::array<std::uint32_t,stackSize> stack;
+        std::size_t size{0};
+        stack[size++] = 0;
+        while (size)
+        {
+            const Node& node = nodes[stack[--size]];
+            if (slabs(ray.origin,inverseDirection,node.min,node.max,maxDistance) == noHit)
+                continue;
+
+            if (node.isLeaf())
+            {
+                for (std::uint32_t i{0}; i < node.count; ++i)
+                {
+                    const std::uint32_t primitive{primitiveIndices[node.leftOrFirst + i]};
+                    const AABB& box = primitiveBounds[primitive];
+                    if (slabs(ray.origin,inverseDirection,box.min,box.max,maxDistance) == noHit)
+                        continue;
+                    if (const std::optional<float> distance = intersect(primitive,ray); distance && *distance < maxDistance)
+                    {
+                        maxDistance = *distance; // everything further away can be skipped from now on
+                        closest = RayHit{primitive,*distance};
+                    }
+                }
+                continue;
+            }
+
+            // the nearer child goes on top,so its hits shorten the ray before the other one is tested
+            std::uint32_t nearChild{node.leftOrFirst};
+            std::uint32_t farChild{node.leftOrFirst + 1};
+            float nearDistance{slabs(ray.origin,inverseDirection,nodes[nearChild].min,nodes[nearChild].max,maxDistance)};
+            float farDistance{slabs(ray.origin,inverseDirection,nodes[farChild].min,nodes[farChild].max,maxDistance)};
+            if (farDistance < nearDistance)
+            {
+                std::swap(nearChild,farChild);
+                std::swap(nearDistance,farDistance);
+            }
+            if (farDistance != noHit)
+                stack[size++] = farChild;
+            if (nearDistance != noHit)
+                stack[size++] = nearChild;
+        }
+        return closest;
+    }
+
+    // against the primitive boxes themselves,enough for picking whole objects
+    [[nodiscard]] std::optional<RayHit> raycast(const Ray& ray,const float maxDistance = std::numeric_limits<float>::max()) const
+    {
+        const glm::vec3 inverseDirection{1.0f / ray.direction.x,1.0f / ray.direction.y,1.0f / ray.direction.z};
+        return raycast(ray,maxDistance,[&](const std::uint32_t primitive,const Ray&) -> std::optional<float> {
+            const AABB& box = primitiveBounds[primitive];
+            const float distance{slabs(ray.origin,inverseDirection,box.min,box.max,maxDistance)};
+            return distance == noHit ? std::nullopt : std::optional<float>{distance};
+        });
+    }
+
+    [[nodiscard]] const AABB& boundsOf(const std::uint32_t primitive) const
+    {
+        return primitiveBounds[primitive];
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return primitiveBounds.size();
+    }
+
+    [[nodiscard]] std::size_t nodeCount() const
+    {
+        return nodes.size();
+    }
+
+private:
+    static constexpr std::uint32_t binCount{16};
+    static constexpr float traversalCost{1.0f};
+    static constexpr std::uint32_t maxLeafSize{4};        // leaves only get bigger when the primitives can't be told apart
+    static constexpr std::uint32_t parallelThreshold{4096}; // smaller subtrees aren't worth a job
+    static constexpr std::uint32_t maxDepth{64};           // deeper nodes stay leaves,so the traversal stacks can't overflow
+    static constexpr std::size_t stackSize{2 * maxDepth};
+    static constexpr float noHit{std::numeric_limits<float>::max()};
+
+    std::vector<Node> nodes;
+    std::vector<AABB> primitiveBounds;
+    std::vector<glm::vec3> centroids;
+    std::vector<std::uint32_t> primitiveIndices; // leaves point at ranges of it
+
+    void updateNodeBounds(Node& node) const
+    {
+        AABB bounds{};
+        for (std::uint32_t i{0}; i < node.count; ++i)
+            bounds.expand(primitiveBounds[primitiveIndices[node.leftOrFirst + i]]);
+        node.min = bounds.min;
+        node.max = bounds.max;
+    }
+
+    static float area(const glm::vec3& min,const glm::vec3& max)
+    {
+        const glm::vec3 size{max - min};
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    // depth first from node,keeping its own stack so parallel subtrees don't share anything
+    void subdivide(const std::uint32_t root,const std::uint32_t rootDepth,std::atomic<std::uint32_t>& nodesUsed)
+    {
+        std::vector<std::pair<std::uint32_t,std::uint32_t>> pending{{root,rootDepth}}; // (node,depth)
+        while (!pending.empty())
+        {
+            const auto [node,depth] = pending.back();
+            pending.pop_back();
+            if (depth + 1 >= maxDepth || !split(node,nodesUsed))
+                continue;
+            pending.emplace_back(nodes[node].leftOrFirst,depth + 1);
+            pending.emplace_back(nodes[node].leftOrFirst + 1,depth + 1);
+        }
+    }
+
+    // one binned SAH split;false leaves the node a leaf
+    bool split(const std::uint32_t index,std::atomic<std::uint32_t>& nodesUsed)
+    {
+        Node& node = nodes[index];
+        if (node.count <= 2)
+            return false;
+
+        AABB centroidBounds{};
+        for (std::uint32_t i{0}; i < node.count; ++i)
+            centroidBounds.expand(centroids[primitiveIndices[node.leftOrFirst + i]]);
+
+        struct Bin {
+            AABB bounds{};
+            std::uint32_t count{};
+        };
+
+        const std::uint32_t usedBins{std::min(binCount,node.count)}; // small nodes don't need all the planes
+        float bestCost{std::numeric_limits<float>::max()};
+        int bestAxis{-1};
+        std::uint32_t bestBin{0};
+        for (int axis{0}; axis < 3; ++axis)
+        {
+            const float low{centroidBounds.min[axis]};
+            const float extent{centroidBounds.max[axis] - low};
+            if (extent <= 0.0f)
+                continue;
+
+            std::array<Bin,binCount> bins{};
+            const float toBin{static_cast<float>(usedBins) / extent};
+            for (std::uint32_t i{0}; i < node.count; ++i)
+            {
+                const std::uint32_t primitive{primitiveIndices[node.leftOrFirst + i]};
+                const auto bin{std::min(usedBins - 1,static_cast<std::uint32_t>((centroids[primitive][axis] - low) * toBin))};
+                bins[bin].bounds.expand(primitiveBounds[primitive]);
+                ++bins[bin].count;
+            }
+
+            // sweep from both sides so every plane between two bins costs O(1)
+            std::array<float,binCount - 1> leftCost{};
+            AABB left{};
+            std::uint32_t leftCount{0};
+            for (std::uint32_t i{0}; i < usedBins - 1; ++i)
+            {
+                left.expand(bins[i].bounds);
+                leftCount += bins[i].count;
+                leftCost[i] = leftCount ? static_cast<float>(leftCount) * area(left.min,left.max) : 0.0f;
+            }
+            AABB right{};
+            std::uint32_t rightCount{0};
+            for (std::uint32_t i{usedBins - 1}; i > 0; --i)
+            {
+                right.expand(bins[i].bounds);
+                rightCount += bins[i].count;
+                if (!rightCount || rightCount == node.count)
+                    continue;
+                const float cost{leftCost[i - 1] + static_cast<float>(rightCount) * area(right.min,right.max)};
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = i;
+                }
+            }
+        }
+
+        // in units of one primitive test;visiting the two children costs about as much as one more
+        const float nodeArea{area(node.min,node.max)};
+        const float leafCost{static_cast<float>(node.count) * nodeArea};
+        if (bestAxis < 0 || (bestCost + traversalCost * nodeArea >= leafCost && node.count <= maxLeafSize))
+            return false;
+
+        const float low{centroidBounds.min[bestAxis]};
+        const float toBin{static_cast<float>(usedBins) / (centroidBounds.max[bestAxis] - low)};
+        const auto first{primitiveIndices.begin() + node.leftOrFirst};
+        const auto middle{std::partition(first,first + node.count,[&](const std::uint32_t primitive){
+            return std::min(usedBins - 1,static_cast<std::uint32_t>((centroids[primitive][bestAxis] - low) * toBin)) < bestBin;
+        })};
+        const auto leftCount{static_cast<std::uint32_t>(middle - first)};
+        if (!leftCount || leftCount == node.count)
+            return false;
+
+        const std::uint32_t leftChild{nodesUsed.fetch_add(2)};
+        nodes[leftChild].leftOrFirst = node.leftOrFirst;
+        nodes[leftChild].count = leftCount;
+        nodes[leftChild + 1].leftOrFirst = node.leftOrFirst + leftCount;
+        nodes[leftChild + 1].count = node.count - leftCount;
+        updateNodeBounds(nodes[leftChild]);
+        updateNodeBounds(nodes[leftChild + 1]);
+
+        node.leftOrFirst = leftChild;
+        node.count = 0;
+        return true;
+    }
+
+    // false if the node is outside;clears the bits of the planes the node is completely inside of
+    static bool classify(const Frustum& frustum,const Node& node,std::uint32_t& planes)
+    {
+        const glm::vec3 center{(node.min + node.max) * 0.5f};
+        const glm::vec3 extents{(node.max - node.min) * 0.5f};
+        for (std::uint32_t p{0}; p < Frustum::count; ++p)
+        {
+            if (!(planes & (1u << p)))
+                continue;
+            const glm::vec4& plane = frustum.planes[p];
+            const float distance{glm::dot(glm::vec3(plane),center) + plane.w};
+            const float radius{glm::dot(glm::abs(glm::vec3(plane)),extents)};
+            if (distance + radius < 0.0f)
+                return false;
+            if (distance - radius >= 0.0f)
+                planes &= ~(1u << p);
+        }
+        return true;
+    }
+
+    template<typename F>
+    void visitSubtree(const std::uint32_t root,F& visit) const
+    {
+        std::array<std::uint32_t,stackSize> stack;
+        std::size_t size{0};
+        stack[size++] = root;
+        while (size)
+        {
+            const Node& node = nodes[stack[--size]];
+            if (node.isLeaf())
+            {
+                for (std::uint32_t i{0}; i < node.count; ++i)
+                    visit(primitiveIndices[node.leftOrFirst + i]);
+            }
+            else
+            {
+                stack[size++] = node.leftOrFirst;
+                stack[size++] = node.leftOrFirst + 1;
+            }
+        }
+    }
+
+    static float distanceSquared(const glm::vec3& point,const glm::vec3& min,const glm::vec3& max)
+    {
+        const glm::vec3 closest{glm::clamp(point,min,max)};
+        const glm::vec3 offset{point - closest};
+        return glm::dot(offset,offset);
+    }
+
+    // entry distance of the ray into the box,noHit if it misses or enters past maxDistance
+    static float slabs(const glm::vec3& origin,const glm::vec3& inverseDirection,const glm::vec3& min,const glm::vec3& max,const float maxDistance)
+    {
+        const glm::vec3 t0{(min - origin) * inverseDirection};
+        const glm::vec3 t1{(max - origin) * inverseDirection};
+        const glm::vec3 tNear{glm::min(t0,t1)};
+        const glm::vec3 tFar{glm::max(t0,t1)};
+        const float enter{std::max({tNear.x,tNear.y,tNear.z,0.0f})};
+        const float exit{std::min({tFar.x,tFar.y,tFar.z,maxDistance})};
+        return enter <= exit ? enter : noHit;
+    }
+};
+
+#endif //MYOPENPROJECT_BVH_H
@@ -0,0 +1,147 @@
+// Times the BVH against the flat FrustumCuller on random boxes:build (single threaded and on the
+// pool),refit,and frustum/sphere/ray queries. Needs no window or GL context.
+//   ./BVH_BENCHMARK [primitive counts...]   defaults to 10000 and 1000000
+// Both cull the refit boxes,and it exits with a failure when they don't find as many visible.
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "BVH.h"
+#include "Bounds.h"
+#include "Frustum.h"
+#include "FrustumCuller.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    template<typename F>
+    double milliseconds(F&& work,const int repeats = 1) // best of repeats
+    {
+        double best{1e30};
+        for (int i{0}; i < repeats; ++i)
+        {
+            const auto start{std::chrono::steady_clock::now()};
+            work();
+            const std::chrono::duration<double,std::milli> elapsed{std::chrono::steady_clock::now() - start};
+            best = std::min(best,elapsed.count());
+        }
+        return best;
+    }
+
+    void report(const char* name,const double time,const std::size_t result)
+    {
+        std::cout << "  " << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed
+                  << std::setprecision(3) << time << " ms   (" << result << ")\n";
+    }
+
+    // false if the tree and the flat culler disagree on how many boxes are visible
+    bool run(const std::size_t count,ThreadPool& pool)
+    {
+        // boxes spread over a cube that grows with the count,so the density stays about the same
+        const float worldSize{std::cbrt(static_cast<float>(count)) * 4.0f};
+        std::mt19937 random{42};
+        std::uniform_real_distribution<float> position{-worldSize,worldSize};
+        std::uniform_real_distribution<float> size{0.1f,1.5f};
+
+        std::vector<AABB> bounds(count);
+        for (AABB& box : bounds)
+        {
+            const glm::vec3 center{position(random),position(random),position(random)};
+            const glm::vec3 extents{size(random),size(random),size(random)};
+            box = {center - extents,center + extents};
+        }
+
+        const glm::mat4 projection{glm::perspective(glm::radians(60.0f),4.0f / 3.0f,0.1f,worldSize)};
+        const glm::mat4 view{glm::lookAt(glm::vec3(0.0f),glm::vec3(0.0f,0.0f,-1.0f),glm::vec3(0.0f,1.0f,0.0f))};
+        const Frustum frustum{projection * view};
+
+        std::cout << count << " primitives,"  << pool.size() + 1 << " threads\n";
+
+        BVH bvh;
+        const double buildTime{milliseconds([&]{ bvh.build(bounds); })};
+        report("build",buildTime,bvh.nodeCount());
+        const double parallelBuildTime{milliseconds([&]{ bvh.build(bounds,&pool); })};
+        report("build (thread pool)",parallelBuildTime,bvh.nodeCount());
+
+        std::mt19937 wobble{7};
+        std::uniform_real_distribution<float> offset{-0.2f,0.2f};
+        std::vector<AABB> moved(count); // what the tree holds after the refit,the flat culler tests the same boxes
+        const double refitTime{milliseconds([&]{
+            for (std::uint32_t i{0}; i < bounds.size(); ++i)
+            {
+                const glm::vec3 move{offset(wobble),offset(wobble),offset(wobble)};
+                moved[i] = {bounds[i].min + move,bounds[i].max + move};
+                bvh.update(i,moved[i]);
+            }
+            bvh.refit();
+        })};
+        report("update all + refit",refitTime,bvh.nodeCount());
+
+        std::size_t visible{0};
+        const double queryTime{milliseconds([&]{ visible = 0; bvh.query(frustum,[&](std::uint32_t){ ++visible; }); },5)};
+        report("frustum query",queryTime,visible);
+
+        FrustumCuller culler{count};
+        const double flatTime{milliseconds([&]{
+            culler.clear();
+            for (const AABB& box : moved)
+                culler.add(box);
+            culler.cull(frustum);
+        },5)};
+        std::size_t flatVisible{0};
+        for (std::size_t i{0}; i < count; ++i)
+            flatVisible += culler.isVisible(i);
+        report("flat culler (SSE)",flatTime,flatVisible);
+        std::cout << "  same visible count: " << (visible == flatVisible ? "yes" : "NO") << '\n';
+
+        std::size_t touched{0};
+        const double sphereTime{milliseconds([&]{
+            touched = 0;
+            for (int i{0}; i < 1000; ++i)
+            {
+                const BoundingSphere sphere{{position(random),position(random),position(random)},5.0f};
+                bvh.query(sphere,[&](std::uint32_t){ ++touched; });
+            }
+        })};
+        report("1000 sphere queries",sphereTime,touched);
+
+        std::size_t hits{0};
+        std::uniform_real_distribution<float> direction{-1.0f,1.0f};
+        const double rayTime{milliseconds([&]{
+            hits = 0;
+            for (int i{0}; i < 1000; ++i)
+            {
+                const BVH::Ray ray{glm::vec3(0.0f),{direction(random),direction(random),direction(random)}};
+                hits += bvh.raycast(ray).has_value();
+            }
+        })};
+        report("1000 ray casts",rayTime,hits);
+        std::cout << '\n';
+        return visible == flatVisible;
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::vector<std::size_t> counts{10'000,1'000'000};
+    if (argc > 1)
+    {
+        counts.clear();
+        for (int i{1}; i < argc; ++i)
+            counts.push_back(std::strtoull(argv[i],nullptr,10));
+    }
+
+    ThreadPool pool;
+    bool passed{true};
+    for (const std::size_t count : counts)
+        passed &= run(count,pool);
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,280 @@
+#ifndef MYOPENPROJECT_BENCHMARK_H
+#define MYOPENPROJECT_BENCHMARK_H
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// The --bench run: no input,the camera follows a scripted path and the scene animates on a fixed timestep,so
+// every run draws the same frames whatever the machine. The first warmup frames aren't counted (shaders,the
+// frame graph's pool,results still in flight);the next frames ones are,then the run stops and write() puts
+// them in a JSON file: percentiles of the frame times,of every GpuProfiler section (the frame graph passes
+// and what's inside them) and of the counters fed to count().
+// The path is a text file of keyframes,one a line: time x y z yaw pitch,in seconds and degrees,'#' comments.
+// The camera is interpolated linearly between them and the path loops after the last one;without a file it
+// circles the backpack. Whatever adapts to the measured GPU time (dynamic resolution,the automatic depth
+// pre-pass) is held fixed for the run,or the frames measured would mix workloads.
+class Benchmark
+{
+public:
+    struct Settings {
+        unsigned int frames{600};
+        unsigned int warmup{60};
+        double timestep{1.0 / 60.0}; // seconds of scene time a frame
+        std::string pathFile;        // empty for the orbit
+        std::string output{"bench.json"};
+        bool depthPrepass{false};    // held on or off for the run,the automatic mode would switch it mid-run
+    };
+
+    struct Keyframe {
+        float time;
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+    };
+
+    struct Percentiles {
+        double min;
+        double average;
+        double p50;
+        double p90;
+        double p95;
+        double p99;
+        double max;
+    };
+
+    explicit Benchmark(Settings settings)
+        : settings{std::move(settings)}
+    {
+        if (!this->settings.pathFile.empty())
+            path = load(this->settings.pathFile);
+        if (path.empty())
+            path = orbit();
+    }
+
+    // seconds of scene time of the frame being drawn
+    [[nodiscard]] double time() const
+    {
+        return static_cast<double>(frame) * settings.timestep;
+    }
+
+    [[nodiscard]] bool isDone() const
+    {
+        return frame >= settings.warmup + settings.frames;
+    }
+
+    [[nodiscard]] const Settings& getSettings() const
+    {
+        return settings;
+    }
+
+    // where the path has the camera this frame
+    void place(Camera& camera) const
+    {
+        const Keyframe pose{sample(static_cast<float>(time()))};
+        camera.SetPose(pose.position,pose.yaw,pose.pitch);
+    }
+
+    // a value of this frame (objects drawn,state changes..),kept with the frame
+    void count(const std::string_view name,const double value)
+    {
+        if (isMeasured())
+            samplesOf(counters,name).push_back(value);
+    }
+
+    // after the frame's buffer swap;takes the GPU times that came back
+    void endFrame(const GpuProfiler& profiler)
+    {
+        const auto now{std::chrono::steady_clock::now()};
+        if (isMeasured())
+        {
+            frameMilliseconds.push_back(std::chrono::duration<double,std::milli>(now - lastFrameEnd).count());
+            if (profiler.frames() != profiledFrames) // the latest frame read back,a few behind this one
+            {
+                for (const GpuProfiler::Stats& section : profiler.stats())
+                {
+                    if (section.latest)
+                        samplesOf(passes,section.name).push_back(section.last);
+                }
+            }
+        }
+        profiledFrames = profiler.frames();
+        lastFrameEnd = now;
+        ++frame;
+    }
+
+    [[nodiscard]] static Percentiles percentilesOf(std::vector<double> samples)
+    {
+        if (samples.empty())
+            return {};
+        std::ranges::sort(samples);
+        double sum{0.0};
+        for (const double sample : samples)
+            sum += sample;
+        const auto at{[&](const double fraction){
+            return samples[std::min(samples.size() - 1,static_cast<std::size_t>(fraction * static_cast<double>(samples.size())))];
+        }};
+        return {samples.front(),sum / static_cast<double>(samples.size()),at(0.5),at(0.9),at(0.95),at(0.99),samples.back()};
+    }
+
+    // the results as JSON;false if the file can't be written
+    bool write(const std::string_view renderer,const unsigned int width,const unsigned int height) const
+    {
+        std::ofstream out{settings.output};
+        if (!out)
+            return false;
+        out << std::fixed << std::setprecision(4)
+            << "{\n  \"renderer\": \"" << escaped(renderer) << "\",\n"
+            << "  \"width\": " << width << ",\n  \"height\": " << height << ",\n"
+            << "  \"path\": \"" << escaped(settings.pathFile.empty() ? "orbit" : settings.pathFile) << "\",\n"
+            << "  \"timestep\": " << settings.timestep << ",\n"
+            << "  \"depthPrepass\": \"" << (settings.depthPrepass ? "on" : "off") << "\",\n"
+            << "  \"warmupFrames\": " << settings.warmup << ",\n  \"frames\": " << frameMilliseconds.size() << ",\n"
+            << "  \"frameMilliseconds\": ";
+        writePercentiles(out,percentilesOf(frameMilliseconds));
+        out << ",\n  \"gpuPassMilliseconds\": ";
+        writeGroup(out,passes);
+        out << ",\n  \"counters\": ";
+        writeGroup(out,counters);
+        out << "\n}\n";
+        return static_cast<bool>(out);
+    }
+
+    // the frame times and the whole GPU frame,for the console
+    void print(std::ostream& out) const
+    {
+        const Percentiles cpu{percentilesOf(frameMilliseconds)};
+        out << "BENCH: " << frameMilliseconds.size() << " frames,ms avg " << std::fixed << std::setprecision(3) << cpu.average
+            << "   p50 " << cpu.p50 << "   p95 " << cpu.p95 << "   p99 " << cpu.p99 << "   max " << cpu.max;
+        for (const auto& [name,samples] : passes)
+        {
+            if (name == "frame")
+                out << "   GPU avg " << percentilesOf(samples).average;
+        }
+        out << "\nBENCH: written to " << settings.output << '\n' << std::defaultfloat;
+    }
+
+private:
+    using Samples = std::vector<std::pair<std::string,std::vector<double>>>; // in the order they first came
+
+    Settings settings;
+    std::vector<Keyframe> path;
+    unsigned int frame{0};
+    std::vector<double> frameMilliseconds;
+    Samples passes;
+    Samples counters;
+    std::uint64_t profiledFrames{0};
+    std::chrono::steady_clock::time_point lastFrameEnd{std::chrono::steady_clock::now()};
+
+    [[nodiscard]] bool isMeasured() const
+    {
+        return frame >= settings.warmup && !isDone();
+    }
+
+    [[nodiscard]] static std::vector<double>& samplesOf(Samples& group,const std::string_view name)
+    {
+        for (auto& [groupName,samples] : group)
+        {
+            if (groupName == name)
+                return samples;
+        }
+        group.emplace_back(std::string{name},std::vector<double>{});
+        return group.back().second;
+    }
+
+    [[nodiscard]] Keyframe sample(float at) const
+    {
+        if (path.size() == 1 || path.back().time <= 0.0f)
+            return path.front();
+        at = std::fmod(at,path.back().time);
+        const auto next{std::ranges::upper_bound(path,at,{},&Keyframe::time)};
+        if (next == path.begin())
+            return path.front();
+        if (next == path.end())
+            return path.back();
+        const Keyframe& a{*(next - 1)};
+        const Keyframe& b{*next};
+        const float t{(at - a.time) / std::max(b.time - a.time,1e-6f)};
+        return {at,glm::mix(a.position,b.position,t),a.yaw + (b.yaw - a.yaw) * t,a.pitch + (b.pitch - a.pitch) * t};
+    }
+
+    [[nodiscard]] static std::vector<Keyframe> load(const std::string& file)
+    {
+        std::ifstream in{file};
+        std::vector<Keyframe> keyframes;
+        std::string line;
+        while (std::getline(in,line))
+        {
+            line = line.substr(0,line.find('#'));
+            std::istringstream fields{line};
+            Keyframe keyframe{};
+            if (fields >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >> keyframe.yaw >> keyframe.pitch)
+                keyframes.push_back(keyframe);
+        }
+        std::ranges::stable_sort(keyframes,{},&Keyframe::time);
+        if (keyframes.empty())
+            std::cout << "BENCH: no keyframes in " << file << ",circling the backpack instead\n";
+        return keyframes;
+    }
+
+    // once around the backpack in 16 seconds,looking at it
+    [[nodiscard]] static std::vector<Keyframe> orbit()
+    {
+        constexpr unsigned int steps{16};
+        constexpr float radius{7.0f};
+        std::vector<Keyframe> keyframes;
+        for (unsigned int i{0}; i <= steps; ++i)
+        {
+            const float angle{6.2831853f * static_cast<float>(i) / static_cast<float>(steps)};
+            keyframes.push_back({static_cast<float>(i),glm::vec3(std::cos(angle) * radius,1.5f,std::sin(angle) * radius),
+                                 glm::degrees(angle) + 180.0f,-10.0f});
+        }
+        return keyframes;
+    }
+
+    static void writePercentiles(std::ostream& out,const Percentiles& p)
+    {
+        out << "{\"min\": " << p.min << ", \"avg\": " << p.average << ", \"p50\": " << p.p50 << ", \"p90\": " << p.p90
+            << ", \"p95\": " << p.p95 << ", \"p99\": " << p.p99 << ", \"max\": " << p.max << '}';
+    }
+
+    static void writeGroup(std::ostream& out,const Samples& group)
+    {
+        out << '{';
+        for (std::size_t i{0}; i < group.size(); ++i)
+        {
+            out << (i ? ",\n    \"" : "\n    \"") << escaped(group[i].first) << "\": ";
+            writePercentiles(out,percentilesOf(group[i].second));
+        }
+        out << (group.empty() ? "}" : "\n  }");
+    }
+
+    [[nodiscard]] static std::string escaped(const std::string_view text)
+    {
+        std::string result;
+        for (const char c : text)
+        {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result;
+    }
+};
+
+#endif //MYOPENPROJECT_BENCHMARK_H
@@ -0,0 +1,79 @@
+#ifndef MYOPENPROJECT_BOUNDS_H
+#define MYOPENPROJECT_BOUNDS_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Bounding volumes for culling. Meshes get both in model space when they are loaded
+// (Model::processMesh);callers move them into world space with the transform they draw with.
+
+struct AABB {
+    glm::vec3 min{std::numeric_limits<float>::max()}; // starts out empty,expand() grows it
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    void expand(const glm::vec3& point)
+    {
+        min = glm::min(min,point);
+        max = glm::max(max,point);
+    }
+
+    void expand(const AABB& other)
+    {
+        min = glm::min(min,other.min);
+        max = glm::max(max,other.max);
+    }
+
+    [[nodiscard]] bool isEmpty() const
+    {
+        return min.x > max.x;
+    }
+
+    [[nodiscard]] glm::vec3 center() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    [[nodiscard]] glm::vec3 extents() const // half the size on every axis
+    {
+        return (max - min) * 0.5f;
+    }
+
+    // the box around the transformed box;transforms the center and sums the absolute
+    // columns for the extents instead of transforming all eight corners
+    [[nodiscard]] AABB transformed(const glm::mat4& transform) const
+    {
+        const glm::vec3 c{transform * glm::vec4(center(),1.0f)};
+        const glm::vec3 e{extents()};
+        const glm::vec3 worldExtents{glm::abs(glm::vec3(transform[0])) * e.x
+                                   + glm::abs(glm::vec3(transform[1])) * e.y
+                                   + glm::abs(glm::vec3(transform[2])) * e.z};
+        return {c - worldExtents,c + worldExtents};
+    }
+};
+
+struct BoundingSphere {
+    glm::vec3 center{};
+    float radius{};
+
+    // the radius grows by the largest scale of the transform,so non uniform scales stay conservative
+    [[nodiscard]] BoundingSphere transformed(const glm::mat4& transform) const
+    {
+        const float scale{std::max({glm::length(glm::vec3(transform[0])),
+                                    glm::length(glm::vec3(transform[1])),
+                                    glm::length(glm::vec3(transform[2]))})};
+        return {glm::vec3(transform * glm::vec4(center,1.0f)),radius * scale};
+    }
+
+    // the closest point of the box is inside the sphere
+    [[nodiscard]] bool intersects(const AABB& box) const
+    {
+        const glm::vec3 closest{glm::clamp(center,box.min,box.max)};
+        const glm::vec3 offset{closest - center};
+        return glm::dot(offset,offset) <= radius * radius;
+    }
+};
+
+#endif //MYOPENPROJECT_BOUNDS_H
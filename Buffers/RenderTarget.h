@@ -0,0 +1,154 @@
+#ifndef MYOPENPROJECT_RENDERTARGET_H
+#define MYOPENPROJECT_RENDERTARGET_H
+
+#include <glad/glad.h>
+
+#include <initializer_list>
+#include <iostream>
+#include <vector>
+
+// A framebuffer with any number of color textures,for the passes Framebuffer's fixed types don't cover
+// (several outputs,float formats). The textures are multisampled when samples isn't 0.
+// The depth can come from another framebuffer's renderbuffer,so a pass can test against the depth of
+// the scene without copying it (the sample counts have to match),or be a texture of its own that later passes sample.
+class RenderTarget
+{
+public:
+    struct ColorFormat {
+        GLenum internalFormat;
+        GLenum format;
+        GLenum type;
+    };
+
+    RenderTarget(const unsigned int width,const unsigned int height,std::initializer_list<ColorFormat> colorFormats,const int samples = 0)
+        : width{width},height{height},samples{samples}
+    {
+        glGenFramebuffers(1,&FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER,FBO);
+
+        const GLenum target{getTextureTarget()};
+        for (const ColorFormat& color : colorFormats)
+        {
+            unsigned int texture{};
+            glGenTextures(1,&texture);
+            glBindTexture(target,texture);
+            if (samples)
+            {
+                glTexImage2DMultisample(target,samples,color.internalFormat,static_cast<int>(width),static_cast<int>(height),GL_TRUE);
+            }
+            else
+            {
+                glTexImage2D(target,0,static_cast<int>(color.internalFormat),static_cast<int>(width),static_cast<int>(height),0,color.format,color.type,nullptr);
+                glTexParameteri(target,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+                glTexParameteri(target,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+                glTexParameteri(target,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+                glTexParameteri(target,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+            }
+            const auto attachment{static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + textures.size())};
+            glFramebufferTexture2D(GL_FRAMEBUFFER,attachment,target,texture,0);
+            textures.push_back(texture);
+            drawBuffers.push_back(attachment);
+        }
+        glBindTexture(target,0);
+        glDrawBuffers(static_cast<int>(drawBuffers.size()),drawBuffers.data());
+
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+    }
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    ~RenderTarget()
+    {
+        glDeleteTextures(static_cast<int>(textures.size()),textures.data());
+        if (depthTexture)
+            glDeleteTextures(1,&depthTexture);
+        glDeleteFramebuffers(1,&FBO);
+    }
+
+    // shares the depth (and stencil,if it has one) renderbuffer of another framebuffer
+    void attachDepthRenderbuffer(const unsigned int renderbuffer)
+    {
+        int stencilBits{0};
+        glBindRenderbuffer(GL_RENDERBUFFER,renderbuffer);
+        glGetRenderbufferParameteriv(GL_RENDERBUFFER,GL_RENDERBUFFER_STENCIL_SIZE,&stencilBits);
+        glBindRenderbuffer(GL_RENDERBUFFER,0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER,FBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER,stencilBits ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,GL_RENDERBUFFER,renderbuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+    }
+
+    // a depth texture of its own,for passes that read the depth back (deferred lighting);not for multisampled targets
+    void attachDepthTexture(const GLenum internalFormat = GL_DEPTH_COMPONENT32F)
+    {
+        glGenTextures(1,&depthTexture);
+        glBindTexture(GL_TEXTURE_2D,depthTexture);
+        glTexImage2D(GL_TEXTURE_2D,0,static_cast<int>(internalFormat),static_cast<int>(width),static_cast<int>(height),0,GL_DEPTH_COMPONENT,GL_FLOAT,nullptr);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D,0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER,FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,GL_TEXTURE_2D,depthTexture,0);
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+    }
+
+    [[nodiscard]] bool isComplete() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER,FBO);
+        const GLenum status{glCheckFramebufferStatus(GL_FRAMEBUFFER)};
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::RENDERTARGET:: Framebuffer is not complete: 0x" << std::hex << status << std::dec << std::endl;
+        return status == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    [[nodiscard]] unsigned int getFrameBufferID() const
+    {
+        return FBO;
+    }
+
+    [[nodiscard]] unsigned int getTextureID(const std::size_t attachment) const
+    {
+        return textures[attachment];
+    }
+
+    [[nodiscard]] unsigned int getDepthTextureID() const // 0 without attachDepthTexture
+    {
+        return depthTexture;
+    }
+
+    [[nodiscard]] GLenum getTextureTarget() const
+    {
+        return samples ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+    }
+
+    [[nodiscard]] int getSamples() const
+    {
+        return samples;
+    }
+
+    [[nodiscard]] unsigned int getWidth() const
+    {
+        return width;
+    }
+
+    [[nodiscard]] unsigned int getHeight() const
+    {
+        return height;
+    }
+
+private:
+    unsigned int FBO{};
+    unsigned int depthTexture{};
+    unsigned int width;
+    unsigned int height;
+    int samples;
+    std::vector<unsigned int> textures;
+    std::vector<GLenum> drawBuffers;
+};
+
+#endif //MYOPENPROJECT_RENDERTARGET_H
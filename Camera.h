@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "Frustum.h"
+
 // Defines several possible options for camera movement. Used as abstraction to stay away from window-system specific input methods
 enum Camera_Movement {
     FORWARD,
@@ -69,6 +71,11 @@ public:
     {
         return glm::lookAt(Position, Position + Front, Up);
     }
+    // the clip planes of what the camera sees with the given projection,in world space
+    [[nodiscard]] Frustum GetFrustum(const glm::mat4& projection) const
+    {
+        return Frustum{projection * GetViewMatrix()};
+    }
     // processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
     void ProcessKeyboard(Camera_Movement direction, float deltaTime)
     {
@@ -108,6 +115,15 @@ public:
         updateCameraVectors();
     }
 
+    // puts the camera somewhere without any input,for scripted paths
+    void SetPose(glm::vec3 position, float yaw, float pitch)
+    {
+        Position = position;
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
 private:
     // calculates the front vector from the Camera's (updated) Euler Angles
     void updateCameraVectors()
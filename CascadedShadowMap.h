@@ -0,0 +1,366 @@
+#ifndef MYOPENPROJECT_CASCADEDSHADOWMAP_H
+#define MYOPENPROJECT_CASCADEDSHADOWMAP_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Bounds.h"
+#include "Frustum.h"
+#include "Shader.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <span>
+
+// Cascaded shadow maps for the directional light. update() fits the cascades to the camera:
+//   - the depth range they cover is the part of the view the shadow receivers are in,cut with the practical
+//     split scheme (splitLambda between uniform and logarithmic splits),
+//   - each cascade is the box around the bounding sphere of its slice of the view frustum,whose size doesn't
+//     change when the camera turns,or of the part of the slice the receivers' box fills when that is smaller,
+//     and its position is snapped to whole shadow map texels,so the shadow edges don't shimmer as the camera moves.
+// The cascades are the layers of one depth texture array (depthshader.vs/.fs,a depth-only framebuffer like
+// Framebuffer::Type::DEPTH). Static casters are drawn into a second array that is cached: a cascade covers
+// cachedCoverage times its slice,and is only drawn again once the slice leaves it,once it is too big for the
+// slice (zooming in),once the light turns by more than lightTolerance or after invalidate(). Every frame the
+// cached layers are copied into the sampled array and the dynamic casters drawn on top,but only for the
+// cascades they are in (or were in last frame).
+// Casters are drawn with depth clamping,so those between the light and a cascade still cast into it.
+// shader.fs samples the array with hardware 2x2 comparisons (sampler2DArrayShadow),3x3 of them per fragment.
+class CascadedShadowMap
+{
+public:
+    static constexpr unsigned int cascadeCount{4};
+    static constexpr unsigned int shadowMapUnit{14};
+    static constexpr float splitLambda{0.75f};
+    static constexpr float cachedCoverage{1.25f};
+    static constexpr float maxCoverage{2.0f};        // a cached cascade this many times bigger than its slice is drawn again
+    static constexpr float lightTolerance{0.99999f}; // cosine of the angle the light may turn without redrawing,about 0.25 degrees
+    static constexpr float slopeBias{2.0f};          // glPolygonOffset of the casters
+    static constexpr float constantBias{4.0f};
+
+    inline static bool enabled{true};
+
+    // what update() needs of the camera
+    struct View {
+        glm::mat4 view;
+        float fovY; // radians
+        float aspect;
+        float near;
+        float far;
+    };
+
+    explicit CascadedShadowMap(const unsigned int resolution)
+        : resolution{resolution},staticDepth{createArray(false)},depth{createArray(true)}
+    {
+        glGenFramebuffers(1,&drawFBO);
+        glGenFramebuffers(1,&readFBO);
+        for (const unsigned int FBO : {drawFBO,readFBO})
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER,FBO);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,FBO == drawFBO ? depth : staticDepth,0,0);
+            glDrawBuffer(GL_NONE); // depth only
+            glReadBuffer(GL_NONE);
+            const GLenum status{glCheckFramebufferStatus(GL_FRAMEBUFFER)};
+            if (status != GL_FRAMEBUFFER_COMPLETE)
+            {
+                std::cout << "ERROR::CASCADEDSHADOWMAP:: Framebuffer is not complete: 0x" << std::hex << status << std::dec << std::endl;
+                supported = false;
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+    }
+
+    CascadedShadowMap(const CascadedShadowMap&) = delete;
+    CascadedShadowMap& operator=(const CascadedShadowMap&) = delete;
+
+    ~CascadedShadowMap()
+    {
+        glDeleteFramebuffers(1,&drawFBO);
+        glDeleteFramebuffers(1,&readFBO);
+        glDeleteTextures(1,&staticDepth);
+        glDeleteTextures(1,&depth);
+    }
+
+    [[nodiscard]] bool isSupported() const
+    {
+        return supported;
+    }
+
+    // the static casters changed,every cascade is drawn again
+    void invalidate()
+    {
+        for (Cascade& cascade : cascades)
+            cascade.cached = false;
+    }
+
+    // fits the cascades to the view of the receivers and finds which cached ones are stale and which
+    // ones the dynamic casters are in;lightDirection is the direction the light travels,like dirLight.direction
+    void update(const View& camera,const AABB& receivers,const glm::vec3& lightDirection,std::span<const AABB> dynamicCasters)
+    {
+        active = false;
+        if (!enabled || !supported)
+            return;
+
+        const glm::vec3 direction{glm::normalize(lightDirection)};
+        if (glm::dot(direction,lightDirectionCached) < lightTolerance)
+        {
+            lightDirectionCached = direction;
+            const glm::vec3 up{std::abs(direction.y) > 0.99f ? glm::vec3(0.0f,0.0f,1.0f) : glm::vec3(0.0f,1.0f,0.0f)};
+            lightView = glm::lookAt(glm::vec3(0.0f),direction,up);
+            invalidate();
+        }
+
+        // the view depths the receivers are in
+        float first{std::numeric_limits<float>::max()};
+        float last{std::numeric_limits<float>::lowest()};
+        for (int corner{0}; corner < 8; ++corner)
+        {
+            const glm::vec3 point{corner & 1 ? receivers.max.x : receivers.min.x,corner & 2 ? receivers.max.y : receivers.min.y,corner & 4 ? receivers.max.z : receivers.min.z};
+            const float pointDepth{-(camera.view * glm::vec4(point,1.0f)).z};
+            first = std::min(first,pointDepth);
+            last = std::max(last,pointDepth);
+        }
+        if (receivers.isEmpty() || last <= camera.near || first >= camera.far)
+            return;
+        first = std::max(first,camera.near);
+        last = std::min(last,camera.far);
+
+        const glm::mat4 inverseView{glm::inverse(camera.view)};
+        const float tanHalfFov{std::tan(camera.fovY * 0.5f)};
+        staticRedraws = 0;
+        float sliceNear{first};
+        for (unsigned int i{0}; i < cascadeCount; ++i)
+        {
+            const float fraction{static_cast<float>(i + 1) / static_cast<float>(cascadeCount)};
+            const float logarithmic{first * std::pow(last / first,fraction)};
+            const float uniform{first + (last - first) * fraction};
+            const float sliceFar{splitLambda * logarithmic + (1.0f - splitLambda) * uniform};
+
+            // the sphere around the eight corners of the slice,centered on their average
+            std::array<glm::vec3,8> corners{};
+            glm::vec3 center{0.0f};
+            for (int corner{0}; corner < 8; ++corner)
+            {
+                const float cornerDepth{corner & 4 ? sliceFar : sliceNear};
+                const float y{cornerDepth * tanHalfFov};
+                const glm::vec4 viewPoint{(corner & 1 ? y : -y) * camera.aspect,corner & 2 ? y : -y,-cornerDepth,1.0f};
+                corners[static_cast<std::size_t>(corner)] = glm::vec3(inverseView * viewPoint);
+                center += corners[static_cast<std::size_t>(corner)] / 8.0f;
+            }
+            float radius{0.0f};
+            AABB slice;
+            for (const glm::vec3& corner : corners)
+            {
+                radius = std::max(radius,glm::distance(corner,center));
+                slice.expand(corner);
+            }
+            // when the receivers only fill part of the slice,the sphere around that part
+            const AABB filled{glm::max(slice.min,receivers.min),glm::min(slice.max,receivers.max)};
+            if (!filled.isEmpty() && glm::length(filled.extents()) < radius)
+            {
+                center = filled.center();
+                radius = glm::length(filled.extents());
+            }
+            radius = std::ceil(radius * 16.0f) / 16.0f; // rounding errors don't change its size
+
+            Cascade& cascade{cascades[i]};
+            const glm::vec3 lightCenter{lightView * glm::vec4(center,1.0f)};
+            if (!cascade.cached || !covers(cascade,lightCenter,radius) || cascade.radius > radius * maxCoverage)
+            {
+                place(cascade,lightCenter,radius * cachedCoverage);
+                cascade.cached = true;
+                cascade.staticStale = true;
+                ++staticRedraws;
+            }
+            cascade.splitFar = sliceFar;
+
+            const Frustum casters{casterFrustum(cascade)};
+            cascade.dynamic = std::ranges::any_of(dynamicCasters,[&](const AABB& bounds){ return casters.intersects(bounds); });
+            sliceNear = sliceFar;
+        }
+        active = true;
+    }
+
+    // draws the stale cascades;drawStatic and drawDynamic are called with the cascade's frustum,without near
+    // plane,and draw the casters with shader() (the "transform" uniform and instances like shader.vs)
+    template<typename DrawStatic,typename DrawDynamic>
+    void render(DrawStatic&& drawStatic,DrawDynamic&& drawDynamic)
+    {
+        if (!active)
+            return;
+
+        depthShader.use();
+        glViewport(0,0,static_cast<int>(resolution),static_cast<int>(resolution));
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_DEPTH_CLAMP);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(slopeBias,constantBias);
+
+        for (unsigned int i{0}; i < cascadeCount; ++i)
+        {
+            Cascade& cascade{cascades[i]};
+            const auto layer{static_cast<int>(i)};
+            depthShader.setMat4("lightMatrix",cascade.matrix);
+
+            if (cascade.staticStale)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER,drawFBO);
+                glFramebufferTextureLayer(GL_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,staticDepth,0,layer);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                drawStatic(casterFrustum(cascade));
+            }
+            if (!cascade.staticStale && !cascade.dynamic && !cascade.hadDynamic)
+                continue; // the sampled layer already holds the cached one
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER,readFBO);
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,staticDepth,0,layer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER,drawFBO);
+            glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,depth,0,layer);
+            const auto size{static_cast<int>(resolution)};
+            glBlitFramebuffer(0,0,size,size,0,0,size,size,GL_DEPTH_BUFFER_BIT,GL_NEAREST);
+
+            if (cascade.dynamic)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER,drawFBO);
+                drawDynamic(casterFrustum(cascade));
+            }
+            cascade.staticStale = false;
+            cascade.hadDynamic = cascade.dynamic;
+        }
+
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glDisable(GL_DEPTH_CLAMP);
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+    }
+
+    // the program the casters are drawn with
+    [[nodiscard]] const Shader& shader() const
+    {
+        return depthShader;
+    }
+
+    // the uniforms of the shadow lookup in shader.fs and deferreddirectional.fs;binds the array to shadowMapUnit
+    void bind(const Shader& shader) const
+    {
+        glActiveTexture(GL_TEXTURE0 + shadowMapUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY,depth);
+        glActiveTexture(GL_TEXTURE0);
+
+        shader.use();
+        shader.setInt("shadowMap",static_cast<int>(shadowMapUnit));
+        shader.setBool("shadows",active);
+        if (!active)
+            return;
+
+        std::array<glm::mat4,cascadeCount> matrices{};
+        glm::vec4 splits{};
+        glm::vec4 texelSizes{};
+        for (unsigned int i{0}; i < cascadeCount; ++i)
+        {
+            matrices[i] = cascades[i].matrix;
+            splits[static_cast<int>(i)] = cascades[i].splitFar;
+            texelSizes[static_cast<int>(i)] = 2.0f * cascades[i].radius / static_cast<float>(resolution);
+        }
+        const unsigned int program{shader.getProgramID()};
+        glUniformMatrix4fv(glGetUniformLocation(program,"cascadeMatrices"),static_cast<int>(cascadeCount),GL_FALSE,glm::value_ptr(matrices[0]));
+        glUniform4fv(glGetUniformLocation(program,"cascadeSplits"),1,glm::value_ptr(splits));
+        glUniform4fv(glGetUniformLocation(program,"cascadeTexelSizes"),1,glm::value_ptr(texelSizes));
+    }
+
+    [[nodiscard]] bool isActive() const
+    {
+        return active;
+    }
+
+    [[nodiscard]] unsigned int getTextureID() const // the cascades,what bind() binds
+    {
+        return depth;
+    }
+
+    [[nodiscard]] unsigned int staticRedrawsThisFrame() const
+    {
+        return staticRedraws;
+    }
+
+private:
+    struct Cascade {
+        glm::mat4 matrix{1.0f}; // world to the cascade's clip space
+        glm::vec3 center{0.0f}; // light space
+        float radius{0.0f};     // half the size of the box
+        float splitFar{0.0f};   // view depth where the next cascade starts
+        bool cached{false};
+        bool staticStale{false};
+        bool dynamic{false};
+        bool hadDynamic{false};
+    };
+
+    Shader depthShader{"depthshader.vs","depthshader.fs"};
+    unsigned int resolution;
+    unsigned int staticDepth{};
+    unsigned int depth{};
+    unsigned int drawFBO{};
+    unsigned int readFBO{};
+    bool supported{true};
+    bool active{false};
+
+    std::array<Cascade,cascadeCount> cascades{};
+    glm::vec3 lightDirectionCached{0.0f};
+    glm::mat4 lightView{1.0f};
+    unsigned int staticRedraws{0};
+
+    [[nodiscard]] unsigned int createArray(const bool comparison) const
+    {
+        unsigned int texture{};
+        glGenTextures(1,&texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY,texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY,0,GL_DEPTH_COMPONENT32F,static_cast<int>(resolution),static_cast<int>(resolution),static_cast<int>(cascadeCount),0,GL_DEPTH_COMPONENT,GL_FLOAT,nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_MIN_FILTER,comparison ? GL_LINEAR : GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_MAG_FILTER,comparison ? GL_LINEAR : GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_BORDER);
+        const glm::vec4 border{1.0f}; // outside the cascade nothing casts
+        glTexParameterfv(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_BORDER_COLOR,glm::value_ptr(border));
+        if (comparison)
+        {
+            glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_COMPARE_MODE,GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_COMPARE_FUNC,GL_LEQUAL);
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY,0);
+        return texture;
+    }
+
+    // whether the cached box still holds the sphere
+    [[nodiscard]] static bool covers(const Cascade& cascade,const glm::vec3& center,const float radius)
+    {
+        const glm::vec3 offset{glm::abs(center - cascade.center)};
+        return std::max({offset.x,offset.y,offset.z}) + radius <= cascade.radius;
+    }
+
+    // a box of the given half size around center,snapped to the texels it will have
+    void place(Cascade& cascade,const glm::vec3& center,const float radius) const
+    {
+        const float texel{2.0f * radius / static_cast<float>(resolution)};
+        cascade.center = glm::floor(center / texel) * texel;
+        cascade.radius = radius;
+        const glm::vec3& c{cascade.center};
+        // the light looks down -z,so the near and far planes are at -z
+        const glm::mat4 projection{glm::ortho(c.x - radius,c.x + radius,c.y - radius,c.y + radius,-(c.z + radius),-(c.z - radius))};
+        cascade.matrix = projection * lightView;
+    }
+
+    // the casters of a cascade;no near plane,depth clamping keeps those between the light and the box
+    [[nodiscard]] static Frustum casterFrustum(const Cascade& cascade)
+    {
+        Frustum frustum{cascade.matrix};
+        frustum.planes[Frustum::nearPlane] = glm::vec4(0.0f,0.0f,0.0f,1.0f);
+        return frustum;
+    }
+};
+
+#endif //MYOPENPROJECT_CASCADEDSHADOWMAP_H
@@ -0,0 +1,388 @@
+#ifndef MYOPENPROJECT_CLUSTEREDLIGHTS_H
+#define MYOPENPROJECT_CLUSTEREDLIGHTS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define CLUSTEREDLIGHTS_SSE 1
+#endif
+
+// Clustered forward shading. The view frustum is cut into clusterX * clusterY screen tiles and clusterZ
+// depth slices (exponential,so near slices stay thin),and every frame each point light is added to the
+// clusters its range sphere touches:
+//   - the light's depth range picks the slices and its projected view-space box picks the tiles,
+//   - the sphere is then tested against the view-space box of every candidate cluster,four clusters at a time with SSE,
+//   - a counting sort turns the (cluster,light) pairs into one index list per cluster.
+// Two buffer textures carry it to shader.fs (GL 3.3,no storage buffers needed):
+//   clusterLights  (RGBA32F): four texels per light,see PointLight
+//   clusterIndices (R32UI):   one entry per cluster,offset << 8 | count,followed by the light indices
+// so the fragment shader only walks the lights of its own cluster. A cluster keeps its first maxLightsPerCluster
+// lights;the rest are dropped,counted by droppedAssignments() and reported once.
+class ClusteredLights
+{
+public:
+    // same terms as the PointLight struct of shader.fs;range is filled in by update()
+    struct PointLight {
+        glm::vec3 position{0.0f};
+        float range{};
+        glm::vec3 diffuse{1.0f};
+        float constant{1.0f};
+        glm::vec3 specular{1.0f};
+        float linear{0.09f};
+        glm::vec3 ambient{0.0f};
+        float quadratic{0.032f};
+    };
+
+    static constexpr unsigned int clusterX{16};
+    static constexpr unsigned int clusterY{9};
+    static constexpr unsigned int clusterZ{24};
+    static constexpr unsigned int clusterCount{clusterX * clusterY * clusterZ};
+    static constexpr unsigned int maxLightsPerCluster{255};  // the count has 8 bits
+    static constexpr unsigned int lightsUnit{12};             // texture units after the material arrays
+    static constexpr unsigned int indicesUnit{13};
+    static constexpr float cutoff{5.0f / 256.0f};             // a light ends where it adds less than this
+
+    ClusteredLights(const unsigned int width,const unsigned int height,const float nearPlane,const float farPlane)
+        : width{width},height{height},nearPlane{nearPlane},farPlane{farPlane},
+          tileWidth{(width + clusterX - 1) / clusterX},tileHeight{(height + clusterY - 1) / clusterY}
+    {
+        glGenBuffers(1,&lightBuffer);
+        glGenBuffers(1,&indexBuffer);
+        glGenTextures(1,&lightTexture);
+        glGenTextures(1,&indexTexture);
+        upload();
+    }
+
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+    ~ClusteredLights()
+    {
+        glDeleteTextures(1,&lightTexture);
+        glDeleteTextures(1,&indexTexture);
+        glDeleteBuffers(1,&lightBuffer);
+        glDeleteBuffers(1,&indexBuffer);
+    }
+
+    // distance at which the strongest channel of the light falls under cutoff
+    [[nodiscard]] static float rangeOf(const PointLight& light)
+    {
+        const float strongest{std::max({light.diffuse.x,light.diffuse.y,light.diffuse.z,
+                                        light.specular.x,light.specular.y,light.specular.z,
+                                        light.ambient.x,light.ambient.y,light.ambient.z})};
+        const float c{light.constant - strongest / cutoff};
+        if (light.quadratic > 0.0f)
+            return (-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic);
+        if (light.linear > 0.0f)
+            return -c / light.linear;
+        return std::numeric_limits<float>::max();
+    }
+
+    // the size of what is rendered,when it isn't the one the clusters were made for (DynamicResolution);
+    // the tiles are cut from it,so it comes before update()
+    void setViewport(const unsigned int viewportWidth,const unsigned int viewportHeight)
+    {
+        if (viewportWidth == width && viewportHeight == height)
+            return;
+        width = viewportWidth;
+        height = viewportHeight;
+        tileWidth = (width + clusterX - 1) / clusterX;
+        tileHeight = (height + clusterY - 1) / clusterY;
+        clusterProjection = glm::mat4{0.0f}; // the bounds are rebuilt by the next update()
+    }
+
+    // assigns the lights to the clusters of this view and uploads the result
+    void update(const glm::mat4& view,const glm::mat4& projection,std::span<const PointLight> sceneLights)
+    {
+        if (projection != clusterProjection)
+            buildClusterBounds(projection);
+
+        lights.assign(sceneLights.begin(),sceneLights.end());
+        pairs.clear();
+        for (std::uint32_t i{0}; i < lights.size(); ++i)
+        {
+            lights[i].range = rangeOf(lights[i]);
+            assign(i,glm::vec3(view * glm::vec4(lights[i].position,1.0f)),lights[i].range);
+        }
+        buildIndexList();
+        upload();
+    }
+
+    // binds the buffers and points the cluster uniforms of shader at them
+    void bind(const Shader& shader) const
+    {
+        glActiveTexture(GL_TEXTURE0 + lightsUnit);
+        glBindTexture(GL_TEXTURE_BUFFER,lightTexture);
+        glActiveTexture(GL_TEXTURE0 + indicesUnit);
+        glBindTexture(GL_TEXTURE_BUFFER,indexTexture);
+        glActiveTexture(GL_TEXTURE0);
+
+        shader.use();
+        shader.setInt("clusterLights",static_cast<int>(lightsUnit));
+        shader.setInt("clusterIndices",static_cast<int>(indicesUnit));
+        const unsigned int program{shader.getProgramID()};
+        glUniform3ui(glGetUniformLocation(program,"clusterGrid"),clusterX,clusterY,clusterZ);
+        glUniform2ui(glGetUniformLocation(program,"clusterTileSize"),tileWidth,tileHeight);
+        const float logDepthRange{std::log(farPlane / nearPlane)};
+        shader.setFloat("clusterDepthScale",static_cast<float>(clusterZ) / logDepthRange);
+        shader.setFloat("clusterDepthBias",static_cast<float>(clusterZ) * std::log(nearPlane) / logDepthRange);
+    }
+
+    [[nodiscard]] std::size_t lightCount() const
+    {
+        return lights.size();
+    }
+
+    [[nodiscard]] std::size_t assignments() const // light indices over every cluster,after the per cluster cap
+    {
+        return indices.size() - clusterCount;
+    }
+
+    [[nodiscard]] std::size_t droppedAssignments() const // of the last update,over the per cluster cap
+    {
+        return dropped;
+    }
+
+private:
+    unsigned int width;
+    unsigned int height;
+    float nearPlane;
+    float farPlane;
+    unsigned int tileWidth;
+    unsigned int tileHeight;
+
+    unsigned int lightBuffer{};
+    unsigned int indexBuffer{};
+    unsigned int lightTexture{};
+    unsigned int indexTexture{};
+
+    glm::mat4 clusterProjection{0.0f};
+    // view-space boxes of the clusters,x fastest,then y,then the slice;padded so the SIMD loop can read past the last one
+    std::vector<float> minX,minY,minZ,maxX,maxY,maxZ;
+    std::array<float,clusterZ + 1> sliceDepths{};
+    float xScale{1.0f};  // projection[0][0] and [1][1],view x/depth -> ndc
+    float yScale{1.0f};
+
+    std::vector<PointLight> lights;
+    std::vector<std::pair<std::uint32_t,std::uint32_t>> pairs;   // (cluster,light)
+    std::vector<std::uint32_t> counts;
+    std::vector<std::uint32_t> indices;                          // the grid,then the light lists
+    std::size_t dropped{0};
+    bool reportedDropped{false};
+
+    [[nodiscard]] static unsigned int cluster(const unsigned int x,const unsigned int y,const unsigned int z)
+    {
+        return (z * clusterY + y) * clusterX + x;
+    }
+
+    [[nodiscard]] unsigned int sliceOf(const float depth) const
+    {
+        if (depth <= nearPlane)
+            return 0;
+        const float slice{std::log(depth / nearPlane) / std::log(farPlane / nearPlane) * static_cast<float>(clusterZ)};
+        return std::min(static_cast<unsigned int>(slice),clusterZ - 1);
+    }
+
+    void buildClusterBounds(const glm::mat4& projection)
+    {
+        clusterProjection = projection;
+        xScale = projection[0][0];
+        yScale = projection[1][1];
+        const glm::mat4 inverseProjection{glm::inverse(projection)};
+
+        for (unsigned int z{0}; z <= clusterZ; ++z)
+            sliceDepths[z] = nearPlane * std::pow(farPlane / nearPlane,static_cast<float>(z) / static_cast<float>(clusterZ));
+
+        const std::size_t padded{clusterCount + 4};
+        for (std::vector<float>* bounds : {&minX,&minY,&minZ,&maxX,&maxY,&maxZ})
+            bounds->assign(padded,0.0f);
+
+        // view-space direction through a pixel,scaled so its depth is 1
+        const auto direction = [&](const float pixelX,const float pixelY){
+            const glm::vec4 ndc{pixelX / static_cast<float>(width) * 2.0f - 1.0f,pixelY / static_cast<float>(height) * 2.0f - 1.0f,-1.0f,1.0f};
+            const glm::vec4 viewPoint{inverseProjection * ndc};
+            const glm::vec3 point{glm::vec3(viewPoint) / viewPoint.w};
+            return point / -point.z;
+        };
+
+        for (unsigned int z{0}; z < clusterZ; ++z)
+        {
+            for (unsigned int y{0}; y < clusterY; ++y)
+            {
+                for (unsigned int x{0}; x < clusterX; ++x)
+                {
+                    const auto left{static_cast<float>(x * tileWidth)};
+                    const auto right{static_cast<float>(std::min((x + 1) * tileWidth,width))};
+                    const auto bottom{static_cast<float>(y * tileHeight)};
+                    const auto top{static_cast<float>(std::min((y + 1) * tileHeight,height))};
+                    const std::array<glm::vec3,4> corners{direction(left,bottom),direction(right,bottom),direction(left,top),direction(right,top)};
+
+                    glm::vec3 low{std::numeric_limits<float>::max()};
+                    glm::vec3 high{std::numeric_limits<float>::lowest()};
+                    for (const float depth : {sliceDepths[z],sliceDepths[z + 1]})
+                    {
+                        for (const glm::vec3& corner : corners)
+                        {
+                            low = glm::min(low,corner * depth);
+                            high = glm::max(high,corner * depth);
+                        }
+                    }
+                    const unsigned int index{cluster(x,y,z)};
+                    minX[index] = low.x;  minY[index] = low.y;  minZ[index] = low.z;
+                    maxX[index] = high.x; maxY[index] = high.y; maxZ[index] = high.z;
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] static unsigned int tileOf(const float ndc,const unsigned int tiles,const unsigned int tileSize,const unsigned int pixels)
+    {
+        const float pixel{(std::clamp(ndc,-1.0f,1.0f) * 0.5f + 0.5f) * static_cast<float>(pixels)};
+        return std::min(static_cast<unsigned int>(pixel) / tileSize,tiles - 1);
+    }
+
+    void assign(const std::uint32_t light,const glm::vec3& center,const float radius)
+    {
+        const float depth{-center.z};
+        if (depth + radius < nearPlane || depth - radius > farPlane)
+            return;
+
+        const unsigned int firstSlice{sliceOf(depth - radius)};
+        const unsigned int lastSlice{sliceOf(depth + radius)};
+
+        // tiles under the projected view-space box of the sphere;x/depth is monotonic in depth,so the box corners bound it
+        unsigned int firstX{0},lastX{clusterX - 1},firstY{0},lastY{clusterY - 1};
+        if (const float closest{depth - radius}; closest > nearPlane)
+        {
+            const float farthest{depth + radius};
+            const float left{std::min((center.x - radius) / closest,(center.x - radius) / farthest) * xScale};
+            const float right{std::max((center.x + radius) / closest,(center.x + radius) / farthest) * xScale};
+            const float bottom{std::min((center.y - radius) / closest,(center.y - radius) / farthest) * yScale};
+            const float top{std::max((center.y + radius) / closest,(center.y + radius) / farthest) * yScale};
+            if (left > 1.0f || right < -1.0f || bottom > 1.0f || top < -1.0f)
+                return;
+            firstX = tileOf(left,clusterX,tileWidth,width);
+            lastX = tileOf(right,clusterX,tileWidth,width);
+            firstY = tileOf(bottom,clusterY,tileHeight,height);
+            lastY = tileOf(top,clusterY,tileHeight,height);
+        }
+
+        const float radiusSquared{radius * radius};
+        for (unsigned int z{firstSlice}; z <= lastSlice; ++z)
+        {
+            for (unsigned int y{firstY}; y <= lastY; ++y)
+                testRow(light,center,radiusSquared,cluster(firstX,y,z),lastX - firstX + 1);
+        }
+    }
+
+    // sphere against count consecutive clusters of one row
+    void testRow(const std::uint32_t light,const glm::vec3& center,const float radiusSquared,const unsigned int first,const unsigned int count)
+    {
+#ifdef CLUSTEREDLIGHTS_SSE
+        const __m128 cx{_mm_set1_ps(center.x)};
+        const __m128 cy{_mm_set1_ps(center.y)};
+        const __m128 cz{_mm_set1_ps(center.z)};
+        const __m128 r2{_mm_set1_ps(radiusSquared)};
+        const __m128 zero{_mm_setzero_ps()};
+        for (unsigned int i{0}; i < count; i += 4)
+        {
+            const unsigned int index{first + i};
+            // distance from the center to the box along each axis,0 inside
+            const __m128 dx{_mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[index]),cx),_mm_sub_ps(cx,_mm_loadu_ps(&maxX[index]))),zero)};
+            const __m128 dy{_mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY[index]),cy),_mm_sub_ps(cy,_mm_loadu_ps(&maxY[index]))),zero)};
+            const __m128 dz{_mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ[index]),cz),_mm_sub_ps(cz,_mm_loadu_ps(&maxZ[index]))),zero)};
+            const __m128 distance{_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx,dx),_mm_mul_ps(dy,dy)),_mm_mul_ps(dz,dz))};
+            auto hits{static_cast<unsigned int>(_mm_movemask_ps(_mm_cmple_ps(distance,r2)))};
+            if (count - i < 4)
+                hits &= (1u << (count - i)) - 1u; // lanes past the row
+            while (hits)
+            {
+                const auto lane{static_cast<unsigned int>(__builtin_ctz(hits))};
+                pairs.emplace_back(index + lane,light);
+                hits &= hits - 1;
+            }
+        }
+#else
+        for (unsigned int index{first}; index < first + count; ++index)
+        {
+            const float dx{std::max({minX[index] - center.x,center.x - maxX[index],0.0f})};
+            const float dy{std::max({minY[index] - center.y,center.y - maxY[index],0.0f})};
+            const float dz{std::max({minZ[index] - center.z,center.z - maxZ[index],0.0f})};
+            if (dx * dx + dy * dy + dz * dz <= radiusSquared)
+                pairs.emplace_back(index,light);
+        }
+#endif
+    }
+
+    // counting sort of the pairs by cluster,the lights of a cluster keep their order
+    void buildIndexList()
+    {
+        counts.assign(clusterCount,0);
+        for (const auto& [clusterIndex,light] : pairs)
+            ++counts[clusterIndex];
+
+        indices.resize(clusterCount);
+        std::uint32_t offset{0};
+        dropped = 0;
+        for (unsigned int i{0}; i < clusterCount; ++i)
+        {
+            const std::uint32_t count{std::min(counts[i],maxLightsPerCluster)};
+            dropped += counts[i] - count;
+            indices[i] = (offset << 8) | count;
+            counts[i] = offset; // write cursor from here on
+            offset += count;
+        }
+
+        indices.resize(clusterCount + offset);
+        for (const auto& [clusterIndex,light] : pairs)
+        {
+            const std::uint32_t end{(indices[clusterIndex] >> 8) + (indices[clusterIndex] & 0xFFu)};
+            if (counts[clusterIndex] < end)
+                indices[clusterCount + counts[clusterIndex]++] = light;
+        }
+
+        if (dropped && !reportedDropped)
+        {
+            reportedDropped = true;
+            std::cout << "CLUSTERED LIGHTS: " << dropped << " lights dropped from clusters over " << maxLightsPerCluster
+                      << " lights (reported once,droppedAssignments() has every frame's)\n";
+        }
+    }
+
+    void upload()
+    {
+        static_assert(sizeof(PointLight) == 16 * sizeof(float)); // four RGBA32F texels
+        const PointLight none{};
+        const std::span<const PointLight> data{lights.empty() ? std::span<const PointLight>{&none,1} : std::span<const PointLight>{lights}};
+        const std::uint32_t emptyGrid{0};
+        const std::span<const std::uint32_t> list{indices.empty() ? std::span<const std::uint32_t>{&emptyGrid,1} : std::span<const std::uint32_t>{indices}};
+
+        glBindBuffer(GL_TEXTURE_BUFFER,lightBuffer);
+        glBufferData(GL_TEXTURE_BUFFER,static_cast<long>(data.size_bytes()),data.data(),GL_STREAM_DRAW); // orphaned every frame
+        glBindBuffer(GL_TEXTURE_BUFFER,indexBuffer);
+        glBufferData(GL_TEXTURE_BUFFER,static_cast<long>(list.size_bytes()),list.data(),GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER,0);
+
+        glBindTexture(GL_TEXTURE_BUFFER,lightTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER,GL_RGBA32F,lightBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER,indexTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER,GL_R32UI,indexBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER,0);
+    }
+};
+
+#endif //MYOPENPROJECT_CLUSTEREDLIGHTS_H
@@ -0,0 +1,215 @@
+#ifndef MYOPENPROJECT_CPUPROFILER_H
+#define MYOPENPROJECT_CPUPROFILER_H
+
+#ifdef CPUPROFILER_ENABLED
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define CPUPROFILER_RDTSC
+#endif
+
+// Zones of CPU time,PROFILE_SCOPE("name") to the end of the scope (or PROFILE_FUNCTION()),written out as a
+// Chrome trace (chrome://tracing,ui.perfetto.dev) by PROFILE_WRITE_TRACE(path). Every thread records into a
+// ring of its own,registered the first time it records:only that thread writes it,so recording takes no lock,
+// and a reader copies it and drops what was overwritten while it copied. A ring keeps the last capacity zones
+// of its thread. The clock is the TSC where there is one (rdtsc,a few cycles),converted with the steady_clock
+// time taken next to it;steady_clock otherwise. Names must outlive the profiler (literals,__func__).
+// Without CPUPROFILER_ENABLED (the PROFILING option of the build) none of it is compiled and the macros are empty.
+class CpuProfiler
+{
+public:
+    static constexpr std::size_t capacity{1 << 15}; // zones per thread
+
+    struct Zone {
+        const char* name;
+        std::uint64_t begin; // ticks
+        std::uint64_t end;
+    };
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name)
+            : name{name},begin{now()}
+        {
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope()
+        {
+            record(name,begin,now());
+        }
+
+    private:
+        const char* name;
+        std::uint64_t begin;
+    };
+
+    [[nodiscard]] static std::uint64_t now()
+    {
+#ifdef CPUPROFILER_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    static void record(const char* name,const std::uint64_t begin,const std::uint64_t end)
+    {
+        Ring& ring{threadRing()};
+        const std::uint64_t index{ring.written.load(std::memory_order_relaxed)};
+        ring.zones[index % capacity] = {name,begin,end};
+        ring.written.store(index + 1,std::memory_order_release);
+    }
+
+    // what the trace calls the calling thread
+    static void nameThread(std::string name)
+    {
+        Ring& ring{threadRing()};
+        const std::scoped_lock lock{registry().mutex};
+        ring.name = std::move(name);
+    }
+
+    // every zone still in the rings,as Chrome trace events;returns how many,or nothing if the file can't be written
+    static std::size_t writeChromeTrace(const std::string& path)
+    {
+        std::ofstream out{path};
+        if (!out)
+            return 0;
+
+        Registry& registry{CpuProfiler::registry()};
+        const std::scoped_lock lock{registry.mutex};
+        const double ticksPerMicrosecond{registry.ticksPerMicrosecond()};
+        std::size_t written{0};
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        for (std::size_t thread{0}; thread < registry.rings.size(); ++thread)
+        {
+            const Ring& ring{*registry.rings[thread]};
+            out << (thread ? ",\n" : "") << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << thread
+                << R"(,"args":{"name":")" << escaped(ring.name) << "\"}}";
+            for (const Zone& zone : ring.snapshot())
+            {
+                const double begin{static_cast<double>(static_cast<std::int64_t>(zone.begin - registry.startTicks)) / ticksPerMicrosecond}; // the first zone starts before the registry
+                const double duration{static_cast<double>(zone.end - zone.begin) / ticksPerMicrosecond};
+                out << ",\n" << R"({"ph":"X","pid":1,"tid":)" << thread << R"(,"name":")" << escaped(zone.name)
+                    << R"(","ts":)" << std::fixed << std::setprecision(3) << begin << R"(,"dur":)" << duration << '}'
+                    << std::defaultfloat;
+                ++written;
+            }
+        }
+        out << "\n]}\n";
+        return out ? written : 0;
+    }
+
+private:
+    struct Ring {
+        std::array<Zone,capacity> zones{};
+        std::atomic<std::uint64_t> written{0};
+        std::string name;
+
+        // the zones no write overlapped while they were copied,oldest first
+        [[nodiscard]] std::vector<Zone> snapshot() const
+        {
+            const std::uint64_t end{written.load(std::memory_order_acquire)};
+            const std::uint64_t begin{end > capacity ? end - capacity : 0};
+            std::vector<Zone> copy;
+            copy.reserve(end - begin);
+            for (std::uint64_t i{begin}; i < end; ++i)
+                copy.push_back(zones[i % capacity]);
+
+            const std::uint64_t after{written.load(std::memory_order_acquire)};
+            const std::uint64_t overwritten{after + 1 > capacity ? std::min(after + 1 - capacity,end) - begin : 0}; // the first ones,the one being written too
+            copy.erase(copy.begin(),copy.begin() + static_cast<long>(std::min<std::uint64_t>(overwritten,copy.size())));
+            return copy;
+        }
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Ring>> rings; // never freed,a thread that ended keeps its zones
+        std::uint64_t startTicks{now()};
+        std::chrono::steady_clock::time_point startTime{std::chrono::steady_clock::now()};
+
+        [[nodiscard]] double ticksPerMicrosecond() const
+        {
+#ifdef CPUPROFILER_RDTSC
+            const double microseconds{std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now() - startTime).count()};
+            const auto ticks{static_cast<double>(now() - startTicks)};
+            return microseconds > 0.0 ? ticks / microseconds : 1.0;
+#else
+            return 1000.0; // nanoseconds
+#endif
+        }
+    };
+
+    [[nodiscard]] static Registry& registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    [[nodiscard]] static Ring& threadRing()
+    {
+        thread_local Ring* ring{registerThread()};
+        return *ring;
+    }
+
+    [[nodiscard]] static Ring* registerThread()
+    {
+        Registry& registry{CpuProfiler::registry()};
+        const std::scoped_lock lock{registry.mutex};
+        registry.rings.push_back(std::make_unique<Ring>());
+        registry.rings.back()->name = "thread " + std::to_string(registry.rings.size() - 1);
+        return registry.rings.back().get();
+    }
+
+    [[nodiscard]] static std::string escaped(const std::string_view name)
+    {
+        std::string result;
+        for (const char c : name)
+        {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result;
+    }
+};
+
+#define CPUPROFILER_CONCAT_(a,b) a##b
+#define CPUPROFILER_CONCAT(a,b) CPUPROFILER_CONCAT_(a,b)
+
+#define PROFILE_SCOPE(name) const CpuProfiler::Scope CPUPROFILER_CONCAT(profileScope,__LINE__){name}
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_THREAD(name) CpuProfiler::nameThread(name)
+#define PROFILE_WRITE_TRACE(path) CpuProfiler::writeChromeTrace(path)
+
+#else
+
+#include <cstddef>
+
+#define PROFILE_SCOPE(name) static_cast<void>(0)
+#define PROFILE_FUNCTION() static_cast<void>(0)
+#define PROFILE_THREAD(name) static_cast<void>(0)
+#define PROFILE_WRITE_TRACE(path) std::size_t{0}
+#endif
+
+#endif //MYOPENPROJECT_CPUPROFILER_H
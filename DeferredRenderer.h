@@ -0,0 +1,323 @@
+#ifndef MYOPENPROJECT_DEFERREDRENDERER_H
+#define MYOPENPROJECT_DEFERREDRENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Buffers/RenderTarget.h"
+#include "Shader.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+// Deferred shading for the geometry shader.fs lights. The geometry is drawn once into a G-buffer between
+// beginGeometry() and endGeometry() (gbuffershader.fs):
+//   diffuse (RGBA8),specular (RGBA8),world space normal (RGBA16F) and a 32 bit float depth texture
+// and shade() lights it in screen space,so the lighting runs once per visible pixel instead of once per
+// overdrawn fragment:
+//   1. a full screen pass with the directional light (deferreddirectional.fs),
+//   2. one sphere per point light,instanced,sized by the light's range and read from the ClusteredLights buffer,
+//      and a cone for the spot light (deferredlight.vs/.fs). Only the back faces are drawn,depth tested with
+//      GL_GEQUAL against the G-buffer depth,so a volume only shades the pixels in front of its far side;
+//      depth clamping keeps the far side when it is past the far plane,and the camera may be inside a volume,
+//   3. the result goes into the scene framebuffer with the G-buffer depth (deferredcomposite.fs),
+//      so what is drawn forward afterwards is depth tested against it.
+// The lights add up in an RGBA16F target,like the float sum of shader.fs,and only get rounded once in step 3.
+// The G-buffer is single sampled,so its edges don't get the scene's MSAA.
+class DeferredRenderer
+{
+public:
+    // the spot light as a cone: apex at position,opening along direction,outerCutOff is the half angle in radians
+    struct SpotVolume {
+        glm::vec3 position;
+        glm::vec3 direction;
+        float outerCutOff;
+        float range;
+    };
+
+    static constexpr unsigned int sphereSlices{16};
+    static constexpr unsigned int sphereStacks{8};
+    static constexpr unsigned int coneSegments{16};
+
+    DeferredRenderer(const unsigned int width,const unsigned int height,const unsigned int lightsUnit)
+        : gBuffer{width,height,{{GL_RGBA8,GL_RGBA,GL_UNSIGNED_BYTE},{GL_RGBA8,GL_RGBA,GL_UNSIGNED_BYTE},{GL_RGBA16F,GL_RGBA,GL_HALF_FLOAT}}},
+          lighting{width,height,{{GL_RGBA16F,GL_RGBA,GL_HALF_FLOAT}}}
+    {
+        gBuffer.attachDepthTexture();
+        lighting.attachDepthTexture(); // a copy of the G-buffer depth for the volume depth test,the shaders sample the original
+        supported = gBuffer.isComplete() && lighting.isComplete();
+
+        for (const Shader* shader : {&directionalPass,&lightPass,&compositePass})
+        {
+            shader->use();
+            shader->setInt("gDiffuse",0);
+            shader->setInt("gSpecular",1);
+            shader->setInt("gNormal",2);
+            shader->setInt("gDepth",3);
+        }
+        compositePass.setInt("lighting",4);
+        lightPass.use();
+        lightPass.setInt("clusterLights",static_cast<int>(lightsUnit));
+        glUniform2f(glGetUniformLocation(lightPass.getProgramID(),"screenSize"),static_cast<float>(width),static_cast<float>(height));
+
+        buildVolumes();
+    }
+
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+    ~DeferredRenderer()
+    {
+        glDeleteVertexArrays(1,&VAO);
+        glDeleteBuffers(1,&VBO);
+        glDeleteBuffers(1,&EBO);
+    }
+
+    [[nodiscard]] bool isSupported() const
+    {
+        return supported;
+    }
+
+    // the lighting uniforms (lights,viewPos,blinnPhong,material.shininess) are the ones of shader.fs,
+    // so the caller sets them on these two the way it does for the forward program
+    [[nodiscard]] const Shader& directionalShader() const
+    {
+        return directionalPass;
+    }
+
+    [[nodiscard]] const Shader& lightShader() const
+    {
+        return lightPass;
+    }
+
+    // the part of the targets drawn into,from the bottom left,when the scene is rendered below their size (DynamicResolution)
+    void setViewport(const unsigned int width,const unsigned int height) const
+    {
+        lightPass.use();
+        glUniform2f(glGetUniformLocation(lightPass.getProgramID(),"screenSize"),static_cast<float>(width),static_cast<float>(height));
+    }
+
+    // binds the G-buffer,the caller draws its opaque geometry with gbuffershader.fs after this
+    void beginGeometry() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER,gBuffer.getFrameBufferID());
+        constexpr std::array<float,4> zero{0.0f,0.0f,0.0f,0.0f};
+        for (int attachment{0}; attachment < 3; ++attachment)
+            glClearBufferfv(GL_COLOR,attachment,zero.data());
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND); // the normals have no alpha to blend with
+    }
+
+    void endGeometry() const
+    {
+        glEnable(GL_BLEND);
+    }
+
+    // lights the G-buffer and writes the result into framebuffer (the scene,possibly multisampled).
+    // pointLights is the number of lights in the ClusteredLights buffer bound to lightsUnit;quadVAO is the full screen quad
+    void shade(const unsigned int framebuffer,const glm::mat4& viewProjection,const std::size_t pointLights,
+               const std::optional<SpotVolume>& spot,const unsigned int quadVAO) const
+    {
+        const glm::mat4 inverseViewProjection{glm::inverse(viewProjection)};
+        bindGBuffer();
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER,gBuffer.getFrameBufferID());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER,lighting.getFrameBufferID());
+        const auto width{static_cast<int>(gBuffer.getWidth())};
+        const auto height{static_cast<int>(gBuffer.getHeight())};
+        glBlitFramebuffer(0,0,width,height,0,0,width,height,GL_DEPTH_BUFFER_BIT,GL_NEAREST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER,lighting.getFrameBufferID());
+        constexpr std::array<float,4> zero{0.0f,0.0f,0.0f,0.0f};
+        glClearBufferfv(GL_COLOR,0,zero.data());
+        glDisable(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+
+        directionalPass.use();
+        directionalPass.setMat4("inverseViewProjection",inverseViewProjection);
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLES,0,6);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE,GL_ONE);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_GEQUAL);
+        glDepthMask(GL_FALSE);
+        glEnable(GL_DEPTH_CLAMP);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+
+        lightPass.use();
+        lightPass.setMat4("viewProjection",viewProjection);
+        lightPass.setMat4("inverseViewProjection",inverseViewProjection);
+        glBindVertexArray(VAO);
+        if (pointLights)
+        {
+            lightPass.setBool("spotVolume",false);
+            glDrawElementsInstanced(GL_TRIANGLES,sphereIndexCount,GL_UNSIGNED_INT,nullptr,static_cast<int>(pointLights));
+        }
+        if (spot)
+        {
+            lightPass.setBool("spotVolume",true);
+            lightPass.setMat4("volumeTransform",coneTransform(*spot));
+            glDrawElements(GL_TRIANGLES,coneIndexCount,GL_UNSIGNED_INT,reinterpret_cast<void*>(sphereIndexCount * sizeof(unsigned int)));
+        }
+
+        glDisable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+        glDisable(GL_DEPTH_CLAMP);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+
+        glBindFramebuffer(GL_FRAMEBUFFER,framebuffer);
+        glDepthFunc(GL_ALWAYS);
+        glActiveTexture(GL_TEXTURE4); // only now,while it isn't the render target any more
+        glBindTexture(GL_TEXTURE_2D,lighting.getTextureID(0));
+        compositePass.use();
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLES,0,6);
+        glBindVertexArray(0);
+
+        glDepthFunc(GL_LEQUAL);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+        unbindGBuffer();
+    }
+
+private:
+    RenderTarget gBuffer;
+    RenderTarget lighting;
+    Shader directionalPass{"frameBufferShader.vs","deferreddirectional.fs"};
+    Shader lightPass{"deferredlight.vs","deferredlight.fs"};
+    Shader compositePass{"frameBufferShader.vs","deferredcomposite.fs"};
+    bool supported{false};
+
+    unsigned int VAO{};
+    unsigned int VBO{};
+    unsigned int EBO{};
+    int sphereIndexCount{};
+    int coneIndexCount{};
+
+    void bindGBuffer() const
+    {
+        for (unsigned int attachment{0}; attachment < 3; ++attachment)
+        {
+            glActiveTexture(GL_TEXTURE0 + attachment);
+            glBindTexture(GL_TEXTURE_2D,gBuffer.getTextureID(attachment));
+        }
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D,gBuffer.getDepthTextureID());
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    static void unbindGBuffer()
+    {
+        for (unsigned int unit{0}; unit < 5; ++unit)
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_2D,0);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // unit cone along -z turned to the spot's direction,as long as its range and as wide as its outer angle
+    [[nodiscard]] static glm::mat4 coneTransform(const SpotVolume& spot)
+    {
+        const glm::vec3 direction{glm::normalize(spot.direction)};
+        const glm::vec3 up{std::abs(direction.y) > 0.99f ? glm::vec3(1.0f,0.0f,0.0f) : glm::vec3(0.0f,1.0f,0.0f)};
+        const glm::mat4 orientation{glm::inverse(glm::lookAt(spot.position,spot.position + direction,up))};
+        const float radius{std::tan(spot.outerCutOff) * spot.range};
+        return glm::scale(orientation,glm::vec3(radius,radius,spot.range));
+    }
+
+    // a unit sphere and a unit cone (apex at the origin,base at z = -1),both wound counter-clockwise from outside
+    // and pushed out so their flat faces contain the round shape instead of cutting into it
+    void buildVolumes()
+    {
+        std::vector<glm::vec3> vertices;
+        std::vector<unsigned int> indices;
+        constexpr float pi{3.14159265f};
+
+        // keeps the triangles facing away from a point inside the shape,and drops the degenerate ones at the poles
+        const auto addTriangle = [&](const unsigned int a,const unsigned int b,const unsigned int c,const glm::vec3& inside){
+            const glm::vec3 normal{glm::cross(vertices[b] - vertices[a],vertices[c] - vertices[a])};
+            if (glm::dot(normal,normal) < 1e-12f)
+                return;
+            const bool outward{glm::dot(normal,(vertices[a] + vertices[b] + vertices[c]) / 3.0f - inside) > 0.0f};
+            indices.insert(indices.end(),{a,outward ? b : c,outward ? c : b});
+        };
+
+        for (unsigned int stack{0}; stack <= sphereStacks; ++stack)
+        {
+            const float polar{pi * static_cast<float>(stack) / static_cast<float>(sphereStacks)};
+            for (unsigned int slice{0}; slice < sphereSlices; ++slice)
+            {
+                const float azimuth{2.0f * pi * static_cast<float>(slice) / static_cast<float>(sphereSlices)};
+                vertices.emplace_back(std::sin(polar) * std::cos(azimuth),std::cos(polar),std::sin(polar) * std::sin(azimuth));
+            }
+        }
+        for (unsigned int stack{0}; stack < sphereStacks; ++stack)
+        {
+            for (unsigned int slice{0}; slice < sphereSlices; ++slice)
+            {
+                const unsigned int next{(slice + 1) % sphereSlices};
+                const unsigned int a{stack * sphereSlices + slice};
+                const unsigned int b{(stack + 1) * sphereSlices + slice};
+                const unsigned int c{(stack + 1) * sphereSlices + next};
+                const unsigned int d{stack * sphereSlices + next};
+                addTriangle(a,b,c,glm::vec3(0.0f));
+                addTriangle(a,c,d,glm::vec3(0.0f));
+            }
+        }
+        float closestFace{1.0f}; // distance from the center to the nearest face plane
+        for (std::size_t i{0}; i < indices.size(); i += 3)
+        {
+            const glm::vec3 normal{glm::normalize(glm::cross(vertices[indices[i + 1]] - vertices[indices[i]],vertices[indices[i + 2]] - vertices[indices[i]]))};
+            closestFace = std::min(closestFace,glm::dot(normal,vertices[indices[i]]));
+        }
+        for (glm::vec3& vertex : vertices)
+            vertex /= closestFace;
+        sphereIndexCount = static_cast<int>(indices.size());
+
+        const auto apex{static_cast<unsigned int>(vertices.size())};
+        vertices.emplace_back(0.0f);
+        vertices.emplace_back(0.0f,0.0f,-1.0f);
+        const float ringRadius{1.0f / std::cos(pi / static_cast<float>(coneSegments))};
+        for (unsigned int segment{0}; segment < coneSegments; ++segment)
+        {
+            const float angle{2.0f * pi * static_cast<float>(segment) / static_cast<float>(coneSegments)};
+            vertices.emplace_back(std::cos(angle) * ringRadius,std::sin(angle) * ringRadius,-1.0f);
+        }
+        const glm::vec3 insideCone{0.0f,0.0f,-0.5f};
+        for (unsigned int segment{0}; segment < coneSegments; ++segment)
+        {
+            const unsigned int current{apex + 2 + segment};
+            const unsigned int next{apex + 2 + (segment + 1) % coneSegments};
+            addTriangle(apex,current,next,insideCone);
+            addTriangle(apex + 1,next,current,insideCone);
+        }
+        coneIndexCount = static_cast<int>(indices.size()) - sphereIndexCount;
+
+        glGenVertexArrays(1,&VAO);
+        glGenBuffers(1,&VBO);
+        glGenBuffers(1,&EBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER,VBO);
+        glBufferData(GL_ARRAY_BUFFER,static_cast<long>(vertices.size() * sizeof(glm::vec3)),vertices.data(),GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,static_cast<long>(indices.size() * sizeof(unsigned int)),indices.data(),GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(glm::vec3),nullptr);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER,0);
+    }
+};
+
+#endif //MYOPENPROJECT_DEFERREDRENDERER_H
@@ -0,0 +1,233 @@
+#ifndef MYOPENPROJECT_DEPTHPREPASS_H
+#define MYOPENPROJECT_DEPTHPREPASS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "GpuTimer.h"
+#include "PositionStream.h"
+#include "Shader.h"
+
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <optional>
+#include <span>
+
+// Depth-only pre-pass for the lit meshes of a model. Their positions (PositionStream) are drawn with depthprepass.vs,
+// colour writes off,before the opaque passes;the lit pass then runs with depth writes off and GL_LEQUAL,so shader.fs only runs for
+// the fragments that end up on screen. depthprepass.vs and shader.vs both declare gl_Position invariant,so the
+// depths match exactly (GL_EQUAL would work too,GL_LEQUAL also forgives a driver that doesn't honour it).
+//
+// Whether that pays depends on the overdraw,so by default (Mode::automatic) it is measured: for framesPerPhase
+// frames with the pre-pass and as many without,a GPU timer covers the pre-pass and the opaque passes,and in the
+// frames with it two GL_SAMPLES_PASSED queries count
+//   - the samples the pre-pass writes,i.e. what the lit pass would shade on its own (early depth test included),
+//   - the samples covered once it's done (a full screen triangle on the far plane,depth tested GL_GREATER).
+// Their ratio is the overdraw. The pre-pass stays on if the overdraw is at least minOverdraw and the frames
+// with it were faster;the measurement is repeated every recalibrateAfter frames,as the view changes.
+class DepthPrepass
+{
+public:
+    enum class Mode
+    {
+        automatic,
+        on,
+        off,
+    };
+
+    inline static Mode mode{Mode::automatic};
+
+    static constexpr unsigned int framesPerPhase{30};
+    static constexpr unsigned int recalibrateAfter{1800};
+    static constexpr double minOverdraw{1.2};
+
+    explicit DepthPrepass(const PositionStream& positions)
+        : positions{positions}
+    {
+        const unsigned int program{shader.getProgramID()};
+        glUniformBlockBinding(program,glGetUniformBlockIndex(program,"Perspective"),0);
+    }
+
+    // before the opaque passes;starts the timer and tells whether this frame draws the pre-pass
+    [[nodiscard]] bool beginFrame()
+    {
+        if (mode != lastMode)
+        {
+            lastMode = mode;
+            std::cout << "DEPTH PRE-PASS: " << (mode == Mode::automatic ? "AUTOMATIC" : mode == Mode::on ? "ON" : "OFF") << '\n';
+            if (mode == Mode::automatic)
+                startCalibration();
+        }
+
+        Measurement measurement{Measurement::none};
+        if (mode == Mode::automatic && phase == Phase::with)
+            measurement = Measurement::with;
+        else if (mode == Mode::automatic && phase == Phase::without)
+            measurement = Measurement::without;
+        measurements.push_back(measurement);
+
+        active = mode == Mode::on || (mode == Mode::automatic && (measurement == Measurement::none ? enabled : measurement == Measurement::with));
+        timer.begin();
+        return active;
+    }
+
+    // the meshes' depth,when this frame has the pre-pass;transform is the model matrix the lit pass uses
+    void render(std::span<const std::uint32_t> meshes,const glm::mat4& transform)
+    {
+        if (!active)
+            return;
+
+        shader.use();
+        shader.setMat4("transform",transform);
+        shader.setBool("coverage",false);
+        glColorMask(GL_FALSE,GL_FALSE,GL_FALSE,GL_FALSE);
+        glBindVertexArray(positions.getVAO());
+
+        const bool counting{measurements.back() == Measurement::with};
+        if (counting)
+            samples.begin();
+        for (const std::uint32_t mesh : meshes)
+            positions.draw(mesh);
+        if (counting)
+        {
+            samples.end();
+
+            shader.setBool("coverage",true);
+            glDepthMask(GL_FALSE);
+            glDepthFunc(GL_GREATER);
+            samples.begin();
+            glDrawArrays(GL_TRIANGLES,0,3);
+            samples.end();
+            glDepthFunc(GL_LEQUAL);
+            glDepthMask(GL_TRUE);
+        }
+
+        glBindVertexArray(0);
+        glColorMask(GL_TRUE,GL_TRUE,GL_TRUE,GL_TRUE);
+    }
+
+    // after the last opaque draw
+    void endFrame()
+    {
+        timer.end();
+        collectResults();
+
+        if (mode != Mode::automatic)
+            return;
+        ++phaseFrames;
+        if (phase == Phase::with && phaseFrames == framesPerPhase)
+            nextPhase(Phase::without);
+        else if (phase == Phase::without && phaseFrames == framesPerPhase)
+            nextPhase(Phase::deciding);
+        else if (phase == Phase::deciding && withFrames >= framesPerPhase && withoutFrames >= framesPerPhase)
+        {
+            decide();
+            nextPhase(Phase::decided);
+        }
+        else if (phase == Phase::decided && phaseFrames == recalibrateAfter)
+            startCalibration();
+    }
+
+    [[nodiscard]] bool isActive() const
+    {
+        return active;
+    }
+
+    [[nodiscard]] double overdraw() const // of the last measurement
+    {
+        return coveredSamples ? static_cast<double>(shadedSamples) / static_cast<double>(coveredSamples) : 1.0;
+    }
+
+private:
+    enum class Phase
+    {
+        with,
+        without,
+        deciding, // waiting for the last results
+        decided,
+    };
+
+    enum class Measurement
+    {
+        none,
+        with,
+        without,
+    };
+
+    Shader shader{"depthprepass.vs","depthprepass.fs"};
+    const PositionStream& positions; // the lit meshes,drawn by their index
+
+    GpuTimer timer;
+    QueryRing samples{GL_SAMPLES_PASSED}; // pre-pass and coverage,in turns
+    std::deque<Measurement> measurements; // one per timed frame whose result hasn't come back
+    std::optional<std::uint64_t> prepassSamples;
+
+    Mode lastMode{Mode::off};
+    Phase phase{Phase::decided};
+    unsigned int phaseFrames{0};
+    bool active{false};
+    bool enabled{false};
+
+    double withMilliseconds{0.0};
+    double withoutMilliseconds{0.0};
+    unsigned int withFrames{0};
+    unsigned int withoutFrames{0};
+    std::uint64_t shadedSamples{0};
+    std::uint64_t coveredSamples{0};
+
+    void startCalibration()
+    {
+        withMilliseconds = withoutMilliseconds = 0.0;
+        withFrames = withoutFrames = 0;
+        shadedSamples = coveredSamples = 0;
+        nextPhase(Phase::with);
+    }
+
+    void nextPhase(const Phase next)
+    {
+        phase = next;
+        phaseFrames = 0;
+    }
+
+    void collectResults()
+    {
+        while (const std::optional<double> milliseconds{timer.poll()})
+        {
+            const Measurement measurement{measurements.front()};
+            measurements.pop_front();
+            if (measurement == Measurement::with)
+            {
+                withMilliseconds += *milliseconds;
+                ++withFrames;
+            }
+            else if (measurement == Measurement::without)
+            {
+                withoutMilliseconds += *milliseconds;
+                ++withoutFrames;
+            }
+        }
+        while (const std::optional<std::uint64_t> count{samples.poll()})
+        {
+            if (!prepassSamples)
+            {
+                prepassSamples = count;
+                continue;
+            }
+            shadedSamples += *prepassSamples;
+            coveredSamples += *count;
+            prepassSamples.reset();
+        }
+    }
+
+    void decide()
+    {
+        const double with{withMilliseconds / withFrames};
+        const double without{withoutMilliseconds / withoutFrames};
+        enabled = overdraw() >= minOverdraw && with < without;
+        std::cout << "DEPTH PRE-PASS: overdraw " << overdraw() << "x     with " << with << " ms     without " << without
+                  << " ms     -> " << (enabled ? "ON" : "OFF") << '\n';
+    }
+};
+
+#endif //MYOPENPROJECT_DEPTHPREPASS_H
@@ -0,0 +1,156 @@
+#ifndef MYOPENPROJECT_DYNAMICRESOLUTION_H
+#define MYOPENPROJECT_DYNAMICRESOLUTION_H
+
+#include <glad/glad.h>
+
+#include "GpuTimer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <optional>
+
+// Picks the resolution the scene is rendered at so the GPU frame time stays under a target. The GPU time of
+// a frame is the difference of two GL_TIMESTAMP queries around its passes (they don't clash with the
+// GL_TIME_ELAPSED timer of DepthPrepass),read back a few frames late. Every adjustAfter frames measured at the
+// current scale,the averaged time decides:
+//   - over the target: the scale drops to what would fit,the pixel count (scale squared) follows the time,
+//   - under headroom * target: it climbs by at most maxStepsUp steps,so it doesn't overshoot and bounce back.
+// The scale moves in steps of step between minScale and maxScale,so only a handful of sizes ever get
+// render targets (the FrameGraph pool keeps them). The offscreen targets keep their full size and only
+// their bottom left width() x height() is drawn into;PostProcess stretches it to the window in its last pass.
+class DynamicResolution
+{
+public:
+    struct Settings {
+        double targetMilliseconds{16.6};
+        float minScale{0.5f};
+        float maxScale{1.0f};
+        float step{0.05f};
+    };
+
+    static constexpr unsigned int adjustAfter{12};
+    static constexpr double headroom{0.8};
+    static constexpr unsigned int maxStepsUp{2};
+
+    inline static bool enabled{true};
+
+    DynamicResolution(const unsigned int fullWidth,const unsigned int fullHeight,const Settings& settings)
+        : fullWidth{fullWidth},fullHeight{fullHeight},settings{settings},current{settings.maxScale}
+    {
+    }
+
+    // before the frame's first pass
+    void beginFrame()
+    {
+        if (!enabled && current != settings.maxScale)
+            setScale(settings.maxScale);
+        stamps.stamp();
+        frameScales.push_back(current);
+    }
+
+    // after the frame's last pass
+    void endFrame()
+    {
+        stamps.stamp();
+        collectResults();
+        if (enabled && measuredFrames >= adjustAfter)
+            adjust();
+    }
+
+    // the scale it may climb back to,and the one it holds while disabled (temporal upscaling lowers it)
+    void setMaxScale(const float scale)
+    {
+        settings.maxScale = std::max(scale,settings.minScale);
+        if (current > settings.maxScale || (!enabled && current != settings.maxScale))
+            setScale(settings.maxScale);
+    }
+
+    [[nodiscard]] float scale() const
+    {
+        return current;
+    }
+
+    [[nodiscard]] unsigned int width() const
+    {
+        return std::max(static_cast<unsigned int>(std::lround(static_cast<float>(fullWidth) * current)),1u);
+    }
+
+    [[nodiscard]] unsigned int height() const
+    {
+        return std::max(static_cast<unsigned int>(std::lround(static_cast<float>(fullHeight) * current)),1u);
+    }
+
+    [[nodiscard]] double gpuMilliseconds() const // of the last frame measured
+    {
+        return lastMilliseconds;
+    }
+
+private:
+    unsigned int fullWidth;
+    unsigned int fullHeight;
+    Settings settings;
+    float current;
+
+    QueryRing stamps{GL_TIMESTAMP,16}; // two a frame
+    std::deque<float> frameScales;     // the scale of every frame whose time hasn't come back
+    std::optional<std::uint64_t> frameStart;
+    double lastMilliseconds{0.0};
+    double sumMilliseconds{0.0};       // of the frames measured at the current scale
+    unsigned int measuredFrames{0};
+
+    void collectResults()
+    {
+        while (const std::optional<std::uint64_t> stamp{stamps.poll()})
+        {
+            if (!frameStart)
+            {
+                frameStart = stamp;
+                continue;
+            }
+            const float scale{frameScales.front()};
+            frameScales.pop_front();
+            lastMilliseconds = static_cast<double>(*stamp - *frameStart) / 1'000'000.0;
+            frameStart.reset();
+            if (scale != current) // drawn before the last change,says nothing about this scale
+                continue;
+            sumMilliseconds += lastMilliseconds;
+            ++measuredFrames;
+        }
+    }
+
+    void adjust()
+    {
+        const double milliseconds{sumMilliseconds / measuredFrames};
+        const double fit{current * std::sqrt(settings.targetMilliseconds / milliseconds)};
+        float next{current};
+        if (milliseconds > settings.targetMilliseconds)
+            next = settings.step * std::floor(static_cast<float>(fit) / settings.step + 1e-3f); // 1e-3: 0.95 / 0.05 isn't quite 19
+        else if (milliseconds < headroom * settings.targetMilliseconds)
+            next = std::clamp(settings.step * std::floor(static_cast<float>(fit * std::sqrt(headroom)) / settings.step + 1e-3f),
+                              current,current + static_cast<float>(maxStepsUp) * settings.step);
+        next = std::clamp(next,settings.minScale,settings.maxScale);
+
+        if (std::abs(next - current) >= settings.step * 0.5f)
+        {
+            std::cout << "DYNAMIC RESOLUTION: " << milliseconds << " ms at " << current << " -> " << next << '\n';
+            setScale(next);
+        }
+        else
+        {
+            sumMilliseconds = 0.0;
+            measuredFrames = 0;
+        }
+    }
+
+    void setScale(const float scale)
+    {
+        current = scale;
+        sumMilliseconds = 0.0;
+        measuredFrames = 0;
+    }
+};
+
+#endif //MYOPENPROJECT_DYNAMICRESOLUTION_H
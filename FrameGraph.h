@@ -0,0 +1,584 @@
+#ifndef MYOPENPROJECT_FRAMEGRAPH_H
+#define MYOPENPROJECT_FRAMEGRAPH_H
+
+#include <glad/glad.h>
+
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The passes of a frame and the textures between them,declared again every frame:
+//   addPass(name,setup,execute):  setup gets a Builder and says what the pass reads and writes,execute does the GL work
+//                                  later,with the pass's framebuffer bound and its viewport set,
+//   create():                      a transient texture,described but not allocated,that lives only in this frame,
+//   importTexture/Framebuffer():   what the graph doesn't own (the shadow maps,the multisampled scene,the screen);
+//                                  an imported texture with a description can be rendered into (a history kept across frames),
+//   markOutput():                  what has to be there at the end.
+// compile() then
+//   - culls the passes nothing needs: walking back from the outputs,a pass runs only if something later reads
+//     what it writes (or it has a side effect),so a pass whose result goes unused costs nothing,
+//   - gives every transient a lifetime,from the first to the last pass that touches it,
+//   - aliases them: transients with the same description whose lifetimes don't overlap get the same texture.
+//     GL 3.3 can't place two textures in one allocation,so textures are shared whole;the pool keeps them
+//     across frames and deletes the ones unused for framesToKeep frames (after a resize,say),
+//   - makes (and caches) a framebuffer for every pass that writes transients.
+// execute() runs the passes that are left in the order they were added,each one a section of the profiler
+// it's given;dump() prints the compiled graph and how much memory the aliasing saves.
+class FrameGraph
+{
+public:
+    using Handle = std::uint32_t;
+
+    static constexpr unsigned int framesToKeep{120};
+
+    struct TextureDesc {
+        unsigned int width;
+        unsigned int height;
+        GLenum internalFormat; // any sized color or depth format that isn't an integer one
+        int samples{0};
+
+        bool operator==(const TextureDesc&) const = default;
+    };
+
+    // what a pass declares while it is added
+    class Builder
+    {
+    public:
+        // a transient texture this pass writes first
+        Handle create(std::string name,const TextureDesc& desc)
+        {
+            const auto handle{static_cast<Handle>(graph.resources.size())};
+            graph.resources.push_back({std::move(name),Kind::transient,desc,0});
+            write(handle);
+            return handle;
+        }
+
+        Handle read(const Handle resource)
+        {
+            graph.passes[pass].reads.push_back(resource);
+            return resource;
+        }
+
+        Handle write(const Handle resource)
+        {
+            graph.passes[pass].writes.push_back(resource);
+            return resource;
+        }
+
+        // never culled (queries,timers,anything outside the graph reads)
+        void sideEffect()
+        {
+            graph.passes[pass].sideEffect = true;
+        }
+
+    private:
+        friend class FrameGraph;
+        Builder(FrameGraph& graph,const std::size_t pass) : graph{graph},pass{pass} {}
+
+        FrameGraph& graph;
+        std::size_t pass;
+    };
+
+    // what a pass's execute gets
+    class Context
+    {
+    public:
+        [[nodiscard]] unsigned int texture(const Handle resource) const
+        {
+            return graph.textureOf(graph.resources[resource]);
+        }
+
+        // the one bound for the pass,0 if it writes no render target (or writes the screen)
+        [[nodiscard]] unsigned int framebuffer() const
+        {
+            return graph.passes[pass].framebuffer;
+        }
+
+    private:
+        friend class FrameGraph;
+        Context(const FrameGraph& graph,const std::size_t pass) : graph{graph},pass{pass} {}
+
+        const FrameGraph& graph;
+        std::size_t pass;
+    };
+
+    FrameGraph() = default;
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    ~FrameGraph()
+    {
+        for (const auto& [textures,framebuffer] : framebuffers)
+            glDeleteFramebuffers(1,&framebuffer);
+        for (const Physical& physical : pool)
+            glDeleteTextures(1,&physical.texture);
+    }
+
+    // forgets the last frame's passes and resources,keeps the textures and framebuffers
+    void reset()
+    {
+        passes.clear();
+        resources.clear();
+    }
+
+    Handle importTexture(std::string name,const unsigned int texture)
+    {
+        resources.push_back({std::move(name),Kind::texture,{},texture});
+        return static_cast<Handle>(resources.size() - 1);
+    }
+
+    // one the passes can also write,attached like a transient of that description
+    Handle importTexture(std::string name,const unsigned int texture,const TextureDesc& desc)
+    {
+        resources.push_back({std::move(name),Kind::texture,desc,texture});
+        return static_cast<Handle>(resources.size() - 1);
+    }
+
+    // a framebuffer the passes writing it render into,0 for the screen
+    Handle importFramebuffer(std::string name,const unsigned int framebuffer,const unsigned int width,const unsigned int height)
+    {
+        resources.push_back({std::move(name),Kind::framebuffer,{width,height,GL_NONE},framebuffer});
+        return static_cast<Handle>(resources.size() - 1);
+    }
+
+    void markOutput(const Handle resource)
+    {
+        resources[resource].output = true;
+    }
+
+    template<typename Setup>
+    void addPass(std::string name,Setup&& setup,std::function<void(const Context&)> execute)
+    {
+        passes.push_back({std::move(name),{},{},false,std::move(execute)});
+        Builder builder{*this,passes.size() - 1};
+        setup(builder);
+    }
+
+    void compile()
+    {
+        ++frame;
+        cull();
+        assignLifetimes();
+        alias();
+        makeFramebuffers();
+
+        for (std::size_t i{0}; i < pool.size();) // textures nothing needed for a while
+        {
+            if (frame - pool[i].lastUsed > framesToKeep)
+            {
+                forgetFramebuffersOf(pool[i].texture);
+                glDeleteTextures(1,&pool[i].texture);
+                pool.erase(pool.begin() + static_cast<long>(i));
+                for (Resource& resource : resources) // none of this frame's use it,but the indices move
+                {
+                    if (resource.kind == Kind::transient && resource.physical > i && resource.physical != none)
+                        --resource.physical;
+                }
+            }
+            else
+                ++i;
+        }
+    }
+
+    void execute(GpuProfiler* profiler = nullptr) const
+    {
+        for (std::size_t i{0}; i < passes.size(); ++i)
+        {
+            const Pass& pass{passes[i]};
+            if (!pass.kept)
+                continue;
+            if (pass.target)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER,pass.framebuffer);
+                glViewport(0,0,static_cast<int>(pass.width),static_cast<int>(pass.height));
+            }
+            const GpuProfiler::Scope scope{profiler,pass.name};
+            pass.execute(Context{*this,i});
+        }
+    }
+
+    // the compiled graph: passes (culled ones too),transients with their lifetimes and textures,the memory
+    void dump(std::ostream& out) const
+    {
+        const auto culled{std::ranges::count_if(passes,[](const Pass& pass){ return !pass.kept; })};
+        out << "FRAME GRAPH: " << passes.size() << " passes," << culled << " culled\n";
+        for (std::size_t i{0}; i < passes.size(); ++i)
+        {
+            const Pass& pass{passes[i]};
+            out << "  " << std::setw(2) << i << ' ' << std::left << std::setw(16) << pass.name << std::right
+                << (pass.kept ? "" : "(culled) ") << "reads:";
+            for (const Handle resource : pass.reads)
+                out << ' ' << resources[resource].name;
+            out << "     writes:";
+            for (const Handle resource : pass.writes)
+                out << ' ' << resources[resource].name;
+            out << '\n';
+        }
+
+        out << "  resources:\n";
+        for (const Resource& resource : resources)
+        {
+            out << "    " << std::left << std::setw(16) << resource.name << std::right;
+            if (resource.kind == Kind::texture)
+                out << "imported texture " << resource.id << '\n';
+            else if (resource.kind == Kind::framebuffer)
+                out << "imported framebuffer " << resource.id << '\n';
+            else if (resource.physical == none)
+                out << resource.desc.width << 'x' << resource.desc.height << "     unused\n";
+            else
+                out << resource.desc.width << 'x' << resource.desc.height << " 0x" << std::hex << resource.desc.internalFormat << std::dec
+                    << (resource.desc.samples ? " x" + std::to_string(resource.desc.samples) : std::string{}) << "     passes "
+                    << resource.first << '-' << resource.last << "     texture #" << resource.physical << "     "
+                    << megabytes(bytesOf(resource.desc)) << " MB\n";
+        }
+
+        out << "  transient memory: " << megabytes(declaredBytes) << " MB declared," << megabytes(allocatedBytes) << " MB allocated";
+        if (declaredBytes)
+            out << " (" << 100 - allocatedBytes * 100 / declaredBytes << "% saved by aliasing)";
+        out << ",pool of " << pool.size() << (pool.size() == 1 ? " texture\n" : " textures\n");
+    }
+
+    [[nodiscard]] std::size_t declaredMemory() const // bytes
+    {
+        return declaredBytes;
+    }
+
+    [[nodiscard]] std::size_t allocatedMemory() const
+    {
+        return allocatedBytes;
+    }
+
+    // what a texture of that description takes,roughly (drivers pad)
+    [[nodiscard]] static std::size_t bytesOf(const TextureDesc& desc)
+    {
+        std::size_t texel{4};
+        switch (desc.internalFormat)
+        {
+            case GL_R8:
+                texel = 1;
+                break;
+            case GL_R16F:
+            case GL_RG8:
+            case GL_DEPTH_COMPONENT16:
+                texel = 2;
+                break;
+            case GL_RGB8:
+            case GL_SRGB8:
+                texel = 3;
+                break;
+            case GL_RG16F:
+            case GL_R32F:
+                texel = 4;
+                break;
+            case GL_RGB16F:
+                texel = 6;
+                break;
+            case GL_RGBA16F:
+            case GL_RG32F:
+            case GL_DEPTH32F_STENCIL8:
+                texel = 8;
+                break;
+            case GL_RGB32F:
+                texel = 12;
+                break;
+            case GL_RGBA32F:
+                texel = 16;
+                break;
+            default: // RGBA8,SRGB8_ALPHA8,RGB10_A2,R11F_G11F_B10F,DEPTH24_STENCIL8,DEPTH_COMPONENT24/32F
+                break;
+        }
+        return texel * desc.width * desc.height * static_cast<std::size_t>(std::max(desc.samples,1));
+    }
+
+    // the draw of a full screen pass,for execute callbacks:the quad (two triangles) with textures bound to
+    // units 0,1,..,without depth test or blending
+    static void drawQuad(const unsigned int quadVAO,std::initializer_list<unsigned int> textures)
+    {
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        GLenum unit{GL_TEXTURE0};
+        for (const unsigned int texture : textures)
+        {
+            glActiveTexture(unit++);
+            glBindTexture(GL_TEXTURE_2D,texture);
+        }
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLES,0,6);
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        glEnable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+private:
+    static constexpr std::size_t none{std::numeric_limits<std::size_t>::max()};
+
+    enum class Kind
+    {
+        transient,
+        texture,     // imported
+        framebuffer, // imported
+    };
+
+    struct Resource {
+        std::string name;
+        Kind kind;
+        TextureDesc desc;
+        unsigned int id;              // imported
+        bool output{false};
+        std::size_t first{none};      // passes,after culling
+        std::size_t last{0};
+        std::size_t physical{none};   // pool
+    };
+
+    struct Pass {
+        std::string name;
+        std::vector<Handle> reads;
+        std::vector<Handle> writes;
+        bool sideEffect;
+        std::function<void(const Context&)> execute;
+        bool kept{false};
+        bool target{false};           // binds a framebuffer before execute
+        unsigned int framebuffer{0};
+        unsigned int width{0};
+        unsigned int height{0};
+    };
+
+    struct Physical {
+        TextureDesc desc;
+        unsigned int texture;
+        std::size_t busyUntil;        // the last pass of the resource in it,this frame
+        std::uint64_t lastUsed;       // frame
+    };
+
+    std::vector<Pass> passes;
+    std::vector<Resource> resources;
+    std::vector<Physical> pool;
+    std::map<std::vector<unsigned int>,unsigned int> framebuffers; // by attached textures
+    std::uint64_t frame{0};
+    std::size_t declaredBytes{0};
+    std::size_t allocatedBytes{0};
+
+    void cull()
+    {
+        std::vector<bool> needed(resources.size());
+        for (std::size_t i{0}; i < resources.size(); ++i)
+            needed[i] = resources[i].output;
+
+        for (std::size_t i{passes.size()}; i-- > 0;)
+        {
+            Pass& pass{passes[i]};
+            pass.kept = pass.sideEffect || std::ranges::any_of(pass.writes,[&](const Handle resource){ return needed[resource]; });
+            if (pass.kept)
+            {
+                for (const Handle resource : pass.reads)
+                    needed[resource] = true;
+            }
+        }
+    }
+
+    void assignLifetimes()
+    {
+        for (std::size_t i{0}; i < passes.size(); ++i)
+        {
+            if (!passes[i].kept)
+                continue;
+            for (const std::vector<Handle>* handles : {&passes[i].reads,&passes[i].writes})
+            {
+                for (const Handle handle : *handles)
+                {
+                    Resource& resource{resources[handle]};
+                    resource.first = std::min(resource.first,i);
+                    resource.last = std::max(resource.last,i);
+                }
+            }
+        }
+    }
+
+    void alias()
+    {
+        std::vector<Handle> order;
+        for (Handle i{0}; i < resources.size(); ++i)
+        {
+            if (resources[i].kind == Kind::transient && resources[i].first != none)
+                order.push_back(i);
+        }
+        std::ranges::stable_sort(order,{},[&](const Handle resource){ return resources[resource].first; });
+
+        for (Physical& physical : pool)
+            physical.busyUntil = none;
+        declaredBytes = allocatedBytes = 0;
+        for (const Handle handle : order)
+        {
+            Resource& resource{resources[handle]};
+            declaredBytes += bytesOf(resource.desc);
+
+            auto physical{std::ranges::find_if(pool,[&](const Physical& candidate){
+                return candidate.desc == resource.desc && (candidate.busyUntil == none || candidate.busyUntil < resource.first);
+            })};
+            if (physical == pool.end())
+            {
+                pool.push_back({resource.desc,allocate(resource.desc),none,frame});
+                physical = pool.end() - 1;
+            }
+            if (physical->busyUntil == none)
+                allocatedBytes += bytesOf(resource.desc);
+            physical->busyUntil = resource.last;
+            physical->lastUsed = frame;
+            resource.physical = static_cast<std::size_t>(physical - pool.begin());
+        }
+    }
+
+    void makeFramebuffers()
+    {
+        for (Pass& pass : passes)
+        {
+            pass.target = false;
+            pass.framebuffer = 0;
+            if (!pass.kept)
+                continue;
+
+            std::vector<unsigned int> textures;
+            for (const Handle handle : pass.writes)
+            {
+                const Resource& resource{resources[handle]};
+                if (resource.kind == Kind::framebuffer)
+                {
+                    if (!textures.empty() || pass.target)
+                        std::cout << "ERROR::FRAMEGRAPH:: " << pass.name << " writes " << resource.name << " and other render targets" << std::endl;
+                    pass.target = true;
+                    pass.framebuffer = resource.id;
+                    pass.width = resource.desc.width;
+                    pass.height = resource.desc.height;
+                }
+                else if (resource.kind == Kind::transient || resource.desc.width) // or a writable import
+                {
+                    textures.push_back(textureOf(resource));
+                    pass.width = resource.desc.width;
+                    pass.height = resource.desc.height;
+                }
+            }
+            if (textures.empty() || pass.target)
+            {
+                continue;
+            }
+
+            pass.target = true;
+            auto cached{framebuffers.find(textures)};
+            if (cached == framebuffers.end())
+                cached = framebuffers.emplace(textures,makeFramebuffer(pass.writes)).first;
+            pass.framebuffer = cached->second;
+        }
+    }
+
+    [[nodiscard]] unsigned int makeFramebuffer(const std::vector<Handle>& writes) const
+    {
+        unsigned int framebuffer{};
+        glGenFramebuffers(1,&framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER,framebuffer);
+        std::vector<GLenum> drawBuffers;
+        for (const Handle handle : writes)
+        {
+            const Resource& resource{resources[handle]};
+            if (resource.kind == Kind::framebuffer || (resource.kind == Kind::texture && !resource.desc.width))
+                continue;
+            const auto target{static_cast<GLenum>(resource.desc.samples ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D)};
+            const GLenum format{formatOf(resource.desc.internalFormat).first};
+            GLenum attachment{GL_DEPTH_ATTACHMENT};
+            if (format == GL_DEPTH_STENCIL)
+                attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+            else if (format != GL_DEPTH_COMPONENT)
+            {
+                attachment = static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + drawBuffers.size());
+                drawBuffers.push_back(attachment);
+            }
+            glFramebufferTexture2D(GL_FRAMEBUFFER,attachment,target,textureOf(resource),0);
+        }
+        if (drawBuffers.empty())
+            glDrawBuffer(GL_NONE);
+        else
+            glDrawBuffers(static_cast<int>(drawBuffers.size()),drawBuffers.data());
+
+        const GLenum status{glCheckFramebufferStatus(GL_FRAMEBUFFER)};
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEGRAPH:: Framebuffer is not complete: 0x" << std::hex << status << std::dec << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+        return framebuffer;
+    }
+
+    [[nodiscard]] unsigned int textureOf(const Resource& resource) const
+    {
+        return resource.kind == Kind::transient ? pool[resource.physical].texture : resource.id;
+    }
+
+    void forgetFramebuffersOf(const unsigned int texture)
+    {
+        std::erase_if(framebuffers,[&](const auto& entry){
+            if (std::ranges::find(entry.first,texture) == entry.first.end())
+                return false;
+            glDeleteFramebuffers(1,&entry.second);
+            return true;
+        });
+    }
+
+    [[nodiscard]] static unsigned int allocate(const TextureDesc& desc)
+    {
+        unsigned int texture{};
+        glGenTextures(1,&texture);
+        if (desc.samples)
+        {
+            glBindTexture(GL_TEXTURE_2D_MULTISAMPLE,texture);
+            glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE,desc.samples,desc.internalFormat,static_cast<int>(desc.width),static_cast<int>(desc.height),GL_TRUE);
+            glBindTexture(GL_TEXTURE_2D_MULTISAMPLE,0);
+            return texture;
+        }
+
+        const auto [format,type]{formatOf(desc.internalFormat)};
+        const bool depth{format == GL_DEPTH_COMPONENT || format == GL_DEPTH_STENCIL};
+        glBindTexture(GL_TEXTURE_2D,texture);
+        glTexImage2D(GL_TEXTURE_2D,0,static_cast<int>(desc.internalFormat),static_cast<int>(desc.width),static_cast<int>(desc.height),0,format,type,nullptr);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,depth ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,depth ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D,0);
+        return texture;
+    }
+
+    // the format and type glTexImage2D wants with a sized internal format (no data is uploaded)
+    [[nodiscard]] static std::pair<GLenum,GLenum> formatOf(const GLenum internalFormat)
+    {
+        switch (internalFormat)
+        {
+            case GL_DEPTH_COMPONENT16:
+            case GL_DEPTH_COMPONENT24:
+            case GL_DEPTH_COMPONENT32F:
+                return {GL_DEPTH_COMPONENT,GL_FLOAT};
+            case GL_DEPTH24_STENCIL8:
+                return {GL_DEPTH_STENCIL,GL_UNSIGNED_INT_24_8};
+            case GL_DEPTH32F_STENCIL8:
+                return {GL_DEPTH_STENCIL,GL_FLOAT_32_UNSIGNED_INT_24_8_REV};
+            default:
+                return {GL_RGBA,GL_UNSIGNED_BYTE};
+        }
+    }
+
+    [[nodiscard]] static double megabytes(const std::size_t bytes)
+    {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+};
+
+#endif //MYOPENPROJECT_FRAMEGRAPH_H
@@ -0,0 +1,72 @@
+#ifndef MYOPENPROJECT_FRUSTUM_H
+#define MYOPENPROJECT_FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+#include <array>
+
+// The six clip planes of a view-projection matrix (Gribb/Hartmann). The normals point inside
+// and are normalized,so plane.w + dot(plane,point) is a signed distance in world units.
+// The scalar tests are for a handful of objects;FrustumCuller tests whole batches at once.
+struct Frustum {
+    enum Plane
+    {
+        left,
+        right,
+        bottom,
+        top,
+        nearPlane,
+        farPlane,
+        count,
+    };
+
+    std::array<glm::vec4,count> planes{};
+
+    Frustum() = default;
+
+    explicit Frustum(const glm::mat4& viewProjection)
+    {
+        const glm::vec4 row0{viewProjection[0][0],viewProjection[1][0],viewProjection[2][0],viewProjection[3][0]};
+        const glm::vec4 row1{viewProjection[0][1],viewProjection[1][1],viewProjection[2][1],viewProjection[3][1]};
+        const glm::vec4 row2{viewProjection[0][2],viewProjection[1][2],viewProjection[2][2],viewProjection[3][2]};
+        const glm::vec4 row3{viewProjection[0][3],viewProjection[1][3],viewProjection[2][3],viewProjection[3][3]};
+
+        planes[left] = row3 + row0;
+        planes[right] = row3 - row0;
+        planes[bottom] = row3 + row1;
+        planes[top] = row3 - row1;
+        planes[nearPlane] = row3 + row2;
+        planes[farPlane] = row3 - row2;
+
+        for (glm::vec4& plane : planes)
+            plane /= glm::length(glm::vec3(plane));
+    }
+
+    [[nodiscard]] bool intersects(const BoundingSphere& sphere) const
+    {
+        for (const glm::vec4& plane : planes)
+        {
+            if (glm::dot(glm::vec3(plane),sphere.center) + plane.w < -sphere.radius)
+                return false;
+        }
+        return true;
+    }
+
+    // conservative:a box near a frustum corner can pass without being visible
+    [[nodiscard]] bool intersects(const AABB& box) const
+    {
+        const glm::vec3 center{box.center()};
+        const glm::vec3 extents{box.extents()};
+        for (const glm::vec4& plane : planes)
+        {
+            const glm::vec3 normal{plane};
+            if (glm::dot(normal,center) + plane.w < -glm::dot(glm::abs(normal),extents))
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif //MYOPENPROJECT_FRUSTUM_H
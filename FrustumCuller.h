@@ -0,0 +1,175 @@
+#ifndef MYOPENPROJECT_FRUSTUMCULLER_H
+#define MYOPENPROJECT_FRUSTUMCULLER_H
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+#include "Frustum.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FRUSTUMCULLER_SSE
+#endif
+
+// Batched frustum test. World space bounds are added as center/extents in structure of arrays
+// form,so cull() tests four objects per plane with SSE (and a scalar loop for the rest).
+// The per frame counters are shared by every culler and are what printFPS shows.
+class FrustumCuller
+{
+public:
+    explicit FrustumCuller(const std::size_t expectedObjects = 256)
+    {
+        for (std::vector<float>* column : {&centerX,&centerY,&centerZ,&extentX,&extentY,&extentZ})
+            column->reserve(expectedObjects);
+        visible.reserve(expectedObjects);
+    }
+
+    // returns the index to ask isVisible() with after cull()
+    std::size_t add(const AABB& bounds)
+    {
+        return push(bounds.center(),bounds.extents());
+    }
+
+    // stored as the box around the sphere,which is what the batched test handles
+    std::size_t add(const BoundingSphere& sphere)
+    {
+        return push(sphere.center,glm::vec3(sphere.radius));
+    }
+
+    void cull(const Frustum& frustum)
+    {
+        const std::size_t count{centerX.size()};
+        visible.resize(count);
+        std::size_t i{0};
+
+#ifdef FRUSTUMCULLER_SSE
+        __m128 planeX[Frustum::count],planeY[Frustum::count],planeZ[Frustum::count],planeW[Frustum::count];
+        __m128 absX[Frustum::count],absY[Frustum::count],absZ[Frustum::count];
+        for (std::size_t p{0}; p < Frustum::count; ++p)
+        {
+            const glm::vec4& plane = frustum.planes[p];
+            planeX[p] = _mm_set1_ps(plane.x);
+            planeY[p] = _mm_set1_ps(plane.y);
+            planeZ[p] = _mm_set1_ps(plane.z);
+            planeW[p] = _mm_set1_ps(plane.w);
+            absX[p] = _mm_set1_ps(std::abs(plane.x));
+            absY[p] = _mm_set1_ps(std::abs(plane.y));
+            absZ[p] = _mm_set1_ps(std::abs(plane.z));
+        }
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 cx{_mm_loadu_ps(&centerX[i])};
+            const __m128 cy{_mm_loadu_ps(&centerY[i])};
+            const __m128 cz{_mm_loadu_ps(&centerZ[i])};
+            const __m128 ex{_mm_loadu_ps(&extentX[i])};
+            const __m128 ey{_mm_loadu_ps(&extentY[i])};
+            const __m128 ez{_mm_loadu_ps(&extentZ[i])};
+
+            __m128 outside{_mm_setzero_ps()};
+            for (std::size_t p{0}; p < Frustum::count; ++p)
+            {
+                // distance of the center + projected radius of the box,behind the plane when negative
+                const __m128 distance{_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx,planeX[p]),_mm_mul_ps(cy,planeY[p])),
+                                                 _mm_add_ps(_mm_mul_ps(cz,planeZ[p]),planeW[p]))};
+                const __m128 radius{_mm_add_ps(_mm_add_ps(_mm_mul_ps(ex,absX[p]),_mm_mul_ps(ey,absY[p])),_mm_mul_ps(ez,absZ[p]))};
+                outside = _mm_or_ps(outside,_mm_cmplt_ps(_mm_add_ps(distance,radius),_mm_setzero_ps()));
+            }
+
+            const int mask{_mm_movemask_ps(outside)};
+            for (int lane{0}; lane < 4; ++lane)
+                visible[i + static_cast<std::size_t>(lane)] = !(mask & (1 << lane));
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            bool inside{true};
+            for (const glm::vec4& plane : frustum.planes)
+            {
+                const float distance{centerX[i] * plane.x + centerY[i] * plane.y + centerZ[i] * plane.z + plane.w};
+                const float radius{extentX[i] * std::abs(plane.x) + extentY[i] * std::abs(plane.y) + extentZ[i] * std::abs(plane.z)};
+                inside = inside && distance + radius >= 0.0f;
+            }
+            visible[i] = inside;
+        }
+
+        std::size_t visibleObjects{0};
+        for (const std::uint8_t flag : visible)
+            visibleObjects += flag;
+        frameDrawn += static_cast<unsigned int>(visibleObjects);
+        frameCulled += static_cast<unsigned int>(count - visibleObjects);
+    }
+
+    [[nodiscard]] bool isVisible(const std::size_t index) const
+    {
+        return visible[index] != 0;
+    }
+
+    // keeps the capacity for the next frame
+    void clear()
+    {
+        for (std::vector<float>* column : {&centerX,&centerY,&centerZ,&extentX,&extentY,&extentZ})
+            column->clear();
+        visible.clear();
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return centerX.size();
+    }
+
+    // objects that passed/failed every cull() since the last reset
+    [[nodiscard]] static unsigned int drawnThisFrame()
+    {
+        return frameDrawn;
+    }
+
+    [[nodiscard]] static unsigned int culledThisFrame()
+    {
+        return frameCulled;
+    }
+
+    // for objects culled some other way (BVH queries),so the counters cover the whole frame
+    static void countFrame(const std::size_t drawn,const std::size_t culled)
+    {
+        frameDrawn += static_cast<unsigned int>(drawn);
+        frameCulled += static_cast<unsigned int>(culled);
+    }
+
+    static void resetFrameCounters()
+    {
+        frameDrawn = 0;
+        frameCulled = 0;
+    }
+
+private:
+    inline static unsigned int frameDrawn{};
+    inline static unsigned int frameCulled{};
+
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> extentX;
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+    std::vector<std::uint8_t> visible;
+
+    std::size_t push(const glm::vec3& center,const glm::vec3& extents)
+    {
+        centerX.push_back(center.x);
+        centerY.push_back(center.y);
+        centerZ.push_back(center.z);
+        extentX.push_back(extents.x);
+        extentY.push_back(extents.y);
+        extentZ.push_back(extents.z);
+        return centerX.size() - 1;
+    }
+};
+
+#endif //MYOPENPROJECT_FRUSTUMCULLER_H
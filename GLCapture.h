@@ -0,0 +1,402 @@
+#ifndef MYOPENPROJECT_GLCAPTURE_H
+#define MYOPENPROJECT_GLCAPTURE_H
+
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+#include "GLTrace.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Records every GL call of the first frames into a GLTrace file,for GL_REPLAY to benchmark without the assets,the
+// input or the window. begin() swaps glad's function pointers (and GLExtensions') for hooks that append the call
+// to GLTrace::writer and then make it;endFrame() after every swap writes the frame out,and after the frames asked
+// for restores the pointers. It has to start right after the loader,before anything is created,since the trace
+// has to build every object it uses. Mapped buffers are recorded as what was written to them when they're
+// unmapped,so persistent mapping (written to at any time) is turned off while capturing.
+namespace GLCapture
+{
+    namespace Detail
+    {
+        inline std::ofstream file;
+        inline std::string path;
+        inline unsigned int framesLeft{0};
+        inline GLTrace::Header header{};
+
+        struct Mapping {
+            GLintptr offset;
+            GLsizeiptr length;
+            void* pointer;
+            bool written;
+        };
+        inline std::map<GLenum,Mapping> mappings; // by target
+
+        // the real functions behind the special hooks
+        template<auto pointer>
+        inline std::remove_reference_t<decltype(*pointer)> real{nullptr};
+
+        // puts hook in place of the loader's pointer,or back
+        template<bool in,auto pointer,auto hook>
+        void swapHook()
+        {
+            if constexpr (in)
+            {
+                if (!*pointer || *pointer == hook)
+                    return;
+                real<pointer> = *pointer;
+                *pointer = hook;
+            }
+            else if (real<pointer> && *pointer == hook)
+                *pointer = real<pointer>;
+        }
+
+        [[nodiscard]] inline std::uint64_t idOf(const GLsync sync)
+        {
+            return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(sync));
+        }
+
+        template<GLTrace::Arg kind,auto pointer>
+        void APIENTRY gen(const GLsizei count,GLuint* names)
+        {
+            real<pointer>(count,names);
+            GLTrace::writer.op(GLTrace::Special::gen);
+            GLTrace::writer.put(kind);
+            GLTrace::writer.putBytes(names,static_cast<std::size_t>(count) * sizeof(GLuint));
+        }
+
+        template<GLTrace::Arg kind,auto pointer>
+        void APIENTRY deleteNames(const GLsizei count,const GLuint* names)
+        {
+            GLTrace::writer.op(GLTrace::Special::deleteNames);
+            GLTrace::writer.put(kind);
+            GLTrace::writer.putBytes(names,static_cast<std::size_t>(count) * sizeof(GLuint));
+            real<pointer>(count,names);
+        }
+
+        inline GLuint APIENTRY createShader(const GLenum type)
+        {
+            const GLuint shader{real<&glad_glCreateShader>(type)};
+            GLTrace::writer.op(GLTrace::Special::createShader);
+            GLTrace::writer.put(type);
+            GLTrace::writer.put(shader);
+            return shader;
+        }
+
+        inline GLuint APIENTRY createProgram()
+        {
+            const GLuint program{real<&glad_glCreateProgram>()};
+            GLTrace::writer.op(GLTrace::Special::createProgram);
+            GLTrace::writer.put(program);
+            return program;
+        }
+
+        inline GLint APIENTRY getUniformLocation(const GLuint program,const GLchar* name)
+        {
+            const GLint location{real<&glad_glGetUniformLocation>(program,name)};
+            GLTrace::writer.op(GLTrace::Special::uniformLocation);
+            GLTrace::writer.put(program);
+            GLTrace::writer.putBytes(name,std::strlen(name));
+            GLTrace::writer.put(location);
+            return location;
+        }
+
+        inline GLuint APIENTRY getUniformBlockIndex(const GLuint program,const GLchar* name)
+        {
+            const GLuint index{real<&glad_glGetUniformBlockIndex>(program,name)};
+            GLTrace::writer.op(GLTrace::Special::uniformBlockIndex);
+            GLTrace::writer.put(program);
+            GLTrace::writer.putBytes(name,std::strlen(name));
+            GLTrace::writer.put(index);
+            return index;
+        }
+
+        inline void APIENTRY uniformBlockBinding(const GLuint program,const GLuint index,const GLuint binding)
+        {
+            GLTrace::writer.op(GLTrace::Special::uniformBlockBinding);
+            GLTrace::writer.put(program);
+            GLTrace::writer.put(index);
+            GLTrace::writer.put(binding);
+            real<&glad_glUniformBlockBinding>(program,index,binding);
+        }
+
+        inline void APIENTRY shaderSource(const GLuint shader,const GLsizei count,const GLchar* const* sources,const GLint* lengths)
+        {
+            GLTrace::writer.op(GLTrace::Special::shaderSource);
+            GLTrace::writer.put(shader);
+            GLTrace::writer.put(count);
+            for (GLsizei i{0}; i < count; ++i)
+                GLTrace::writer.putBytes(sources[i],lengths && lengths[i] >= 0 ? static_cast<std::size_t>(lengths[i]) : std::strlen(sources[i]));
+            real<&glad_glShaderSource>(shader,count,sources,lengths);
+        }
+
+        inline void APIENTRY bufferData(const GLenum target,const GLsizeiptr size,const void* data,const GLenum usage)
+        {
+            GLTrace::writer.op(GLTrace::Special::bufferData);
+            GLTrace::writer.put(target);
+            GLTrace::writer.put(usage);
+            GLTrace::writer.put(size);
+            GLTrace::writer.put(static_cast<std::uint8_t>(data != nullptr));
+            GLTrace::writer.putBytes(data,data ? static_cast<std::size_t>(size) : 0);
+            real<&glad_glBufferData>(target,size,data,usage);
+        }
+
+        inline void APIENTRY bufferSubData(const GLenum target,const GLintptr offset,const GLsizeiptr size,const void* data)
+        {
+            GLTrace::writer.op(GLTrace::Special::bufferSubData);
+            GLTrace::writer.put(target);
+            GLTrace::writer.put(offset);
+            GLTrace::writer.putBytes(data,static_cast<std::size_t>(size));
+            real<&glad_glBufferSubData>(target,offset,size,data);
+        }
+
+        inline void* APIENTRY mapBufferRange(const GLenum target,const GLintptr offset,const GLsizeiptr length,const GLbitfield access)
+        {
+            void* pointer{real<&glad_glMapBufferRange>(target,offset,length,access)};
+            if (pointer)
+                mappings[target] = {offset,length,pointer,(access & GL_MAP_WRITE_BIT) != 0};
+            return pointer;
+        }
+
+        inline GLboolean APIENTRY unmapBuffer(const GLenum target)
+        {
+            if (const auto mapping{mappings.find(target)}; mapping != mappings.end())
+            {
+                if (mapping->second.written)
+                {
+                    GLTrace::writer.op(GLTrace::Special::bufferSubData);
+                    GLTrace::writer.put(target);
+                    GLTrace::writer.put(mapping->second.offset);
+                    GLTrace::writer.putBytes(mapping->second.pointer,static_cast<std::size_t>(mapping->second.length));
+                }
+                mappings.erase(mapping);
+            }
+            return real<&glad_glUnmapBuffer>(target);
+        }
+
+        [[nodiscard]] inline int unpackAlignment()
+        {
+            int alignment{4};
+            glGetIntegerv(GL_UNPACK_ALIGNMENT,&alignment);
+            return alignment;
+        }
+
+        inline void APIENTRY texImage2D(const GLenum target,const GLint level,const GLint internalFormat,const GLsizei width,const GLsizei height,
+                                        const GLint border,const GLenum format,const GLenum type,const void* pixels)
+        {
+            GLTrace::writer.op(GLTrace::Special::texImage2D);
+            for (const GLint value : {static_cast<GLint>(target),level,internalFormat,width,height,border,static_cast<GLint>(format),static_cast<GLint>(type)})
+                GLTrace::writer.put(value);
+            GLTrace::writer.putBytes(pixels,pixels ? GLTrace::imageBytes(width,height,1,format,type,unpackAlignment()) : 0);
+            real<&glad_glTexImage2D>(target,level,internalFormat,width,height,border,format,type,pixels);
+        }
+
+        inline void APIENTRY texImage3D(const GLenum target,const GLint level,const GLint internalFormat,const GLsizei width,const GLsizei height,
+                                        const GLsizei depth,const GLint border,const GLenum format,const GLenum type,const void* pixels)
+        {
+            GLTrace::writer.op(GLTrace::Special::texImage3D);
+            for (const GLint value : {static_cast<GLint>(target),level,internalFormat,width,height,depth,border,static_cast<GLint>(format),static_cast<GLint>(type)})
+                GLTrace::writer.put(value);
+            GLTrace::writer.putBytes(pixels,pixels ? GLTrace::imageBytes(width,height,depth,format,type,unpackAlignment()) : 0);
+            real<&glad_glTexImage3D>(target,level,internalFormat,width,height,depth,border,format,type,pixels);
+        }
+
+        inline void APIENTRY texSubImage3D(const GLenum target,const GLint level,const GLint x,const GLint y,const GLint z,const GLsizei width,
+                                           const GLsizei height,const GLsizei depth,const GLenum format,const GLenum type,const void* pixels)
+        {
+            GLTrace::writer.op(GLTrace::Special::texSubImage3D);
+            for (const GLint value : {static_cast<GLint>(target),level,x,y,z,width,height,depth,static_cast<GLint>(format),static_cast<GLint>(type)})
+                GLTrace::writer.put(value);
+            GLTrace::writer.putBytes(pixels,GLTrace::imageBytes(width,height,depth,format,type,unpackAlignment()));
+            real<&glad_glTexSubImage3D>(target,level,x,y,z,width,height,depth,format,type,pixels);
+        }
+
+        inline void APIENTRY texParameterfv(const GLenum target,const GLenum name,const GLfloat* values)
+        {
+            GLTrace::writer.op(GLTrace::Special::texParameterfv);
+            GLTrace::writer.put(target);
+            GLTrace::writer.put(name);
+            GLTrace::writer.putBytes(values,(name == GL_TEXTURE_BORDER_COLOR ? 4 : 1) * sizeof(GLfloat));
+            real<&glad_glTexParameterfv>(target,name,values);
+        }
+
+        template<GLTrace::Special op,std::size_t components,auto pointer>
+        void APIENTRY uniformVector(const GLint location,const GLsizei count,const GLfloat* values)
+        {
+            GLTrace::writer.op(op);
+            GLTrace::writer.put(location);
+            GLTrace::writer.putBytes(values,static_cast<std::size_t>(count) * components * sizeof(GLfloat));
+            real<pointer>(location,count,values);
+        }
+
+        template<GLTrace::Special op,std::size_t components,auto pointer>
+        void APIENTRY uniformMatrix(const GLint location,const GLsizei count,const GLboolean transpose,const GLfloat* values)
+        {
+            GLTrace::writer.op(op);
+            GLTrace::writer.put(location);
+            GLTrace::writer.put(transpose);
+            GLTrace::writer.putBytes(values,static_cast<std::size_t>(count) * components * sizeof(GLfloat));
+            real<pointer>(location,count,transpose,values);
+        }
+
+        inline void APIENTRY drawBuffers(const GLsizei count,const GLenum* buffers)
+        {
+            GLTrace::writer.op(GLTrace::Special::drawBuffers);
+            GLTrace::writer.putBytes(buffers,static_cast<std::size_t>(count) * sizeof(GLenum));
+            real<&glad_glDrawBuffers>(count,buffers);
+        }
+
+        inline void APIENTRY clearBufferfv(const GLenum buffer,const GLint drawBuffer,const GLfloat* value)
+        {
+            GLTrace::writer.op(GLTrace::Special::clearBufferfv);
+            GLTrace::writer.put(buffer);
+            GLTrace::writer.put(drawBuffer);
+            GLTrace::writer.putBytes(value,(buffer == GL_COLOR ? 4 : 1) * sizeof(GLfloat));
+            real<&glad_glClearBufferfv>(buffer,drawBuffer,value);
+        }
+
+        inline GLsync APIENTRY fenceSync(const GLenum condition,const GLbitfield flags)
+        {
+            const GLsync sync{real<&glad_glFenceSync>(condition,flags)};
+            GLTrace::writer.op(GLTrace::Special::fenceSync);
+            GLTrace::writer.put(condition);
+            GLTrace::writer.put(flags);
+            GLTrace::writer.put(idOf(sync));
+            return sync;
+        }
+
+        inline GLenum APIENTRY clientWaitSync(const GLsync sync,const GLbitfield flags,const GLuint64 timeout)
+        {
+            GLTrace::writer.op(GLTrace::Special::clientWaitSync);
+            GLTrace::writer.put(idOf(sync));
+            GLTrace::writer.put(flags);
+            GLTrace::writer.put(timeout);
+            return real<&glad_glClientWaitSync>(sync,flags,timeout);
+        }
+
+        inline void APIENTRY deleteSync(const GLsync sync)
+        {
+            GLTrace::writer.op(GLTrace::Special::deleteSync);
+            GLTrace::writer.put(idOf(sync));
+            real<&glad_glDeleteSync>(sync);
+        }
+
+        // every hook in or out
+        template<bool in>
+        void swapHooks()
+        {
+            using GLTrace::Arg;
+            using GLTrace::Special;
+            swapHook<in,&glad_glGenBuffers,&gen<Arg::buffer,&glad_glGenBuffers>>();
+            swapHook<in,&glad_glGenTextures,&gen<Arg::texture,&glad_glGenTextures>>();
+            swapHook<in,&glad_glGenVertexArrays,&gen<Arg::vertexArray,&glad_glGenVertexArrays>>();
+            swapHook<in,&glad_glGenFramebuffers,&gen<Arg::framebuffer,&glad_glGenFramebuffers>>();
+            swapHook<in,&glad_glGenRenderbuffers,&gen<Arg::renderbuffer,&glad_glGenRenderbuffers>>();
+            swapHook<in,&glad_glGenQueries,&gen<Arg::query,&glad_glGenQueries>>();
+            swapHook<in,&glad_glDeleteBuffers,&deleteNames<Arg::buffer,&glad_glDeleteBuffers>>();
+            swapHook<in,&glad_glDeleteTextures,&deleteNames<Arg::texture,&glad_glDeleteTextures>>();
+            swapHook<in,&glad_glDeleteVertexArrays,&deleteNames<Arg::vertexArray,&glad_glDeleteVertexArrays>>();
+            swapHook<in,&glad_glDeleteFramebuffers,&deleteNames<Arg::framebuffer,&glad_glDeleteFramebuffers>>();
+            swapHook<in,&glad_glDeleteRenderbuffers,&deleteNames<Arg::renderbuffer,&glad_glDeleteRenderbuffers>>();
+            swapHook<in,&glad_glDeleteQueries,&deleteNames<Arg::query,&glad_glDeleteQueries>>();
+            swapHook<in,&glad_glCreateShader,&createShader>();
+            swapHook<in,&glad_glCreateProgram,&createProgram>();
+            swapHook<in,&glad_glGetUniformLocation,&getUniformLocation>();
+            swapHook<in,&glad_glGetUniformBlockIndex,&getUniformBlockIndex>();
+            swapHook<in,&glad_glUniformBlockBinding,&uniformBlockBinding>();
+            swapHook<in,&glad_glShaderSource,&shaderSource>();
+            swapHook<in,&glad_glBufferData,&bufferData>();
+            swapHook<in,&glad_glBufferSubData,&bufferSubData>();
+            swapHook<in,&glad_glMapBufferRange,&mapBufferRange>();
+            swapHook<in,&glad_glUnmapBuffer,&unmapBuffer>();
+            swapHook<in,&glad_glTexImage2D,&texImage2D>();
+            swapHook<in,&glad_glTexImage3D,&texImage3D>();
+            swapHook<in,&glad_glTexSubImage3D,&texSubImage3D>();
+            swapHook<in,&glad_glTexParameterfv,&texParameterfv>();
+            swapHook<in,&glad_glUniform3fv,&uniformVector<Special::uniform3fv,3,&glad_glUniform3fv>>();
+            swapHook<in,&glad_glUniform4fv,&uniformVector<Special::uniform4fv,4,&glad_glUniform4fv>>();
+            swapHook<in,&glad_glUniformMatrix3fv,&uniformMatrix<Special::uniformMatrix3fv,9,&glad_glUniformMatrix3fv>>();
+            swapHook<in,&glad_glUniformMatrix4fv,&uniformMatrix<Special::uniformMatrix4fv,16,&glad_glUniformMatrix4fv>>();
+            swapHook<in,&glad_glDrawBuffers,&drawBuffers>();
+            swapHook<in,&glad_glClearBufferfv,&clearBufferfv>();
+            swapHook<in,&glad_glFenceSync,&fenceSync>();
+            swapHook<in,&glad_glClientWaitSync,&clientWaitSync>();
+            swapHook<in,&glad_glDeleteSync,&deleteSync>();
+
+            [&]<std::size_t... I>(std::index_sequence<I...>){
+                if constexpr (in)
+                    (std::tuple_element_t<I,GLTrace::Calls>::install(static_cast<std::uint16_t>(GLTrace::firstCallOp + I)),...);
+                else
+                    (std::tuple_element_t<I,GLTrace::Calls>::uninstall(),...);
+            }(std::make_index_sequence<std::tuple_size_v<GLTrace::Calls>>{});
+        }
+
+        inline void flush()
+        {
+            const std::span<const std::byte> bytes{GLTrace::writer.bytes()};
+            file.write(reinterpret_cast<const char*>(bytes.data()),static_cast<std::streamsize>(bytes.size()));
+            GLTrace::writer.clear();
+        }
+    }
+
+    [[nodiscard]] inline bool isCapturing()
+    {
+        return Detail::file.is_open();
+    }
+
+    // right after the loader (and GLExtensions::load);width and height are the window's
+    inline bool begin(const std::string& path,const unsigned int frames,const unsigned int width,const unsigned int height)
+    {
+        Detail::file.open(path,std::ios::binary | std::ios::trunc);
+        if (!Detail::file || frames == 0)
+        {
+            std::cout << "GL CAPTURE: can't write " << path << '\n';
+            Detail::file.close();
+            return false;
+        }
+        Detail::path = path;
+        Detail::framesLeft = frames;
+        Detail::header = {GLTrace::magic,GLTrace::version,width,height,0};
+        Detail::file.write(reinterpret_cast<const char*>(&Detail::header),sizeof(Detail::header));
+        GLExtensions::persistentMapping = false; // written behind the hooks' back
+        Detail::swapHooks<true>();
+        std::cout << "GL CAPTURE: the first " << frames << " frames into " << path << '\n';
+        return true;
+    }
+
+    // the trace so far,the header's frame count fixed up
+    inline void finish()
+    {
+        if (!isCapturing())
+            return;
+        Detail::swapHooks<false>();
+        Detail::flush();
+        const auto size{static_cast<long long>(Detail::file.tellp())};
+        Detail::file.seekp(0);
+        Detail::file.write(reinterpret_cast<const char*>(&Detail::header),sizeof(Detail::header));
+        Detail::file.close();
+        Detail::mappings.clear();
+        std::cout << "GL CAPTURE: " << Detail::header.frames << " frames," << size / 1024 << " KB written to " << Detail::path << '\n';
+    }
+
+    // after every buffer swap
+    inline void endFrame()
+    {
+        if (!isCapturing())
+            return;
+        GLTrace::writer.op(GLTrace::Special::frameEnd);
+        ++Detail::header.frames;
+        Detail::flush();
+        if (--Detail::framesLeft == 0)
+            finish();
+    }
+}
+
+#endif //MYOPENPROJECT_GLCAPTURE_H
@@ -0,0 +1,62 @@
+#ifndef MYOPENPROJECT_GLEXTENSIONS_H
+#define MYOPENPROJECT_GLEXTENSIONS_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+// glad was generated for 3.3 core,so everything newer the engine can take advantage of is
+// loaded here by hand. Callers check the flags and keep a 3.3 path for when they are false.
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace GLExtensions
+{
+    using MultiDrawElementsIndirectProc = void (APIENTRYP)(GLenum mode,GLenum type,const void* indirect,GLsizei drawCount,GLsizei stride);
+
+    using BufferStorageProc = void (APIENTRYP)(GLenum target,GLsizeiptr size,const void* data,GLbitfield flags);
+
+    inline MultiDrawElementsIndirectProc multiDrawElementsIndirect{nullptr};
+    inline BufferStorageProc bufferStorage{nullptr};
+
+    inline int majorVersion{3};
+    inline int minorVersion{3};
+    inline bool multiDrawIndirect{false}; // glMultiDrawElementsIndirect + shader storage buffers,core since 4.3
+    inline bool persistentMapping{false}; // glBufferStorage with GL_MAP_PERSISTENT_BIT,core since 4.4
+
+    [[nodiscard]] inline bool atLeast(const int major,const int minor)
+    {
+        return majorVersion > major || (majorVersion == major && minorVersion >= minor);
+    }
+
+    // call right after gladLoadGLLoader,with the same loader
+    inline void load(GLADloadproc loader)
+    {
+        glGetIntegerv(GL_MAJOR_VERSION,&majorVersion);
+        glGetIntegerv(GL_MINOR_VERSION,&minorVersion);
+
+        if (atLeast(4,3))
+            multiDrawElementsIndirect = reinterpret_cast<MultiDrawElementsIndirectProc>(loader("glMultiDrawElementsIndirect"));
+        multiDrawIndirect = multiDrawElementsIndirect != nullptr;
+        if (atLeast(4,4))
+            bufferStorage = reinterpret_cast<BufferStorageProc>(loader("glBufferStorage"));
+        persistentMapping = bufferStorage != nullptr;
+
+        std::cout << "OPENGL: " << majorVersion << "." << minorVersion
+                  << "     MULTI DRAW INDIRECT: " << (multiDrawIndirect ? "YES" : "NO")
+                  << "     PERSISTENT MAPPING: " << (persistentMapping ? "YES" : "NO") << '\n';
+    }
+}
+
+#endif //MYOPENPROJECT_GLEXTENSIONS_H
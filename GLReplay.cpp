@@ -0,0 +1,469 @@
+// Plays back a GL trace written by the engine with --capture (GLCapture) as fast as it can and reports how long its
+// frames take,so driver changes and renderer optimizations can be compared on the same workload,without the assets,
+// the input or a visible window. The first frame (the loading,every object made) runs once and isn't timed;the
+// rest loop [loops] times,each ended with glFinish so its time includes the GPU's. Headless with llvmpipe:
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./GL_REPLAY trace.gltrace [loops]   loops defaults to 10
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "GLExtensions.h"
+#include "GLTrace.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    using GLTrace::Arg;
+    using GLTrace::Special;
+
+    // the names of the capture,mapped to the ones the replay got
+    class Names
+    {
+    public:
+        template<Arg kind,typename T>
+        T translate(const T value)
+        {
+            if constexpr (kind == Arg::value)
+                return value;
+            else if constexpr (kind == Arg::location)
+                return static_cast<T>(location(currentProgram,static_cast<GLint>(value)));
+            else
+            {
+                if constexpr (kind == Arg::usedProgram)
+                    currentProgram = static_cast<GLuint>(value);
+                return static_cast<T>(of(kind == Arg::usedProgram ? Arg::program : kind,static_cast<GLuint>(value)));
+            }
+        }
+
+        void add(const Arg kind,const GLuint captured,const GLuint replayed)
+        {
+            names[static_cast<std::size_t>(kind)][captured] = replayed;
+        }
+
+        [[nodiscard]] GLuint of(const Arg kind,const GLuint captured) const
+        {
+            const auto& map{names[static_cast<std::size_t>(kind)]};
+            const auto found{map.find(captured)};
+            return found != map.end() ? found->second : captured; // 0,the default objects
+        }
+
+        void addLocation(const GLuint program,const GLint captured,const GLint replayed)
+        {
+            locations[{program,captured}] = replayed;
+        }
+
+        [[nodiscard]] GLint location(const GLuint program,const GLint captured) const
+        {
+            if (captured < 0)
+                return captured;
+            const auto found{locations.find({program,captured})};
+            return found != locations.end() ? found->second : captured;
+        }
+
+        void addBlockIndex(const GLuint program,const GLuint captured,const GLuint replayed)
+        {
+            blockIndices[{program,captured}] = replayed;
+        }
+
+        [[nodiscard]] GLuint blockIndex(const GLuint program,const GLuint captured) const
+        {
+            const auto found{blockIndices.find({program,captured})};
+            return found != blockIndices.end() ? found->second : captured;
+        }
+
+        void addSync(const std::uint64_t captured,const GLsync sync)
+        {
+            syncs[captured] = sync;
+        }
+
+        [[nodiscard]] GLsync takeSync(const std::uint64_t captured) // deleted after
+        {
+            const auto found{syncs.find(captured)};
+            if (found == syncs.end())
+                return nullptr;
+            const GLsync sync{found->second};
+            syncs.erase(found);
+            return sync;
+        }
+
+        [[nodiscard]] GLsync sync(const std::uint64_t captured) const
+        {
+            const auto found{syncs.find(captured)};
+            return found != syncs.end() ? found->second : nullptr;
+        }
+
+    private:
+        std::array<std::unordered_map<GLuint,GLuint>,static_cast<std::size_t>(Arg::location) + 1> names{};
+        std::map<std::pair<GLuint,GLint>,GLint> locations;   // by the captured program
+        std::map<std::pair<GLuint,GLuint>,GLuint> blockIndices;
+        std::unordered_map<std::uint64_t,GLsync> syncs;
+        GLuint currentProgram{0}; // captured
+    };
+
+    using Replay = void (*)(GLTrace::Reader&,Names&);
+
+    template<std::size_t... I>
+    constexpr auto callTable(std::index_sequence<I...>)
+    {
+        return std::array<Replay,sizeof...(I)>{&std::tuple_element_t<I,GLTrace::Calls>::template replay<Names>...};
+    }
+
+    const auto calls{callTable(std::make_index_sequence<std::tuple_size_v<GLTrace::Calls>>{})};
+
+    template<typename T>
+    std::vector<T> valuesOf(const std::span<const std::byte> bytes)
+    {
+        std::vector<T> values(bytes.size() / sizeof(T));
+        std::copy_n(bytes.data(),values.size() * sizeof(T),reinterpret_cast<std::byte*>(values.data()));
+        return values;
+    }
+
+    const void* dataOf(const std::span<const std::byte> bytes)
+    {
+        return bytes.empty() ? nullptr : bytes.data();
+    }
+
+    void gen(const Arg kind,std::vector<GLuint>& replayed)
+    {
+        const auto count{static_cast<GLsizei>(replayed.size())};
+        switch (kind)
+        {
+            case Arg::buffer: glGenBuffers(count,replayed.data()); break;
+            case Arg::texture: glGenTextures(count,replayed.data()); break;
+            case Arg::vertexArray: glGenVertexArrays(count,replayed.data()); break;
+            case Arg::framebuffer: glGenFramebuffers(count,replayed.data()); break;
+            case Arg::renderbuffer: glGenRenderbuffers(count,replayed.data()); break;
+            case Arg::query: glGenQueries(count,replayed.data()); break;
+            default: break;
+        }
+    }
+
+    void deleteNames(const Arg kind,const std::vector<GLuint>& replayed)
+    {
+        const auto count{static_cast<GLsizei>(replayed.size())};
+        switch (kind)
+        {
+            case Arg::buffer: glDeleteBuffers(count,replayed.data()); break;
+            case Arg::texture: glDeleteTextures(count,replayed.data()); break;
+            case Arg::vertexArray: glDeleteVertexArrays(count,replayed.data()); break;
+            case Arg::framebuffer: glDeleteFramebuffers(count,replayed.data()); break;
+            case Arg::renderbuffer: glDeleteRenderbuffers(count,replayed.data()); break;
+            case Arg::query: glDeleteQueries(count,replayed.data()); break;
+            default: break;
+        }
+    }
+
+    // one record;false at the end of a frame
+    bool play(GLTrace::Reader& in,Names& names)
+    {
+        const auto op{in.get<std::uint16_t>()};
+        if (op >= GLTrace::firstCallOp)
+        {
+            calls.at(op - GLTrace::firstCallOp)(in,names);
+            return true;
+        }
+
+        switch (static_cast<Special>(op))
+        {
+            case Special::frameEnd:
+                return false;
+            case Special::gen:
+            {
+                const auto kind{in.get<Arg>()};
+                const std::vector<GLuint> captured{valuesOf<GLuint>(in.getBytes())};
+                std::vector<GLuint> replayed(captured.size());
+                gen(kind,replayed);
+                for (std::size_t i{0}; i < captured.size(); ++i)
+                    names.add(kind,captured[i],replayed[i]);
+                break;
+            }
+            case Special::deleteNames:
+            {
+                const auto kind{in.get<Arg>()};
+                std::vector<GLuint> replayed{valuesOf<GLuint>(in.getBytes())};
+                for (GLuint& name : replayed)
+                    name = names.of(kind,name);
+                deleteNames(kind,replayed);
+                break;
+            }
+            case Special::createShader:
+            {
+                const auto type{in.get<GLenum>()};
+                names.add(Arg::program,in.get<GLuint>(),glCreateShader(type));
+                break;
+            }
+            case Special::createProgram:
+                names.add(Arg::program,in.get<GLuint>(),glCreateProgram());
+                break;
+            case Special::uniformLocation:
+            {
+                const auto program{in.get<GLuint>()};
+                const std::string name{in.getString()};
+                names.addLocation(program,in.get<GLint>(),glGetUniformLocation(names.of(Arg::program,program),name.c_str()));
+                break;
+            }
+            case Special::uniformBlockIndex:
+            {
+                const auto program{in.get<GLuint>()};
+                const std::string name{in.getString()};
+                names.addBlockIndex(program,in.get<GLuint>(),glGetUniformBlockIndex(names.of(Arg::program,program),name.c_str()));
+                break;
+            }
+            case Special::uniformBlockBinding:
+            {
+                const auto program{in.get<GLuint>()};
+                const auto index{in.get<GLuint>()};
+                glUniformBlockBinding(names.of(Arg::program,program),names.blockIndex(program,index),in.get<GLuint>());
+                break;
+            }
+            case Special::shaderSource:
+            {
+                const GLuint shader{names.of(Arg::program,in.get<GLuint>())};
+                const auto count{in.get<GLsizei>()};
+                std::vector<const GLchar*> sources;
+                std::vector<GLint> lengths;
+                for (GLsizei i{0}; i < count; ++i)
+                {
+                    const std::string_view source{in.getString()};
+                    sources.push_back(source.data());
+                    lengths.push_back(static_cast<GLint>(source.size()));
+                }
+                glShaderSource(shader,count,sources.data(),lengths.data());
+                break;
+            }
+            case Special::bufferData:
+            {
+                const auto target{in.get<GLenum>()};
+                const auto usage{in.get<GLenum>()};
+                const auto size{in.get<GLsizeiptr>()};
+                const auto hasData{in.get<std::uint8_t>()};
+                const std::span<const std::byte> data{in.getBytes()};
+                glBufferData(target,size,hasData ? data.data() : nullptr,usage);
+                break;
+            }
+            case Special::bufferSubData:
+            {
+                const auto target{in.get<GLenum>()};
+                const auto offset{in.get<GLintptr>()};
+                const std::span<const std::byte> data{in.getBytes()};
+                glBufferSubData(target,offset,static_cast<GLsizeiptr>(data.size()),data.data());
+                break;
+            }
+            case Special::texImage2D:
+            {
+                std::array<GLint,8> v{};
+                for (GLint& value : v)
+                    value = in.get<GLint>();
+                glTexImage2D(static_cast<GLenum>(v[0]),v[1],v[2],v[3],v[4],v[5],static_cast<GLenum>(v[6]),static_cast<GLenum>(v[7]),dataOf(in.getBytes()));
+                break;
+            }
+            case Special::texImage3D:
+            {
+                std::array<GLint,9> v{};
+                for (GLint& value : v)
+                    value = in.get<GLint>();
+                glTexImage3D(static_cast<GLenum>(v[0]),v[1],v[2],v[3],v[4],v[5],v[6],static_cast<GLenum>(v[7]),static_cast<GLenum>(v[8]),dataOf(in.getBytes()));
+                break;
+            }
+            case Special::texSubImage3D:
+            {
+                std::array<GLint,10> v{};
+                for (GLint& value : v)
+                    value = in.get<GLint>();
+                glTexSubImage3D(static_cast<GLenum>(v[0]),v[1],v[2],v[3],v[4],v[5],v[6],v[7],static_cast<GLenum>(v[8]),static_cast<GLenum>(v[9]),dataOf(in.getBytes()));
+                break;
+            }
+            case Special::texParameterfv:
+            {
+                const auto target{in.get<GLenum>()};
+                const auto name{in.get<GLenum>()};
+                glTexParameterfv(target,name,valuesOf<GLfloat>(in.getBytes()).data());
+                break;
+            }
+            case Special::uniform3fv:
+            case Special::uniform4fv:
+            {
+                const GLint location{names.translate<Arg::location>(in.get<GLint>())};
+                const std::vector<GLfloat> values{valuesOf<GLfloat>(in.getBytes())};
+                if (static_cast<Special>(op) == Special::uniform3fv)
+                    glUniform3fv(location,static_cast<GLsizei>(values.size() / 3),values.data());
+                else
+                    glUniform4fv(location,static_cast<GLsizei>(values.size() / 4),values.data());
+                break;
+            }
+            case Special::uniformMatrix3fv:
+            case Special::uniformMatrix4fv:
+            {
+                const GLint location{names.translate<Arg::location>(in.get<GLint>())};
+                const auto transpose{in.get<GLboolean>()};
+                const std::vector<GLfloat> values{valuesOf<GLfloat>(in.getBytes())};
+                if (static_cast<Special>(op) == Special::uniformMatrix3fv)
+                    glUniformMatrix3fv(location,static_cast<GLsizei>(values.size() / 9),transpose,values.data());
+                else
+                    glUniformMatrix4fv(location,static_cast<GLsizei>(values.size() / 16),transpose,values.data());
+                break;
+            }
+            case Special::drawBuffers:
+            {
+                const std::vector<GLenum> buffers{valuesOf<GLenum>(in.getBytes())};
+                glDrawBuffers(static_cast<GLsizei>(buffers.size()),buffers.data());
+                break;
+            }
+            case Special::clearBufferfv:
+            {
+                const auto buffer{in.get<GLenum>()};
+                const auto drawBuffer{in.get<GLint>()};
+                glClearBufferfv(buffer,drawBuffer,valuesOf<GLfloat>(in.getBytes()).data());
+                break;
+            }
+            case Special::fenceSync:
+            {
+                const auto condition{in.get<GLenum>()};
+                const auto flags{in.get<GLbitfield>()};
+                names.addSync(in.get<std::uint64_t>(),glFenceSync(condition,flags));
+                break;
+            }
+            case Special::clientWaitSync:
+            {
+                const GLsync sync{names.sync(in.get<std::uint64_t>())};
+                const auto flags{in.get<GLbitfield>()};
+                const auto timeout{in.get<GLuint64>()};
+                if (sync)
+                    glClientWaitSync(sync,flags,timeout);
+                break;
+            }
+            case Special::deleteSync:
+                glDeleteSync(names.takeSync(in.get<std::uint64_t>()));
+                break;
+            case Special::count:
+                break;
+        }
+        return true;
+    }
+
+    // plays up to the frame's end,returns the milliseconds it took (glFinish included) and how many calls it made
+    std::pair<double,std::size_t> playFrame(GLTrace::Reader& in,Names& names)
+    {
+        const auto start{std::chrono::steady_clock::now()};
+        std::size_t records{0};
+        while (!in.atEnd() && play(in,names))
+            ++records;
+        glFinish();
+        const std::chrono::duration<double,std::milli> elapsed{std::chrono::steady_clock::now() - start};
+        return {elapsed.count(),records};
+    }
+
+    double percentile(std::vector<double> sorted,const double fraction)
+    {
+        std::ranges::sort(sorted);
+        return sorted[std::min(sorted.size() - 1,static_cast<std::size_t>(fraction * static_cast<double>(sorted.size())))];
+    }
+}
+
+int main(int argc,char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: GL_REPLAY trace.gltrace [loops]\n";
+        return 1;
+    }
+    const int loops{argc > 2 ? std::max(1,std::atoi(argv[2])) : 10};
+
+    std::ifstream file{argv[1],std::ios::binary};
+    const std::vector<char> contents{std::istreambuf_iterator<char>{file},std::istreambuf_iterator<char>{}};
+    GLTrace::Header header{};
+    if (contents.size() < sizeof(header))
+    {
+        std::cout << "can't read " << argv[1] << '\n';
+        return 1;
+    }
+    std::copy_n(contents.data(),sizeof(header),reinterpret_cast<char*>(&header));
+    if (header.magic != GLTrace::magic || header.version != GLTrace::version || header.frames < 2)
+    {
+        std::cout << argv[1] << " isn't a version " << GLTrace::version << " trace of at least two frames\n";
+        return 1;
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SAMPLES,4);
+    glfwWindowHint(GLFW_VISIBLE,GLFW_FALSE);
+    GLFWwindow* window{glfwCreateWindow(static_cast<int>(header.width),static_cast<int>(header.height),"GL replay",nullptr,nullptr)};
+    if (!window)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+        window = glfwCreateWindow(static_cast<int>(header.width),static_cast<int>(header.height),"GL replay",nullptr,nullptr);
+    }
+    if (!window)
+    {
+        std::cout << "Failed to create GLFW window\n";
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+    {
+        std::cout << "Failed to initialize GLAD\n";
+        return 1;
+    }
+    GLExtensions::load(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+    std::cout << "RENDERER: " << glGetString(GL_RENDERER) << '\n';
+
+    GLTrace::Reader in{std::as_bytes(std::span{contents}).subspan(sizeof(header))};
+    Names names;
+    std::vector<std::size_t> frameStarts; // of the frames after the first
+    const auto [setupMilliseconds,setupCalls]{playFrame(in,names)};
+    std::size_t callsPerLoop{0};
+    while (!in.atEnd())
+    {
+        frameStarts.push_back(in.offset());
+        callsPerLoop += playFrame(in,names).second;
+    }
+    std::cout << "TRACE: " << header.width << 'x' << header.height << "," << header.frames << " frames," << contents.size() / 1024
+              << " KB;the first frame " << std::fixed << std::setprecision(2) << setupMilliseconds << " ms," << setupCalls << " calls\n";
+
+    std::vector<double> frames;
+    const auto start{std::chrono::steady_clock::now()};
+    for (int loop{0}; loop < loops; ++loop)
+    {
+        for (const std::size_t frameStart : frameStarts)
+        {
+            in.seek(frameStart);
+            frames.push_back(playFrame(in,names).first);
+        }
+    }
+    const std::chrono::duration<double,std::milli> total{std::chrono::steady_clock::now() - start};
+
+    double sum{0.0};
+    for (const double milliseconds : frames)
+        sum += milliseconds;
+    std::cout << "REPLAY: " << frames.size() << " frames (" << frameStarts.size() << " x " << loops << " loops)," << callsPerLoop / std::max<std::size_t>(frameStarts.size(),1)
+              << " calls a frame\n"
+              << "  avg " << sum / static_cast<double>(frames.size()) << " ms   min " << percentile(frames,0.0) << "   median " << percentile(frames,0.5)
+              << "   p95 " << percentile(frames,0.95) << "   p99 " << percentile(frames,0.99) << "   max " << percentile(frames,1.0) << '\n'
+              << "  " << static_cast<double>(frames.size()) * 1000.0 / total.count() << " frames per second\n";
+
+    glfwTerminate();
+    return 0;
+}
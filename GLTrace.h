@@ -0,0 +1,354 @@
+#ifndef MYOPENPROJECT_GLTRACE_H
+#define MYOPENPROJECT_GLTRACE_H
+
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// The binary format GLCapture writes and GL_REPLAY plays back: a Header,then one record per GL call,an op (uint16)
+// followed by the call's arguments as they are in memory. Pointers to data (buffer contents,texture uploads,uniform
+// arrays,shader sources) are replaced by the data itself,a uint64 size and the bytes;pointers that are offsets into a
+// bound buffer (vertex attributes,indices,indirect draws) stay offsets. The names the driver handed out (buffers,
+// textures,programs,uniform locations,syncs..) are recorded as they were,the replay maps them to its own.
+// Calls that only read state back (glGet*,query results,framebuffer status) aren't recorded.
+//
+// Most calls take nothing but values and names;they are the Call entries of Calls,which hook and replay themselves
+// from their signature,their op is firstCallOp plus their index. The rest are the Special ops.
+namespace GLTrace
+{
+    constexpr std::uint32_t magic{0x52544C47}; // "GLTR"
+    constexpr std::uint32_t version{1};
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t width;  // of the window
+        std::uint32_t height;
+        std::uint32_t frames; // frameEnd records
+    };
+
+    // what an argument of a Call is,for the replay to map
+    enum class Arg : std::uint8_t
+    {
+        value,
+        buffer,
+        texture,
+        vertexArray,
+        framebuffer,
+        renderbuffer,
+        query,
+        program,     // shaders too,they share the names
+        usedProgram, // a program that becomes the current one,the uniform locations after it are its own
+        location,    // of a uniform of the current program
+    };
+
+    enum class Special : std::uint16_t
+    {
+        frameEnd,
+        gen,                // Arg,count,names
+        deleteNames,        // Arg,count,names
+        createShader,       // type,name
+        createProgram,      // name
+        uniformLocation,    // program,uniform name,location
+        uniformBlockIndex,  // program,block name,index
+        uniformBlockBinding,
+        shaderSource,       // shader,count,sources
+        bufferData,         // target,usage,size,whether there's data,data
+        bufferSubData,      // target,offset,data (also what was written to a mapped range)
+        texImage2D,
+        texImage3D,
+        texSubImage3D,
+        texParameterfv,
+        uniform3fv,
+        uniform4fv,
+        uniformMatrix3fv,
+        uniformMatrix4fv,
+        drawBuffers,
+        clearBufferfv,
+        fenceSync,          // condition,flags,sync
+        clientWaitSync,
+        deleteSync,
+        count,
+    };
+
+    constexpr std::uint16_t firstCallOp{static_cast<std::uint16_t>(Special::count)};
+
+    // the records,appended while capturing
+    class Writer
+    {
+    public:
+        template<typename T>
+        void put(const T& value)
+        {
+            const auto* bytes{reinterpret_cast<const std::byte*>(&value)};
+            data.insert(data.end(),bytes,bytes + sizeof(T));
+        }
+
+        void putBytes(const void* bytes,const std::size_t size)
+        {
+            put(static_cast<std::uint64_t>(size));
+            if (size)
+                data.insert(data.end(),static_cast<const std::byte*>(bytes),static_cast<const std::byte*>(bytes) + size);
+        }
+
+        void op(const Special special)
+        {
+            put(static_cast<std::uint16_t>(special));
+        }
+
+        [[nodiscard]] std::span<const std::byte> bytes() const
+        {
+            return data;
+        }
+
+        void clear()
+        {
+            data.clear();
+        }
+
+    private:
+        std::vector<std::byte> data;
+    };
+
+    inline Writer writer;
+
+    class Reader
+    {
+    public:
+        explicit Reader(const std::span<const std::byte> data)
+            : data{data}
+        {
+        }
+
+        template<typename T>
+        [[nodiscard]] T get()
+        {
+            T value;
+            std::memcpy(&value,data.data() + position,sizeof(T));
+            position += sizeof(T);
+            return value;
+        }
+
+        [[nodiscard]] std::span<const std::byte> getBytes()
+        {
+            const auto size{get<std::uint64_t>()};
+            const std::span<const std::byte> bytes{data.subspan(position,size)};
+            position += size;
+            return bytes;
+        }
+
+        [[nodiscard]] std::string_view getString()
+        {
+            const std::span<const std::byte> bytes{getBytes()};
+            return {reinterpret_cast<const char*>(bytes.data()),bytes.size()};
+        }
+
+        [[nodiscard]] bool atEnd() const
+        {
+            return position >= data.size();
+        }
+
+        [[nodiscard]] std::size_t offset() const
+        {
+            return position;
+        }
+
+        void seek(const std::size_t offset)
+        {
+            position = offset;
+        }
+
+    private:
+        std::span<const std::byte> data;
+        std::size_t position{0};
+    };
+
+    // what a texture upload reads from memory,rows padded to the unpack alignment
+    [[nodiscard]] inline std::size_t imageBytes(const int width,const int height,const int depth,const GLenum format,
+                                                const GLenum type,const int alignment)
+    {
+        std::size_t components{4};
+        switch (format)
+        {
+            case GL_RED:
+            case GL_RED_INTEGER:
+            case GL_DEPTH_COMPONENT:
+            case GL_STENCIL_INDEX:
+            case GL_DEPTH_STENCIL: // packed,its types count the whole texel
+                components = 1;
+                break;
+            case GL_RG:
+            case GL_RG_INTEGER:
+                components = 2;
+                break;
+            case GL_RGB:
+            case GL_BGR:
+            case GL_RGB_INTEGER:
+                components = 3;
+                break;
+            default:
+                break;
+        }
+        std::size_t component{1};
+        switch (type)
+        {
+            case GL_UNSIGNED_SHORT:
+            case GL_SHORT:
+            case GL_HALF_FLOAT:
+                component = 2;
+                break;
+            case GL_UNSIGNED_INT:
+            case GL_INT:
+            case GL_FLOAT:
+            case GL_UNSIGNED_INT_24_8:
+            case GL_UNSIGNED_INT_10F_11F_11F_REV:
+            case GL_UNSIGNED_INT_2_10_10_10_REV:
+                component = 4;
+                break;
+            case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+                component = 8;
+                break;
+            default:
+                break;
+        }
+        if (type == GL_UNSIGNED_INT_10F_11F_11F_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV)
+            components = 1;
+        const auto rowAlignment{static_cast<std::size_t>(alignment)};
+        const std::size_t row{(static_cast<std::size_t>(width) * components * component + rowAlignment - 1) / rowAlignment * rowAlignment};
+        return row * static_cast<std::size_t>(height) * static_cast<std::size_t>(depth);
+    }
+
+    // a GL call made only of values and names;pointer is the loader's function pointer (glad's,GLExtensions')
+    template<auto pointer,Arg... kinds>
+    struct Call;
+
+    template<typename R,typename... Args,R (APIENTRYP* pointer)(Args...),Arg... kinds>
+    struct Call<pointer,kinds...>
+    {
+        static_assert(sizeof...(Args) == sizeof...(kinds),"one Arg per parameter");
+
+        inline static R (APIENTRYP real)(Args...){nullptr};
+        inline static std::uint16_t op{0};
+
+        // GLCapture: records the call,then makes it
+        static R APIENTRY hook(Args... args)
+        {
+            writer.put(op);
+            (writer.put(args),...);
+            return real(args...);
+        }
+
+        static void install(const std::uint16_t callOp)
+        {
+            if (!*pointer || *pointer == &hook)
+                return;
+            op = callOp;
+            real = *pointer;
+            *pointer = &hook;
+        }
+
+        static void uninstall()
+        {
+            if (real && *pointer == &hook)
+                *pointer = real;
+        }
+
+        // GL_REPLAY: reads the arguments back and makes the call with its own names,map(kind,value) translates one
+        template<typename Map>
+        static void replay(Reader& in,Map& map)
+        {
+            std::tuple<Args...> args{in.get<Args>()...}; // braces,so they're read in order
+            call(args,map,std::index_sequence_for<Args...>{});
+        }
+
+    private:
+        template<typename Map,std::size_t... I>
+        static void call(std::tuple<Args...>& args,Map& map,std::index_sequence<I...>)
+        {
+            (*pointer)(map.template translate<kinds>(std::get<I>(args))...);
+        }
+    };
+
+    using V = Arg; // shorter rows below
+    using Calls = std::tuple<
+        Call<&glad_glActiveTexture,V::value>,
+        Call<&glad_glAttachShader,V::program,V::program>,
+        Call<&glad_glBeginConditionalRender,V::query,V::value>,
+        Call<&glad_glEndConditionalRender>,
+        Call<&glad_glBeginQuery,V::value,V::query>,
+        Call<&glad_glEndQuery,V::value>,
+        Call<&glad_glQueryCounter,V::query,V::value>,
+        Call<&glad_glBindBuffer,V::value,V::buffer>,
+        Call<&glad_glBindBufferBase,V::value,V::value,V::buffer>,
+        Call<&glad_glBindBufferRange,V::value,V::value,V::buffer,V::value,V::value>,
+        Call<&glad_glBindFramebuffer,V::value,V::framebuffer>,
+        Call<&glad_glBindRenderbuffer,V::value,V::renderbuffer>,
+        Call<&glad_glBindTexture,V::value,V::texture>,
+        Call<&glad_glBindVertexArray,V::vertexArray>,
+        Call<&glad_glBlendFunc,V::value,V::value>,
+        Call<&glad_glBlitFramebuffer,V::value,V::value,V::value,V::value,V::value,V::value,V::value,V::value,V::value,V::value>,
+        Call<&glad_glClear,V::value>,
+        Call<&glad_glClearColor,V::value,V::value,V::value,V::value>,
+        Call<&glad_glColorMask,V::value,V::value,V::value,V::value>,
+        Call<&glad_glCompileShader,V::program>,
+        Call<&glad_glCullFace,V::value>,
+        Call<&glad_glDeleteProgram,V::program>,
+        Call<&glad_glDeleteShader,V::program>,
+        Call<&glad_glDepthFunc,V::value>,
+        Call<&glad_glDepthMask,V::value>,
+        Call<&glad_glDepthRange,V::value,V::value>,
+        Call<&glad_glDisable,V::value>,
+        Call<&glad_glEnable,V::value>,
+        Call<&glad_glDisableVertexAttribArray,V::value>,
+        Call<&glad_glEnableVertexAttribArray,V::value>,
+        Call<&glad_glDrawArrays,V::value,V::value,V::value>,
+        Call<&glad_glDrawArraysInstanced,V::value,V::value,V::value,V::value>,
+        Call<&glad_glDrawBuffer,V::value>,
+        Call<&glad_glDrawElements,V::value,V::value,V::value,V::value>,
+        Call<&glad_glDrawElementsBaseVertex,V::value,V::value,V::value,V::value,V::value>,
+        Call<&glad_glDrawElementsInstanced,V::value,V::value,V::value,V::value,V::value>,
+        Call<&glad_glFramebufferRenderbuffer,V::value,V::value,V::value,V::renderbuffer>,
+        Call<&glad_glFramebufferTexture,V::value,V::value,V::texture,V::value>,
+        Call<&glad_glFramebufferTexture2D,V::value,V::value,V::value,V::texture,V::value>,
+        Call<&glad_glFramebufferTextureLayer,V::value,V::value,V::texture,V::value,V::value>,
+        Call<&glad_glGenerateMipmap,V::value>,
+        Call<&glad_glLinkProgram,V::program>,
+        Call<&glad_glPixelStorei,V::value,V::value>,
+        Call<&glad_glPolygonMode,V::value,V::value>,
+        Call<&glad_glPolygonOffset,V::value,V::value>,
+        Call<&glad_glReadBuffer,V::value>,
+        Call<&glad_glRenderbufferStorage,V::value,V::value,V::value,V::value>,
+        Call<&glad_glRenderbufferStorageMultisample,V::value,V::value,V::value,V::value,V::value>,
+        Call<&glad_glTexBuffer,V::value,V::value,V::buffer>,
+        Call<&glad_glTexImage2DMultisample,V::value,V::value,V::value,V::value,V::value,V::value>,
+        Call<&glad_glTexParameteri,V::value,V::value,V::value>,
+        Call<&glad_glUniform1f,V::location,V::value>,
+        Call<&glad_glUniform1i,V::location,V::value>,
+        Call<&glad_glUniform1ui,V::location,V::value>,
+        Call<&glad_glUniform2f,V::location,V::value,V::value>,
+        Call<&glad_glUniform2ui,V::location,V::value,V::value>,
+        Call<&glad_glUniform3f,V::location,V::value,V::value,V::value>,
+        Call<&glad_glUniform3ui,V::location,V::value,V::value,V::value>,
+        Call<&glad_glUniform4f,V::location,V::value,V::value,V::value,V::value>,
+        Call<&glad_glUniform4i,V::location,V::value,V::value,V::value,V::value>,
+        Call<&glad_glUseProgram,V::usedProgram>,
+        Call<&glad_glVertexAttrib4f,V::value,V::value,V::value,V::value,V::value>,
+        Call<&glad_glVertexAttribDivisor,V::value,V::value>,
+        Call<&glad_glVertexAttribI4ui,V::value,V::value,V::value,V::value,V::value>,
+        Call<&glad_glVertexAttribIPointer,V::value,V::value,V::value,V::value,V::value>,          // the pointer is an offset
+        Call<&glad_glVertexAttribPointer,V::value,V::value,V::value,V::value,V::value,V::value>,
+        Call<&glad_glViewport,V::value,V::value,V::value,V::value>,
+        Call<&GLExtensions::multiDrawElementsIndirect,V::value,V::value,V::value,V::value,V::value> // into the indirect buffer
+    >;
+}
+
+#endif //MYOPENPROJECT_GLTRACE_H
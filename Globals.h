@@ -8,9 +8,15 @@ namespace Globals
     static constexpr unsigned int SCREEN_HEIGHT{600};
     static constexpr unsigned int SHADOW_WIDTH{1024};
     static constexpr unsigned int SHADOW_HEIGHT{1024};
+    static constexpr unsigned int POINT_SHADOW_SIZE{256}; // a face of a point light's cube
 
     static constexpr int SAMPLE_NUMBER{4};
 
+    static constexpr double TARGET_FRAME_MILLISECONDS{16.6}; // of GPU time,DynamicResolution scales the scene to stay under it
+    static constexpr float MIN_RENDER_SCALE{0.5f};
+    static constexpr float MAX_RENDER_SCALE{1.0f};
+    static constexpr float TAA_UPSCALE_SCALE{0.67f}; // of the window,the scene's resolution with temporal upscaling
+
     static float FOV{60.0f};
     static constexpr float MIN_FOV{10.0f};
     static constexpr float MAX_FOV{60.0f};
@@ -28,7 +34,44 @@ namespace Globals
     static bool gammaCorrected{false};
     static bool hasActivatedGamma{false};
 
-    static bool shadowPass{false};
+    static bool postEffects[4]{false,false,false,false}; // sharpen,blur,tone mapping,color grading,keys 1 to 4
+    static bool hasToggledPostEffect[4]{false,false,false,false};
+
+    static bool hasToggledShadows{false}; // the switch itself is CascadedShadowMap::enabled
+    static bool hasToggledPointShadows{false}; // the switch itself is PointShadowAtlas::enabled
+
+    static bool indirectDraw{true}; // multi-draw indirect for the backpack,when the context supports it
+    static bool hasToggledIndirect{false};
+
+    static bool occlusionCulling{true}; // software depth buffer test after the frustum test
+    static bool hasToggledOcclusion{false};
+
+    static bool hasToggledQueries{false}; // the switch itself is OcclusionQueries::enabled
+
+    static bool orderIndependentTransparency{false}; // weighted blended OIT for the windows instead of sorting them
+    static bool hasToggledOIT{false};
+
+    static bool clusteredLighting{true}; // shader.fs walks its cluster's light list instead of the pointLights array
+    static bool hasToggledClustered{false};
+    static bool manyLights{false};       // adds MANY_LIGHTS small orbiting lights,only lit with clusteredLighting
+    static bool hasToggledManyLights{false};
+    static constexpr unsigned int MANY_LIGHTS{2048};
+
+    static bool deferredShading{false}; // the backpack through a G-buffer and light volumes,lit like the clustered forward path
+    static bool hasToggledDeferred{false};
+
+    static bool hasToggledPrepass{false}; // the mode itself is DepthPrepass::mode
+
+    static bool dumpFrameGraph{false}; // prints the next compiled frame graph
+    static bool hasRequestedDump{false};
+
+    static bool printGpuProfile{false}; // prints GpuProfiler's per pass times once
+    static bool hasRequestedProfile{false};
+
+    static double sceneTime{0.0}; // seconds the scene animates by,glfwGetTime() or the benchmark's fixed steps
+
+    static bool hasToggledDynamicResolution{false}; // the switch itself is DynamicResolution::enabled
+    static bool hasToggledAntiAliasing{false};      // the mode itself is AntiAliasing::mode
 
 }
 
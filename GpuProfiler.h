@@ -0,0 +1,217 @@
+#ifndef MYOPENPROJECT_GPUPROFILER_H
+#define MYOPENPROJECT_GPUPROFILER_H
+
+#include <glad/glad.h>
+
+#include "GpuTimer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// GPU time of every section of a frame: begin(name) and end() put a GL_TIMESTAMP query on each side of it,
+// so sections can nest (a frame graph pass and the draws inside it) and don't clash with the GL_TIME_ELAPSED
+// timers elsewhere. The stamps go through one QueryRing,the pool: they're read back in the order they were
+// issued and only once the GPU has them,several frames later;stamp() only waits when stampCapacity stamps
+// are in flight. A section that runs more than once a frame counts the sum. The min,avg and max are over
+// the last window frames the section ran in;print() shows them indented by how deep the section sits.
+// Sections must not nest inside themselves.
+class GpuProfiler
+{
+public:
+    static constexpr unsigned int stampCapacity{512}; // a frame takes two per section,so several frames of them
+    static constexpr std::size_t window{120};
+
+    struct Stats {
+        std::string_view name;
+        unsigned int depth;
+        double last;  // milliseconds
+        double min;
+        double average;
+        double max;
+        std::size_t frames;
+        bool latest;  // ran in the last frame read back
+    };
+
+    // begin() in the constructor,end() in the destructor
+    class Scope
+    {
+    public:
+        Scope(GpuProfiler* profiler,const std::string_view name) // null profiles nothing
+            : profiler{profiler}
+        {
+            if (profiler)
+                profiler->begin(name);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope()
+        {
+            if (profiler)
+                profiler->end();
+        }
+
+    private:
+        GpuProfiler* profiler;
+    };
+
+    // before the frame's first pass;the whole frame is the "frame" section
+    void beginFrame()
+    {
+        begin("frame");
+    }
+
+    void begin(const std::string_view name)
+    {
+        const std::uint32_t section{sectionOf(name)};
+        open.push_back(section);
+        stamps.stamp();
+        events.push_back({section,true,false});
+    }
+
+    void end()
+    {
+        const std::uint32_t section{open.back()};
+        open.pop_back();
+        stamps.stamp();
+        events.push_back({section,false,open.empty()});
+    }
+
+    // after the frame's last pass;takes in the results that came back
+    void endFrame()
+    {
+        end();
+        collectResults();
+    }
+
+    // frames whose stamps all came back
+    [[nodiscard]] std::uint64_t frames() const
+    {
+        return completedFrames;
+    }
+
+    // of every section seen in the last window frames,in the order they first ran
+    [[nodiscard]] std::vector<Stats> stats() const
+    {
+        std::vector<Stats> result;
+        for (const Section& section : sections)
+        {
+            if (section.samples.empty() || completedFrames - section.lastFrame > window)
+                continue;
+            double sum{0.0};
+            double min{std::numeric_limits<double>::max()};
+            double max{0.0};
+            for (const double milliseconds : section.samples)
+            {
+                sum += milliseconds;
+                min = std::min(min,milliseconds);
+                max = std::max(max,milliseconds);
+            }
+            const double last{section.samples[(section.next + section.samples.size() - 1) % section.samples.size()]};
+            result.push_back({section.name,section.depth,last,min,sum / static_cast<double>(section.samples.size()),max,section.samples.size(),
+                              section.lastFrame == completedFrames});
+        }
+        return result;
+    }
+
+    void print(std::ostream& out) const
+    {
+        out << "GPU PROFILE: ms over the last " << window << " frames,results " << stamps.inFlight() << " stamps behind\n"
+            << "  " << std::left << std::setw(24) << "section" << std::right
+            << std::setw(9) << "last" << std::setw(9) << "min" << std::setw(9) << "avg" << std::setw(9) << "max" << '\n'
+            << std::fixed << std::setprecision(3);
+        for (const Stats& section : stats())
+        {
+            out << "  " << std::string(2 * section.depth,' ') << std::left << std::setw(24 - static_cast<int>(std::min(2 * section.depth,22u)))
+                << section.name << std::right << std::setw(9) << section.last << std::setw(9) << section.min
+                << std::setw(9) << section.average << std::setw(9) << section.max << '\n';
+        }
+        out << std::defaultfloat;
+    }
+
+private:
+    struct Section {
+        std::string name;
+        unsigned int depth;                 // sections open around it when it first ran
+        std::vector<double> samples;        // ring of the last window frames' times
+        std::size_t next{0};
+        std::uint64_t lastFrame{0};         // the last completed frame it ran in
+        std::uint64_t start{0};             // of the run being read back
+        double frameMilliseconds{0.0};      // summed over the frame being read back
+        bool ran{false};
+    };
+
+    struct Event { // what a stamp in flight was for
+        std::uint32_t section;
+        bool opens;
+        bool closesFrame;
+    };
+
+    QueryRing stamps{GL_TIMESTAMP,stampCapacity};
+    std::deque<Event> events;        // one per stamp in flight,in the same order
+    std::vector<Section> sections;
+    std::vector<std::uint32_t> open; // on the CPU side
+    std::uint64_t completedFrames{0};
+
+    [[nodiscard]] std::uint32_t sectionOf(const std::string_view name)
+    {
+        for (std::uint32_t i{0}; i < sections.size(); ++i)
+        {
+            if (sections[i].name == name)
+                return i;
+        }
+        sections.push_back({std::string{name},static_cast<unsigned int>(open.size()),{},0,0,0,0.0,false});
+        sections.back().samples.reserve(window);
+        return static_cast<std::uint32_t>(sections.size() - 1);
+    }
+
+    void collectResults()
+    {
+        while (const std::optional<std::uint64_t> stamp{stamps.poll()})
+        {
+            const Event event{events.front()};
+            events.pop_front();
+            Section& section{sections[event.section]};
+            if (event.opens)
+            {
+                section.start = *stamp;
+                continue;
+            }
+            section.frameMilliseconds += static_cast<double>(*stamp - section.start) / 1'000'000.0;
+            section.ran = true;
+            if (event.closesFrame)
+                completeFrame();
+        }
+    }
+
+    // every stamp of a frame came back
+    void completeFrame()
+    {
+        ++completedFrames;
+        for (Section& section : sections)
+        {
+            if (!section.ran)
+                continue;
+            if (section.samples.size() < window)
+                section.samples.push_back(section.frameMilliseconds);
+            else
+                section.samples[section.next] = section.frameMilliseconds;
+            section.next = (section.next + 1) % window;
+            section.lastFrame = completedFrames;
+            section.frameMilliseconds = 0.0;
+            section.ran = false;
+        }
+    }
+};
+
+#endif //MYOPENPROJECT_GPUPROFILER_H
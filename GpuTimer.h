@@ -0,0 +1,124 @@
+#ifndef MYOPENPROJECT_GPUTIMER_H
+#define MYOPENPROJECT_GPUTIMER_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+// A ring of GL queries of one target (GL_TIME_ELAPSED,GL_SAMPLES_PASSED,GL_TIMESTAMP...) whose results are read back
+// in the order they were issued and only once the GPU has them,a few frames later,so reading never stalls.
+// Only if every query of the ring is still in flight does begin() (or stamp()) wait for the oldest one.
+class QueryRing
+{
+public:
+    explicit QueryRing(const GLenum target,const unsigned int capacity = 8)
+        : target{target},queries(capacity)
+    {
+        glGenQueries(static_cast<int>(capacity),queries.data());
+    }
+
+    QueryRing(const QueryRing&) = delete;
+    QueryRing& operator=(const QueryRing&) = delete;
+
+    ~QueryRing()
+    {
+        glDeleteQueries(static_cast<int>(queries.size()),queries.data());
+    }
+
+    void begin()
+    {
+        if (issued - read == queries.size()) // full,the oldest result has to come back first
+            waitForOldest();
+        glBeginQuery(target,queries[issued % queries.size()]);
+    }
+
+    void end()
+    {
+        glEndQuery(target);
+        ++issued;
+    }
+
+    // GL_TIMESTAMP has no begin and end: the GPU clock,in nanoseconds,once the commands before it are done.
+    // Unlike GL_TIME_ELAPSED these can be issued while another timer runs
+    void stamp()
+    {
+        if (issued - read == queries.size())
+            waitForOldest();
+        glQueryCounter(queries[issued % queries.size()],GL_TIMESTAMP);
+        ++issued;
+    }
+
+    // the oldest result that hasn't been returned yet,if the GPU is done with it
+    [[nodiscard]] std::optional<std::uint64_t> poll()
+    {
+        if (!ready.empty())
+        {
+            const std::uint64_t result{ready.front()};
+            ready.pop_front();
+            return result;
+        }
+        if (read == issued)
+            return std::nullopt;
+
+        const unsigned int query{queries[read % queries.size()]};
+        int available{0};
+        glGetQueryObjectiv(query,GL_QUERY_RESULT_AVAILABLE,&available);
+        if (!available)
+            return std::nullopt;
+        GLuint64 result{0};
+        glGetQueryObjectui64v(query,GL_QUERY_RESULT,&result);
+        ++read;
+        return result;
+    }
+
+    [[nodiscard]] unsigned int inFlight() const
+    {
+        return issued - read + static_cast<unsigned int>(ready.size());
+    }
+
+private:
+    GLenum target;
+    std::vector<unsigned int> queries;
+    std::deque<std::uint64_t> ready; // fetched early by waitForOldest,older than anything still in flight
+    unsigned int issued{0};
+    unsigned int read{0};
+
+    void waitForOldest()
+    {
+        GLuint64 result{0};
+        glGetQueryObjectui64v(queries[read % queries.size()],GL_QUERY_RESULT,&result); // blocks
+        ready.push_back(result);
+        ++read;
+    }
+};
+
+// GPU time of a stretch of GL commands,in milliseconds,a few frames late. GL_TIME_ELAPSED queries
+// can't nest,so only one timer may be between begin() and end() at a time.
+class GpuTimer
+{
+public:
+    void begin()
+    {
+        ring.begin();
+    }
+
+    void end()
+    {
+        ring.end();
+    }
+
+    [[nodiscard]] std::optional<double> poll()
+    {
+        if (const std::optional<std::uint64_t> nanoseconds{ring.poll()})
+            return static_cast<double>(*nanoseconds) / 1'000'000.0;
+        return std::nullopt;
+    }
+
+private:
+    QueryRing ring{GL_TIME_ELAPSED};
+};
+
+#endif //MYOPENPROJECT_GPUTIMER_H
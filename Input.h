@@ -3,11 +3,19 @@
 #include <GLFW/glfw3.h>
 #include "Globals.h"
 #include "Camera.h"
+#include "OcclusionQueries.h"
+#include "DepthPrepass.h"
+#include "CascadedShadowMap.h"
+#include "PointShadowAtlas.h"
+#include "DynamicResolution.h"
+#include "AntiAliasing.h"
+#include "CpuProfiler.h"
 
 namespace Input
 {
     inline void generalInput(GLFWwindow *window) // defines which keys,when pressed,perform which functions;escape closes the window
     {
+        PROFILE_FUNCTION();
         if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(window, true);
 
@@ -38,10 +46,89 @@ namespace Input
             Globals::gammaCorrected = !Globals::gammaCorrected;
             Globals::hasActivatedGamma = true;
         }else if (glfwGetKey(window,GLFW_KEY_V) == GLFW_RELEASE) {Globals::hasActivatedGamma = false;}
+
+        for (int i{0}; i < 4; ++i){   // the post-processing effects
+            if (glfwGetKey(window,GLFW_KEY_1 + i) == GLFW_PRESS && !Globals::hasToggledPostEffect[i]){
+                Globals::postEffects[i] = !Globals::postEffects[i];
+                Globals::hasToggledPostEffect[i] = true;
+            }else if (glfwGetKey(window,GLFW_KEY_1 + i) == GLFW_RELEASE) {Globals::hasToggledPostEffect[i] = false;}
+        }
+
+        if (glfwGetKey(window,GLFW_KEY_I) == GLFW_PRESS && !Globals::hasToggledIndirect){   // multi-draw indirect against one draw per mesh
+            Globals::indirectDraw = !Globals::indirectDraw;
+            Globals::hasToggledIndirect = true;
+        }else if (glfwGetKey(window,GLFW_KEY_I) == GLFW_RELEASE) {Globals::hasToggledIndirect = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_O) == GLFW_PRESS && !Globals::hasToggledOcclusion){   // CPU occlusion culling on and off
+            Globals::occlusionCulling = !Globals::occlusionCulling;
+            Globals::hasToggledOcclusion = true;
+        }else if (glfwGetKey(window,GLFW_KEY_O) == GLFW_RELEASE) {Globals::hasToggledOcclusion = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_Q) == GLFW_PRESS && !Globals::hasToggledQueries){   // hardware occlusion queries in Model::Draw
+            OcclusionQueries::enabled = !OcclusionQueries::enabled;
+            Globals::hasToggledQueries = true;
+        }else if (glfwGetKey(window,GLFW_KEY_Q) == GLFW_RELEASE) {Globals::hasToggledQueries = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_T) == GLFW_PRESS && !Globals::hasToggledOIT){   // order independent transparency against sorted windows
+            Globals::orderIndependentTransparency = !Globals::orderIndependentTransparency;
+            Globals::hasToggledOIT = true;
+        }else if (glfwGetKey(window,GLFW_KEY_T) == GLFW_RELEASE) {Globals::hasToggledOIT = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_C) == GLFW_PRESS && !Globals::hasToggledClustered){   // clustered lights against the fixed light array
+            Globals::clusteredLighting = !Globals::clusteredLighting;
+            Globals::hasToggledClustered = true;
+        }else if (glfwGetKey(window,GLFW_KEY_C) == GLFW_RELEASE) {Globals::hasToggledClustered = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_L) == GLFW_PRESS && !Globals::hasToggledManyLights){   // thousands of extra lights
+            Globals::manyLights = !Globals::manyLights;
+            Globals::hasToggledManyLights = true;
+        }else if (glfwGetKey(window,GLFW_KEY_L) == GLFW_RELEASE) {Globals::hasToggledManyLights = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_G) == GLFW_PRESS && !Globals::hasToggledDeferred){   // deferred against forward shading,for A/B comparisons
+            Globals::deferredShading = !Globals::deferredShading;
+            Globals::hasToggledDeferred = true;
+        }else if (glfwGetKey(window,GLFW_KEY_G) == GLFW_RELEASE) {Globals::hasToggledDeferred = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_P) == GLFW_PRESS && !Globals::hasToggledPrepass){   // depth pre-pass: automatic,on,off
+            DepthPrepass::mode = DepthPrepass::mode == DepthPrepass::Mode::automatic ? DepthPrepass::Mode::on
+                               : DepthPrepass::mode == DepthPrepass::Mode::on ? DepthPrepass::Mode::off : DepthPrepass::Mode::automatic;
+            Globals::hasToggledPrepass = true;
+        }else if (glfwGetKey(window,GLFW_KEY_P) == GLFW_RELEASE) {Globals::hasToggledPrepass = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_K) == GLFW_PRESS && !Globals::hasRequestedDump){   // prints the compiled frame graph once
+            Globals::dumpFrameGraph = true;
+            Globals::hasRequestedDump = true;
+        }else if (glfwGetKey(window,GLFW_KEY_K) == GLFW_RELEASE) {Globals::hasRequestedDump = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_M) == GLFW_PRESS && !Globals::hasRequestedProfile){   // prints the GPU time of every pass once
+            Globals::printGpuProfile = true;
+            Globals::hasRequestedProfile = true;
+        }else if (glfwGetKey(window,GLFW_KEY_M) == GLFW_RELEASE) {Globals::hasRequestedProfile = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_R) == GLFW_PRESS && !Globals::hasToggledDynamicResolution){   // dynamic resolution against the window's
+            DynamicResolution::enabled = !DynamicResolution::enabled;
+            Globals::hasToggledDynamicResolution = true;
+        }else if (glfwGetKey(window,GLFW_KEY_R) == GLFW_RELEASE) {Globals::hasToggledDynamicResolution = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_N) == GLFW_PRESS && !Globals::hasToggledAntiAliasing){   // anti-aliasing: MSAA,FXAA,SMAA,TAA,TAA upscaling
+            AntiAliasing::mode = static_cast<AntiAliasing::Mode>((static_cast<std::size_t>(AntiAliasing::mode) + 1) % AntiAliasing::modeCount);
+            Globals::hasToggledAntiAliasing = true;
+        }else if (glfwGetKey(window,GLFW_KEY_N) == GLFW_RELEASE) {Globals::hasToggledAntiAliasing = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_H) == GLFW_PRESS && !Globals::hasToggledShadows){   // cascaded shadows of the directional light
+            CascadedShadowMap::enabled = !CascadedShadowMap::enabled;
+            Globals::hasToggledShadows = true;
+        }else if (glfwGetKey(window,GLFW_KEY_H) == GLFW_RELEASE) {Globals::hasToggledShadows = false;}
+
+        if (glfwGetKey(window,GLFW_KEY_J) == GLFW_PRESS && !Globals::hasToggledPointShadows){   // shadows of the moving point lights
+            PointShadowAtlas::enabled = !PointShadowAtlas::enabled;
+            Globals::hasToggledPointShadows = true;
+        }else if (glfwGetKey(window,GLFW_KEY_J) == GLFW_RELEASE) {Globals::hasToggledPointShadows = false;}
     }
 
     inline void movementInput(GLFWwindow *window,Camera& myCamera,const float deltaTime)
     {
+        PROFILE_FUNCTION();
         if (glfwGetKey(window,GLFW_KEY_W) == GLFW_PRESS)
         {
             myCamera.ProcessKeyboard(FORWARD,deltaTime);
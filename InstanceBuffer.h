@@ -0,0 +1,236 @@
+#ifndef MYOPENPROJECT_INSTANCEBUFFER_H
+#define MYOPENPROJECT_INSTANCEBUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "GLExtensions.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+// Per-instance vertex streams for instanced draws: a transform,a color,a material index and how far the instance
+// moved since the last frame per instance,read with glVertexAttribDivisor(1) from attribute locations 8-14
+// (see lightingshader.vs,shader.vs and velocity.vs).
+// The data lives in one ring buffer split into one region per frame in flight. Each frame writes its
+// instances into the next free region and fences it when it's done,so the CPU never writes over
+// instances the GPU may still be reading. With GL 4.4 the buffer is mapped once,persistently and coherently,
+// and upload() is a plain memcpy;on older contexts every upload maps its range unsynchronized,which the fences make safe.
+//
+// Programs that declare the instance attributes still work for vertex arrays without them:
+// setDefaults() makes the constant values of the locations an identity transform,white,material 0 and no motion.
+class InstanceBuffer
+{
+public:
+    struct Instance {
+        glm::mat4 transform{1.0f};
+        glm::vec4 color{1.0f};
+        unsigned int material{};      // shader.vs: the variant of the mesh's maps,that many layers past its own in their arrays
+        glm::vec3 displacement{0.0f}; // world space,since the last frame;for the motion vectors of TemporalAA
+    };
+
+    // instances of one upload,ready to be bound to whatever vao draws them
+    struct Range {
+        unsigned int buffer{};
+        std::size_t offset{};   // bytes
+        int count{};
+    };
+
+    static constexpr unsigned int transformLocation{8}; // a mat4 takes 8,9,10 and 11
+    static constexpr unsigned int colorLocation{12};
+    static constexpr unsigned int materialLocation{13};
+    static constexpr unsigned int displacementLocation{14};
+    static constexpr unsigned int framesInFlight{3};
+
+    explicit InstanceBuffer(const std::size_t instancesPerFrame = 4096)
+    {
+        allocate(instancesPerFrame);
+        setDefaults();
+    }
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    ~InstanceBuffer()
+    {
+        release();
+    }
+
+    // waits for the GPU to be done with the region this frame is going to write;with three regions it almost never has to
+    void beginFrame()
+    {
+        if (GLsync& fence = fences[region]; fence)
+        {
+            while (glClientWaitSync(fence,GL_SYNC_FLUSH_COMMANDS_BIT,1'000'000) == GL_TIMEOUT_EXPIRED) {}
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+        used = 0;
+    }
+
+    // after the last draw that reads this frame's instances
+    void endFrame()
+    {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+        region = (region + 1) % framesInFlight;
+        for (const unsigned int oldBuffer : retired) // GL keeps the storage alive until the queued draws are done with it
+            glDeleteBuffers(1,&oldBuffer);
+        retired.clear();
+    }
+
+    [[nodiscard]] Range upload(std::span<const Instance> instances)
+    {
+        if (instances.empty())
+            return {};
+        if (used + instances.size() > capacity)
+            grow(std::max(capacity * 2,used + instances.size()));
+
+        const std::size_t offset{(region * capacity + used) * sizeof(Instance)};
+        const std::size_t size{instances.size_bytes()};
+        if (mapped)
+        {
+            std::memcpy(mapped + offset,instances.data(),size);
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER,buffer);
+            void* destination{glMapBufferRange(GL_ARRAY_BUFFER,static_cast<GLintptr>(offset),static_cast<GLsizeiptr>(size),
+                                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT)};
+            if (destination)
+            {
+                std::memcpy(destination,instances.data(),size);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER,0);
+        }
+        used += instances.size();
+        return {buffer,offset,static_cast<int>(instances.size())};
+    }
+
+    // points the instance attributes of the bound vao at range
+    static void bindAttributes(const Range& range)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER,range.buffer);
+        for (unsigned int column{0}; column < 4; ++column)
+        {
+            glEnableVertexAttribArray(transformLocation + column);
+            glVertexAttribPointer(transformLocation + column,4,GL_FLOAT,GL_FALSE,sizeof(Instance),
+                reinterpret_cast<void*>(range.offset + offsetof(Instance,transform) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(transformLocation + column,1);
+        }
+        glEnableVertexAttribArray(colorLocation);
+        glVertexAttribPointer(colorLocation,4,GL_FLOAT,GL_FALSE,sizeof(Instance),reinterpret_cast<void*>(range.offset + offsetof(Instance,color)));
+        glVertexAttribDivisor(colorLocation,1);
+        glEnableVertexAttribArray(materialLocation);
+        glVertexAttribIPointer(materialLocation,1,GL_UNSIGNED_INT,sizeof(Instance),reinterpret_cast<void*>(range.offset + offsetof(Instance,material)));
+        glVertexAttribDivisor(materialLocation,1);
+        glEnableVertexAttribArray(displacementLocation);
+        glVertexAttribPointer(displacementLocation,3,GL_FLOAT,GL_FALSE,sizeof(Instance),reinterpret_cast<void*>(range.offset + offsetof(Instance,displacement)));
+        glVertexAttribDivisor(displacementLocation,1);
+        glBindBuffer(GL_ARRAY_BUFFER,0);
+    }
+
+    // back to the constant values for the bound vao,so its non-instanced draws don't read the last range
+    static void unbindAttributes()
+    {
+        for (unsigned int location{transformLocation}; location <= displacementLocation; ++location)
+            glDisableVertexAttribArray(location);
+    }
+
+    // the constant attribute values are context state,they only need setting once
+    static void setDefaults()
+    {
+        glVertexAttrib4f(transformLocation,1.0f,0.0f,0.0f,0.0f);
+        glVertexAttrib4f(transformLocation + 1,0.0f,1.0f,0.0f,0.0f);
+        glVertexAttrib4f(transformLocation + 2,0.0f,0.0f,1.0f,0.0f);
+        glVertexAttrib4f(transformLocation + 3,0.0f,0.0f,0.0f,1.0f);
+        glVertexAttrib4f(colorLocation,1.0f,1.0f,1.0f,1.0f);
+        glVertexAttribI4ui(materialLocation,0,0,0,0);
+        glVertexAttrib4f(displacementLocation,0.0f,0.0f,0.0f,0.0f);
+    }
+
+    [[nodiscard]] std::size_t instancesPerFrame() const
+    {
+        return capacity;
+    }
+
+private:
+    unsigned int buffer{};
+    std::uint8_t* mapped{nullptr};
+    std::size_t capacity{};     // instances per region
+    std::size_t used{};
+    unsigned int region{};
+    std::array<GLsync,framesInFlight> fences{};
+    std::vector<unsigned int> retired;
+
+    void allocate(const std::size_t instancesPerFrame)
+    {
+        capacity = instancesPerFrame;
+        const auto size{static_cast<GLsizeiptr>(capacity * framesInFlight * sizeof(Instance))};
+
+        glGenBuffers(1,&buffer);
+        glBindBuffer(GL_ARRAY_BUFFER,buffer);
+        if (GLExtensions::persistentMapping)
+        {
+            constexpr GLbitfield flags{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+            GLExtensions::bufferStorage(GL_ARRAY_BUFFER,size,nullptr,flags);
+            mapped = static_cast<std::uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER,0,size,flags));
+        }
+        else
+        {
+            glBufferData(GL_ARRAY_BUFFER,size,nullptr,GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER,0);
+    }
+
+    void release()
+    {
+        for (GLsync& fence : fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+        if (mapped)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER,buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER,0);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1,&buffer);
+        buffer = 0;
+        for (const unsigned int oldBuffer : retired)
+            glDeleteBuffers(1,&oldBuffer);
+        retired.clear();
+    }
+
+    // only when a frame outgrows its region. The ranges handed out earlier this frame keep pointing at the
+    // old buffer,so it is only deleted in endFrame,after the last draw that can read it was issued
+    void grow(const std::size_t instancesPerFrame)
+    {
+        if (mapped)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER,buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER,0);
+            mapped = nullptr;
+        }
+        retired.push_back(buffer);
+        for (GLsync& fence : fences) // they guarded regions of the old buffer
+        {
+            if (fence)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+        allocate(instancesPerFrame);
+        used = 0;
+    }
+};
+
+#endif //MYOPENPROJECT_INSTANCEBUFFER_H
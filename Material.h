@@ -0,0 +1,198 @@
+#ifndef MYOPENPROJECT_MATERIAL_H
+#define MYOPENPROJECT_MATERIAL_H
+
+#include <glad/glad.h>
+
+#include "Shader.h"
+#include "TexturePacker.h"
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// The texture bindings of a mesh,resolved once when the model is loaded.
+// Every sampler of the "material" struct in shader.fs owns a fixed texture unit,so the sampler
+// uniforms are set once per program (setSamplers) and drawing is only a loop of binds.
+// Textures that were packed into an array (see TexturePacker) are sampled through the array
+// sampler of their slot;the only per-draw state left for them is the layer index (materialLayers in shader.vs).
+class Material
+{
+public:
+    enum class Slot
+    {
+        diffuse,
+        specular,
+        normal,
+        height,
+        count,
+    };
+
+    struct Binding {
+        unsigned int unit;
+        unsigned int textureID;
+    };
+
+    static constexpr unsigned int slotCount{static_cast<unsigned int>(Slot::count)};
+    static constexpr unsigned int maxPerSlot{2}; // texture_diffuse1,texture_diffuse2... anything past that was never sampled
+
+    unsigned int id{nextID++}; // groups draws that share a material when the render queue is sorted
+    std::vector<Binding> bindings;
+    std::array<unsigned int,slotCount> arrays{}; // 0 when the first texture of the slot is a plain 2D texture
+    std::array<int,slotCount> layers{-1,-1,-1,-1};
+
+    // typeName is the one Model::loadMaterialTextures gives the texture ("texture_diffuse" etc.)
+    void addTexture(std::string_view typeName,const unsigned int textureID)
+    {
+        const int slot{slotFromName(typeName)};
+        if (slot < 0)
+            return;
+
+        unsigned int& used = perSlot[static_cast<unsigned int>(slot)];
+        if (used == maxPerSlot)
+            return;
+
+        bindings.push_back({unitFor(static_cast<Slot>(slot),used++),textureID});
+    }
+
+    // moves the first texture of every slot over to its packed array,if it has one
+    void usePackedTextures(const TexturePacker& packer)
+    {
+        for (unsigned int slot{0}; slot < slotCount; ++slot)
+        {
+            const unsigned int unit{unitFor(static_cast<Slot>(slot),0)};
+            for (auto it = bindings.begin(); it != bindings.end(); ++it)
+            {
+                if (it->unit != unit)
+                    continue;
+                if (const auto location = packer.find(it->textureID))
+                {
+                    arrays[slot] = location->arrayID;
+                    layers[slot] = location->layer;
+                    bindings.erase(it);
+                }
+                break;
+            }
+        }
+    }
+
+    void bind(const Shader& shader) const
+    {
+        for (const Binding& binding : bindings)
+        {
+            glActiveTexture(GL_TEXTURE0 + binding.unit);
+            glBindTexture(GL_TEXTURE_2D,binding.textureID);
+        }
+        for (unsigned int slot{0}; slot < slotCount; ++slot)
+        {
+            if (arrays[slot] && boundArrays[slot] != arrays[slot]) // meshes sharing an array don't rebind it
+            {
+                glActiveTexture(GL_TEXTURE0 + arrayUnitFor(static_cast<Slot>(slot)));
+                glBindTexture(GL_TEXTURE_2D_ARRAY,arrays[slot]);
+                boundArrays[slot] = arrays[slot];
+            }
+        }
+        glActiveTexture(GL_TEXTURE0);
+
+        const int location{layerLocation(shader.getProgramID())};
+        if (location != -1)
+            glUniform4i(location,layers[0],layers[1],layers[2],layers[3]);
+    }
+
+    [[nodiscard]] static constexpr unsigned int unitFor(Slot slot,const unsigned int index)
+    {
+        return static_cast<unsigned int>(slot) * maxPerSlot + index;
+    }
+
+    [[nodiscard]] static constexpr unsigned int arrayUnitFor(Slot slot) // the array units come right after the 2D ones
+    {
+        return slotCount * maxPerSlot + static_cast<unsigned int>(slot);
+    }
+
+    // resolves the sampler locations of the program and points each of them at its unit;
+    // call it once after the program is linked,the units never change afterwards
+    static void setSamplers(const Shader& shader)
+    {
+        shader.use();
+        const unsigned int program{shader.getProgramID()};
+        for (unsigned int slot{0}; slot < slotCount; ++slot)
+        {
+            for (unsigned int index{0}; index < maxPerSlot; ++index)
+            {
+                const std::string name{"material." + std::string(slotNames[slot]) + std::to_string(index + 1)};
+                const int location{glGetUniformLocation(program,name.c_str())};
+                if (location != -1) // not every program samples every slot
+                    glUniform1i(location,static_cast<int>(unitFor(static_cast<Slot>(slot),index)));
+            }
+
+            const std::string name{"material." + std::string(arraySamplerNames[slot])};
+            const int location{glGetUniformLocation(program,name.c_str())};
+            if (location != -1)
+                glUniform1i(location,static_cast<int>(arrayUnitFor(static_cast<Slot>(slot))));
+        }
+
+        layerLocations.emplace_back(program,glGetUniformLocation(program,"materialLayers"));
+    }
+
+    // true if both materials bind exactly the same textures,so their meshes can be drawn in one go
+    [[nodiscard]] bool sameBindings(const Material& other) const
+    {
+        if (arrays != other.arrays || bindings.size() != other.bindings.size())
+            return false;
+        for (std::size_t i{0}; i < bindings.size(); ++i)
+        {
+            if (bindings[i].unit != other.bindings[i].unit || bindings[i].textureID != other.bindings[i].textureID)
+                return false;
+        }
+        return true;
+    }
+
+    // has to be called if anything else binds textures to the array units,or the arrays are deleted
+    static void invalidateBindings()
+    {
+        boundArrays.fill(0);
+    }
+
+private:
+    static constexpr std::array<std::string_view,slotCount> slotNames{
+        "texture_diffuse",
+        "texture_specular",
+        "texture_normal",
+        "texture_height",
+    };
+    static constexpr std::array<std::string_view,slotCount> arraySamplerNames{
+        "diffuseLayers",
+        "specularLayers",
+        "normalLayers",
+        "heightLayers",
+    };
+
+    inline static unsigned int nextID{1};
+    inline static std::vector<std::pair<unsigned int,int>> layerLocations; // (program,location),filled by setSamplers
+    inline static std::array<unsigned int,slotCount> boundArrays{};
+
+    std::array<unsigned int,slotCount> perSlot{};
+
+    static int slotFromName(std::string_view typeName)
+    {
+        for (unsigned int slot{0}; slot < slotCount; ++slot)
+        {
+            if (slotNames[slot] == typeName)
+                return static_cast<int>(slot);
+        }
+        return -1;
+    }
+
+    static int layerLocation(const unsigned int program)
+    {
+        for (const auto& [programID,location] : layerLocations)
+        {
+            if (programID == program)
+                return location;
+        }
+        return -1;
+    }
+};
+
+#endif //MYOPENPROJECT_MATERIAL_H
@@ -7,10 +7,16 @@
 #include <utility>
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 #include "Shader.h"
+#include "Material.h"
+#include "Bounds.h"
+#include "InstanceBuffer.h"
 
 static constexpr int maxBoneInfluence{4};
 
+class OcclusionQueries;
+
 class Mesh
 {
 public:
@@ -36,6 +42,11 @@ public:
     std::vector<Vertex> vertices;
     std::vector <unsigned int> indices;
     std::vector<Texture> textures;
+    Material material{};
+    AABB bounds{};              // model space,filled by Model::processMesh
+    BoundingSphere sphere{};
+    OcclusionQueries* occlusion{};   // the queries of its model (OcclusionQueries::attach),run by whatever draws it
+    std::uint32_t occlusionIndex{};  // the mesh's index in its model
 
     unsigned int VAO{};
 
@@ -43,38 +54,13 @@ public:
         :vertices{std::move(vertex)},indices{std::move(index)},textures{std::move(texture)}
     {
         setupMesh();
+        for (const Texture& tex : textures) // the type strings are only looked at here,never while drawing
+            material.addTexture(tex.type,tex.id);
     }
 
-    void Draw(const Shader& shader,const int numberOfInstances = 0) const
+    void Draw(const Shader& shader,const int numberOfInstances = 0) const // the samplers were set up by Material::setSamplers
     {
-        unsigned int diffuseNr{1};
-        unsigned int specularNr{1};
-        unsigned int normalNr{1};
-        unsigned int heightNr{1};
-        for(unsigned int i{0}; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // activate proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            std::string number;
-            std::string name = textures[i].type;
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++);
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++);
-            else if(name == "texture_height")
-                number = std::to_string(heightNr++);
-
-            name += number;
-
-            shader.setInt("material." + name, static_cast<int>(i));
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
-
-
-        }
-
-        glActiveTexture(GL_TEXTURE0);
+        material.bind(shader);
 
         // draw mesh
         glBindVertexArray(VAO);
@@ -85,24 +71,23 @@ public:
         glBindVertexArray(0);
     }
 
-private:
-    unsigned int VBO{};
-    unsigned int EBO{};
-
-    void setupMesh()
+    // one draw for every instance of the range,with its own transform,color and material index
+    void Draw(const Shader& shader,const InstanceBuffer::Range& instances) const
     {
-        glGenVertexArrays(1,&VAO);
-        glGenBuffers(1,&VBO);
-        glGenBuffers(1,&EBO);
+        if (!instances.count)
+            return;
+        material.bind(shader);
 
         glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER,VBO);
-
-        glBufferData(GL_ARRAY_BUFFER,static_cast<long>(std::size(vertices) * sizeof(Vertex)),&vertices[0],GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,static_cast<long>(std::size(indices) * sizeof(unsigned int)),&indices[0],GL_STATIC_DRAW);
+        InstanceBuffer::bindAttributes(instances);
+        glDrawElementsInstanced(GL_TRIANGLES,static_cast<int>(indices.size()),GL_UNSIGNED_INT,nullptr,instances.count);
+        InstanceBuffer::unbindAttributes();
+        glBindVertexArray(0);
+    }
 
+    // the layout of Vertex,for whatever vertex buffer is bound to GL_ARRAY_BUFFER and the bound vao
+    static void setupVertexAttributes()
+    {
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(Vertex),nullptr);
 
@@ -123,6 +108,27 @@ private:
 
         glEnableVertexAttribArray(6);
         glVertexAttribPointer(6,4,GL_FLOAT,GL_FALSE,sizeof(Vertex),reinterpret_cast<void*>(offsetof(Vertex,m_Weights)));
+    }
+
+private:
+    unsigned int VBO{};
+    unsigned int EBO{};
+
+    void setupMesh()
+    {
+        glGenVertexArrays(1,&VAO);
+        glGenBuffers(1,&VBO);
+        glGenBuffers(1,&EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER,VBO);
+
+        glBufferData(GL_ARRAY_BUFFER,static_cast<long>(std::size(vertices) * sizeof(Vertex)),&vertices[0],GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,static_cast<long>(std::size(indices) * sizeof(unsigned int)),&indices[0],GL_STATIC_DRAW);
+
+        setupVertexAttributes();
 
         glBindVertexArray(0);
     }
@@ -13,6 +13,10 @@
 
 #include "Mesh.h"
 #include "Shader.h"
+#include "TexturePacker.h"
+#include "BVH.h"
+#include "OcclusionQueries.h"
+#include "CpuProfiler.h"
 
 
 #include <string>
@@ -35,12 +39,22 @@ public:
 
     std::vector<Mesh::Texture> textures_loaded;
     std::vector<Mesh> meshes;
+    BVH meshBVH; // over the mesh bounds in model space
     std::string directory;
     bool gammaCorrection;
 
-    explicit Model(char const * path,bool gamma = false) : gammaCorrection{gamma}
+    explicit Model(char const * path,bool gamma = false,bool packTextures = true) : gammaCorrection{gamma}
     {
         loadModel(path);
+        buildMeshBVH();
+        occlusionQueries.attach(meshes);
+        if (packTextures)
+            packMaterialTextures();
+    }
+
+    ~Model()
+    {
+        Material::invalidateBindings(); // the arrays go with the packer,their names can come back for other textures
     }
 
     void Draw(const Shader& shader,const int numberOfInstances = 0) const
@@ -50,10 +64,30 @@ public:
             i.Draw(shader,numberOfInstances);
         }
     }
+    // every instance of the model in one draw per mesh
+    void Draw(const Shader& shader,const InstanceBuffer::Range& instances) const
+    {
+        for (const Mesh& i : meshes)
+        {
+            i.Draw(shader,instances);
+        }
+    }
 private:
+    OcclusionQueries occlusionQueries; // the meshes point at it,query state only
+    TexturePacker packer; // owns the texture arrays the materials sample
+
+    void buildMeshBVH()
+    {
+        std::vector<AABB> bounds;
+        bounds.reserve(meshes.size());
+        for (const Mesh& mesh : meshes)
+            bounds.push_back(mesh.bounds);
+        meshBVH.build(bounds);
+    }
 
     void loadModel(std::string const &path)
     {
+        PROFILE_FUNCTION();
         Assimp::Importer import;
         const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace);
 
@@ -66,6 +100,47 @@ private:
 
         processNode(scene->mRootNode, scene);
     }
+
+    void packMaterialTextures() // same size/format textures end up in one array,so the meshes mostly share their bindings
+    {
+        for (const Mesh::Texture& texture : textures_loaded)
+            packer.add(texture.id);
+        packer.build();
+
+        for (Mesh& mesh : meshes)
+            mesh.material.usePackedTextures(packer);
+
+        // the 2D original of a packed texture can go unless some material still binds it directly
+        for (Mesh::Texture& texture : textures_loaded)
+        {
+            if (!packer.find(texture.id) || isBoundDirectly(texture.id))
+                continue;
+
+            const unsigned int packedID{texture.id};
+            glDeleteTextures(1,&texture.id);
+            for (Mesh& mesh : meshes)
+            {
+                for (Mesh::Texture& meshTexture : mesh.textures)
+                {
+                    if (meshTexture.id == packedID)
+                        meshTexture.id = 0;
+                }
+            }
+            texture.id = 0;
+        }
+    }
+    [[nodiscard]] bool isBoundDirectly(const unsigned int textureID) const
+    {
+        for (const Mesh& mesh : meshes)
+        {
+            for (const Material::Binding& binding : mesh.material.bindings)
+            {
+                if (binding.textureID == textureID)
+                    return true;
+            }
+        }
+        return false;
+    }
     void processNode(const aiNode* node, const aiScene *scene)
     {
         // process all the node's meshes (if any)
@@ -86,6 +161,7 @@ private:
         std::vector<Mesh::Vertex> vertices;
         std::vector<unsigned int> indices;
         std::vector<Mesh::Texture> textures;
+        AABB bounds{};
 
         for (unsigned int i{0}; i < mesh ->mNumVertices;i++) {
             Mesh::Vertex vertex{};
@@ -129,9 +205,14 @@ private:
             else
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
 
+            bounds.expand(vertex.Position);
             vertices.push_back(vertex);
         }
 
+        BoundingSphere sphere{bounds.center(),0.0f}; // around the box center,tighter than half its diagonal
+        for (const Mesh::Vertex& vertex : vertices)
+            sphere.radius = std::max(sphere.radius,glm::distance(sphere.center,vertex.Position));
+
         for(unsigned int i{0}; i < mesh->mNumFaces; i++)
         {
                 aiFace face = mesh->mFaces[i];
@@ -153,7 +234,10 @@ private:
                                                     aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-        return {std::move(vertices), std::move(indices), std::move(textures)};
+        Mesh result{std::move(vertices), std::move(indices), std::move(textures)};
+        result.bounds = bounds;
+        result.sphere = sphere;
+        return result;
     }
     std::vector<Mesh::Texture> loadMaterialTextures(const aiMaterial *mat, aiTextureType type,
                                          const std::string& typeName)
@@ -196,6 +280,7 @@ public:
     static unsigned int TextureFromFile(const char *path,const std::string &directory = "",
         const TextureType imageType = TextureType::opaque,[[maybe_unused]] const bool gamma = false) // looks really bad,I'll have to change this
     {
+        PROFILE_FUNCTION();
         auto filename = std::string(path);
 
         if (!directory.empty()){filename = directory + '/' + filename;}
@@ -264,6 +349,7 @@ public:
 
     static unsigned int loadCubemap(const std::vector<std::string>& faces) // not part of the class proper,have to move it eventually;
     {
+        PROFILE_FUNCTION();
         unsigned int textureID;
         glGenTextures(1, &textureID);
         glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
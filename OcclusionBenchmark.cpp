@@ -0,0 +1,283 @@
+// Checks OcclusionCuller against a scene whose answer is known,a square wall facing the camera:boxes
+// hidden behind it are culled,no box that shows anywhere on screen ever is,the two triangles of a quad
+// leave no crack between them,back faces hide nothing and the depth is never nearer than the wall. Then
+// times the frame's work (occluder setup and rasterization,alone and on the pool,and the visibility test
+// of a batch of boxes) for walls cut in more and more triangles. Needs no window or GL context.
+//   ./OCCLUSION_BENCHMARK [wall grid sizes...]   defaults to 1,32 and 128 (2 * size^2 triangles)
+// Exits with a failure when a check doesn't hold.
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Bounds.h"
+#include "OcclusionCuller.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace
+{
+    struct Vertex {
+        glm::vec3 Position;
+    };
+
+    // the wall:z = wallZ,x and y in [-wallHalfSize,wallHalfSize],the camera at the origin looking down -z
+    constexpr float wallZ{-10.0f};
+    constexpr float wallHalfSize{5.0f};
+    constexpr float nearPlane{0.1f};
+    constexpr float farPlane{100.0f};
+
+    template<typename F>
+    double milliseconds(F&& work,const int repeats = 1) // best of repeats
+    {
+        double best{1e30};
+        for (int i{0}; i < repeats; ++i)
+        {
+            const auto start{std::chrono::steady_clock::now()};
+            work();
+            const std::chrono::duration<double,std::milli> elapsed{std::chrono::steady_clock::now() - start};
+            best = std::min(best,elapsed.count());
+        }
+        return best;
+    }
+
+    void report(const char* name,const double time,const std::size_t result)
+    {
+        std::cout << "  " << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed
+                  << std::setprecision(3) << time << " ms   (" << result << ")\n";
+    }
+
+    bool check(const char* name,const bool passed)
+    {
+        std::cout << "  " << std::left << std::setw(44) << name << (passed ? "yes" : "NO") << '\n';
+        return passed;
+    }
+
+    glm::mat4 viewProjection()
+    {
+        const float aspect{static_cast<float>(OcclusionCuller::width) / static_cast<float>(OcclusionCuller::height)};
+        return glm::perspective(glm::radians(60.0f),aspect,nearPlane,farPlane)
+             * glm::lookAt(glm::vec3(0.0f),glm::vec3(0.0f,0.0f,-1.0f),glm::vec3(0.0f,1.0f,0.0f));
+    }
+
+    // the wall cut in size x size quads,counter clockwise from the camera unless backFacing
+    void buildWall(const int size,const bool backFacing,std::vector<Vertex>& vertices,std::vector<unsigned int>& indices)
+    {
+        vertices.clear();
+        indices.clear();
+        const auto side{static_cast<unsigned int>(size + 1)};
+        for (int y{0}; y <= size; ++y)
+        {
+            for (int x{0}; x <= size; ++x)
+            {
+                const float u{static_cast<float>(x) / static_cast<float>(size)};
+                const float v{static_cast<float>(y) / static_cast<float>(size)};
+                vertices.push_back({{(u * 2.0f - 1.0f) * wallHalfSize,(v * 2.0f - 1.0f) * wallHalfSize,wallZ}});
+            }
+        }
+        for (unsigned int y{0}; y < static_cast<unsigned int>(size); ++y)
+        {
+            for (unsigned int x{0}; x < static_cast<unsigned int>(size); ++x)
+            {
+                const unsigned int corner{y * side + x};
+                const std::array<unsigned int,6> quad{corner,corner + 1,corner + side + 1,corner,corner + side + 1,corner + side};
+                if (backFacing)
+                    indices.insert(indices.end(),quad.rbegin(),quad.rend());
+                else
+                    indices.insert(indices.end(),quad.begin(),quad.end());
+            }
+        }
+    }
+
+    void drawWall(OcclusionCuller& culler,const int size,const bool backFacing)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        buildWall(size,backFacing,vertices,indices);
+        culler.beginFrame(viewProjection());
+        culler.addOccluder(std::span<const Vertex>{vertices},std::span<const unsigned int>{indices},glm::mat4(1.0f));
+        culler.rasterize();
+    }
+
+    AABB boxAround(const glm::vec3& center,const float extent)
+    {
+        return {center - glm::vec3(extent),center + glm::vec3(extent)};
+    }
+
+    glm::vec3 toNDC(const glm::vec3& point)
+    {
+        const glm::vec4 clip{viewProjection() * glm::vec4(point,1.0f)};
+        return glm::vec3(clip) / clip.w;
+    }
+
+    // the truth for one wall: a box is hidden when it's all behind the wall and all of it projects inside it
+    bool isHidden(const AABB& box)
+    {
+        if (box.max.z >= wallZ)
+            return false;
+        const glm::vec3 wallCorner{toNDC({wallHalfSize,wallHalfSize,wallZ})};
+        for (int corner{0}; corner < 8; ++corner)
+        {
+            const glm::vec3 point{corner & 1 ? box.max.x : box.min.x,corner & 2 ? box.max.y : box.min.y,corner & 4 ? box.max.z : box.min.z};
+            const glm::vec3 ndc{toNDC(point)};
+            if (std::abs(ndc.x) >= wallCorner.x || std::abs(ndc.y) >= wallCorner.y)
+                return false;
+        }
+        return true;
+    }
+
+    // boxes in front of the camera that are all on screen,so being off screen is never why one is culled
+    std::vector<AABB> randomBoxes(const std::size_t count)
+    {
+        std::mt19937 random{42};
+        std::uniform_real_distribution<float> depth{-40.0f,-2.0f};
+        std::uniform_real_distribution<float> side{-1.0f,1.0f};
+        std::uniform_real_distribution<float> extent{0.05f,1.5f};
+        std::vector<AABB> boxes;
+        while (boxes.size() < count)
+        {
+            const float z{depth(random)};
+            const float reach{-z * 0.5f};
+            const AABB box{boxAround({side(random) * reach,side(random) * reach * 0.75f,z},extent(random))};
+            bool onScreen{box.max.z < -nearPlane};
+            for (int corner{0}; corner < 8 && onScreen; ++corner)
+            {
+                const glm::vec3 point{corner & 1 ? box.max.x : box.min.x,corner & 2 ? box.max.y : box.min.y,corner & 4 ? box.max.z : box.min.z};
+                const glm::vec3 ndc{toNDC(point)};
+                onScreen = std::abs(ndc.x) < 1.0f && std::abs(ndc.y) < 1.0f;
+            }
+            if (onScreen)
+                boxes.push_back(box);
+        }
+        return boxes;
+    }
+
+    bool runChecks(ThreadPool& pool)
+    {
+        OcclusionCuller culler;
+        std::cout << "checks (" << culler.instructionSet() << ")\n";
+        bool passed{true};
+
+        drawWall(culler,1,false);
+        passed &= check("box behind the wall culled",!culler.isVisible(boxAround({0.0f,0.0f,-20.0f},1.0f)));
+        passed &= check("box in front of the wall visible",culler.isVisible(boxAround({0.0f,0.0f,-5.0f},0.5f)));
+        passed &= check("box beside the wall visible",culler.isVisible(boxAround({-12.0f,0.0f,-20.0f},1.0f)));
+        // twice as far as the wall,its edge is seen at twice its x
+        passed &= check("box over the wall's edge visible",culler.isVisible(boxAround({wallHalfSize * 2.0f,0.0f,-20.0f},1.0f)));
+        passed &= check("box through the near plane visible",culler.isVisible(boxAround({0.0f,0.0f,0.0f},1.0f)));
+
+        // every pixel center inside the wall (a pixel in from its edges) is covered,on the diagonal too,
+        // and never nearer than the wall
+        const glm::vec3 wallCorner{toNDC({wallHalfSize,wallHalfSize,wallZ})};
+        const float wallDepth{wallCorner.z};
+        const std::span<const float> depth{culler.depth()};
+        bool covered{true};
+        bool conservative{true};
+        for (int y{0}; y < OcclusionCuller::height; ++y)
+        {
+            for (int x{0}; x < OcclusionCuller::width; ++x)
+            {
+                const float ndcX{(static_cast<float>(x) + 0.5f) / OcclusionCuller::width * 2.0f - 1.0f};
+                const float ndcY{(static_cast<float>(y) + 0.5f) / OcclusionCuller::height * 2.0f - 1.0f};
+                const float pixel{depth[static_cast<std::size_t>(y * OcclusionCuller::width + x)]};
+                const bool inside{std::abs(ndcX) < wallCorner.x - 2.0f / OcclusionCuller::width
+                                  && std::abs(ndcY) < wallCorner.y - 2.0f / OcclusionCuller::height};
+                if (inside && pixel >= 1.0f)
+                    covered = false;
+                if (pixel < wallDepth - 1e-5f)
+                    conservative = false;
+            }
+        }
+        passed &= check("no cracks inside the wall",covered);
+        passed &= check("depth never nearer than the wall",conservative);
+
+        const std::vector<AABB> boxes{randomBoxes(20'000)};
+        std::vector<std::uint8_t> visible(boxes.size());
+        OcclusionCuller pooled{&pool};
+        drawWall(pooled,32,false);
+        pooled.testVisibility(boxes,visible);
+        bool neverWrong{true};
+        bool samePooled{true};
+        std::size_t hidden{0};
+        std::size_t culled{0};
+        for (std::size_t i{0}; i < boxes.size(); ++i)
+        {
+            const bool isHiddenBox{isHidden(boxes[i])};
+            hidden += isHiddenBox;
+            culled += !visible[i];
+            if (!visible[i] && !isHiddenBox)
+                neverWrong = false;
+            if (static_cast<bool>(visible[i]) != pooled.isVisible(boxes[i]))
+                samePooled = false;
+        }
+        passed &= check("no visible box culled (20000 random boxes)",neverWrong);
+        passed &= check("batch on the pool agrees with isVisible",samePooled);
+        std::cout << "  culled " << culled << " of the " << hidden << " hidden boxes\n";
+
+        drawWall(culler,1,true);
+        passed &= check("back facing wall hides nothing",culler.isVisible(boxAround({0.0f,0.0f,-20.0f},1.0f)) && culler.triangleCount() == 0);
+        std::cout << '\n';
+        return passed;
+    }
+
+    void run(const int size,ThreadPool& pool)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        buildWall(size,false,vertices,indices);
+        const std::vector<AABB> boxes{randomBoxes(10'000)};
+        std::vector<std::uint8_t> visible(boxes.size());
+        std::cout << indices.size() / 3 << " occluder triangles," << pool.size() + 1 << " threads\n";
+
+        OcclusionCuller single;
+        OcclusionCuller pooled{&pool};
+        const auto frame{[&](OcclusionCuller& culler){
+            culler.beginFrame(viewProjection());
+            culler.addOccluder(std::span<const Vertex>{vertices},std::span<const unsigned int>{indices},glm::mat4(1.0f));
+            culler.rasterize();
+        }};
+        const double singleTime{milliseconds([&]{ frame(single); },20)};
+        report("setup + rasterize",singleTime,single.triangleCount());
+        const double pooledTime{milliseconds([&]{ frame(pooled); },20)};
+        report("setup + rasterize (pool)",pooledTime,pooled.triangleCount());
+
+        std::size_t culled{0};
+        const double testTime{milliseconds([&]{
+            pooled.testVisibility(boxes,visible);
+        },20)};
+        for (const std::uint8_t isVisible : visible)
+            culled += !isVisible;
+        report("test 10000 boxes (pool)",testTime,culled);
+        std::cout << '\n';
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::vector<int> sizes{1,32,128};
+    if (argc > 1)
+    {
+        sizes.clear();
+        for (int i{1}; i < argc; ++i)
+            sizes.push_back(std::atoi(argv[i]));
+    }
+
+    ThreadPool pool;
+    const bool passed{runChecks(pool)};
+    for (const int size : sizes)
+    {
+        if (size > 0)
+            run(size,pool);
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
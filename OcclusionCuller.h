@@ -0,0 +1,365 @@
+#ifndef MYOPENPROJECT_OCCLUSIONCULLER_H
+#define MYOPENPROJECT_OCCLUSIONCULLER_H
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define OCCLUSIONCULLER_X86
+#endif
+
+// Software occlusion culling,no GL involved. A few big occluder meshes are rasterized every
+// frame into a small depth buffer,and the AABBs of everything else are tested against it
+// before they are submitted.
+//
+// Rasterization is a span loop with edge functions evaluated for 8 pixels at once (AVX2) or 4
+// (SSE),the coverage mask decides which lanes take the nearer depth. AVX2 is picked at runtime,
+// so the binary runs on anything x86-64. Each tile row of the buffer is a separate job on the
+// ThreadPool,no locking needed. After that every 8x8 tile keeps the farthest depth it holds:
+// a box nearer than that somewhere in its rectangle is visible without looking at pixels.
+//
+// Depths are NDC z (-1 near,1 far),so 1 means no occluder.
+class OcclusionCuller
+{
+public:
+    static constexpr int width{256};
+    static constexpr int height{192};
+    static constexpr int tileSize{8};
+    static constexpr int tilesX{width / tileSize};
+    static constexpr int tilesY{height / tileSize};
+
+    explicit OcclusionCuller(ThreadPool* pool = nullptr)
+        : pool{pool},depthBuffer(width * height,1.0f),tileMaxDepth(tilesX * tilesY,1.0f)
+    {
+#ifdef OCCLUSIONCULLER_X86
+        useAVX2 = __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    void beginFrame(const glm::mat4& newViewProjection)
+    {
+        viewProjection = newViewProjection;
+        triangles.clear();
+    }
+
+    // Vertex only needs a glm::vec3 Position (Mesh::Vertex);triangles are counter clockwise
+    template<typename Vertex>
+    void addOccluder(std::span<const Vertex> vertices,std::span<const unsigned int> indices,const glm::mat4& model)
+    {
+        const glm::mat4 transform{viewProjection * model};
+        clipVertices.resize(vertices.size());
+        for (std::size_t i{0}; i < vertices.size(); ++i)
+            clipVertices[i] = transform * glm::vec4(vertices[i].Position,1.0f);
+
+        for (std::size_t i{0}; i + 2 < indices.size(); i += 3)
+            setupTriangle(clipVertices[indices[i]],clipVertices[indices[i + 1]],clipVertices[indices[i + 2]]);
+    }
+
+    // every occluder of the frame has to be added before this
+    void rasterize()
+    {
+        const auto rasterizeTileRows{[this](const std::size_t first,const std::size_t last){
+            for (std::size_t tileRow{first}; tileRow < last; ++tileRow)
+                rasterizeTileRow(static_cast<int>(tileRow));
+        }};
+        if (pool)
+            pool->parallelFor(tilesY,rasterizeTileRows);
+        else
+            rasterizeTileRows(0,tilesY);
+    }
+
+    // conservative:boxes that cross the near plane or can't be ruled out count as visible
+    [[nodiscard]] bool isVisible(const AABB& box) const
+    {
+        glm::vec2 screenMin{static_cast<float>(width),static_cast<float>(height)};
+        glm::vec2 screenMax{0.0f};
+        float nearest{1.0f};
+        for (int corner{0}; corner < 8; ++corner)
+        {
+            const glm::vec3 point{corner & 1 ? box.max.x : box.min.x,corner & 2 ? box.max.y : box.min.y,corner & 4 ? box.max.z : box.min.z};
+            const glm::vec4 clip{viewProjection * glm::vec4(point,1.0f)};
+            if (clip.w <= nearW)
+                return true;
+            const glm::vec3 ndc{glm::vec3(clip) / clip.w};
+            const glm::vec2 screen{toScreen(ndc)};
+            screenMin = glm::min(screenMin,screen);
+            screenMax = glm::max(screenMax,screen);
+            nearest = std::min(nearest,ndc.z);
+        }
+
+        const int x0{std::max(0,static_cast<int>(std::floor(screenMin.x)))};
+        const int y0{std::max(0,static_cast<int>(std::floor(screenMin.y)))};
+        const int x1{std::min(width - 1,static_cast<int>(std::ceil(screenMax.x)))};
+        const int y1{std::min(height - 1,static_cast<int>(std::ceil(screenMax.y)))};
+        if (x0 > x1 || y0 > y1)
+            return false; // off screen,the frustum test already got rid of it
+        if (nearest < -1.0f)
+            return true;
+
+        for (int tileY{y0 / tileSize}; tileY <= y1 / tileSize; ++tileY)
+        {
+            for (int tileX{x0 / tileSize}; tileX <= x1 / tileSize; ++tileX)
+            {
+                if (nearest > tileMaxDepth[static_cast<std::size_t>(tileY * tilesX + tileX)])
+                    continue; // everything in the tile is nearer than the box
+
+                const int rowBegin{std::max(y0,tileY * tileSize)};
+                const int rowEnd{std::min(y1,tileY * tileSize + tileSize - 1)};
+                const int columnBegin{std::max(x0,tileX * tileSize)};
+                const int columnEnd{std::min(x1,tileX * tileSize + tileSize - 1)};
+                for (int y{rowBegin}; y <= rowEnd; ++y)
+                {
+                    const float* row{&depthBuffer[static_cast<std::size_t>(y * width)]};
+                    for (int x{columnBegin}; x <= columnEnd; ++x)
+                    {
+                        if (row[x] >= nearest)
+                            return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    // isVisible for a batch of boxes,split over the pool
+    void testVisibility(std::span<const AABB> boxes,std::span<std::uint8_t> visible) const
+    {
+        const auto test{[&](const std::size_t first,const std::size_t last){
+            for (std::size_t i{first}; i < last; ++i)
+                visible[i] = isVisible(boxes[i]);
+        }};
+        if (pool)
+            pool->parallelFor(boxes.size(),test);
+        else
+            test(0,boxes.size());
+    }
+
+    [[nodiscard]] std::span<const float> depth() const // row major,bottom row first
+    {
+        return depthBuffer;
+    }
+
+    [[nodiscard]] std::size_t triangleCount() const // occluder triangles that survived setup this frame
+    {
+        return triangles.size();
+    }
+
+    [[nodiscard]] const char* instructionSet() const
+    {
+#ifdef OCCLUSIONCULLER_X86
+        return useAVX2 ? "AVX2" : "SSE";
+#else
+        return "scalar";
+#endif
+    }
+
+private:
+    // edge i is inside where edgeX[i] * x + edgeY[i] * y + edgeC[i] >= 0,depth is a plane in screen space
+    struct Triangle {
+        std::array<float,3> edgeX;
+        std::array<float,3> edgeY;
+        std::array<float,3> edgeC;
+        float depthX;
+        float depthY;
+        float depthC;
+        int minX;
+        int maxX;
+        int minY;
+        int maxY;
+    };
+
+    static constexpr float nearW{1e-4f};
+
+    ThreadPool* pool;
+    bool useAVX2{false};
+    glm::mat4 viewProjection{1.0f};
+    std::vector<float> depthBuffer;
+    std::vector<float> tileMaxDepth;
+    std::vector<Triangle> triangles;
+    std::vector<glm::vec4> clipVertices;
+
+    static glm::vec2 toScreen(const glm::vec3& ndc)
+    {
+        return {(ndc.x * 0.5f + 0.5f) * static_cast<float>(width),(ndc.y * 0.5f + 0.5f) * static_cast<float>(height)};
+    }
+
+    void setupTriangle(const glm::vec4& clip0,const glm::vec4& clip1,const glm::vec4& clip2)
+    {
+        // crossing the near plane would need clipping;losing an occluder only costs some culling
+        if (clip0.w <= nearW || clip1.w <= nearW || clip2.w <= nearW)
+            return;
+
+        const glm::vec3 ndc0{glm::vec3(clip0) / clip0.w};
+        const glm::vec3 ndc1{glm::vec3(clip1) / clip1.w};
+        const glm::vec3 ndc2{glm::vec3(clip2) / clip2.w};
+        const glm::vec2 v0{toScreen(ndc0)};
+        const glm::vec2 v1{toScreen(ndc1)};
+        const glm::vec2 v2{toScreen(ndc2)};
+
+        const float area{(v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x)};
+        if (area <= 0.0f)
+            return; // back facing or degenerate
+
+        Triangle triangle{};
+        triangle.minX = std::max(0,static_cast<int>(std::floor(std::min({v0.x,v1.x,v2.x}))));
+        triangle.maxX = std::min(width - 1,static_cast<int>(std::ceil(std::max({v0.x,v1.x,v2.x}))));
+        triangle.minY = std::max(0,static_cast<int>(std::floor(std::min({v0.y,v1.y,v2.y}))));
+        triangle.maxY = std::min(height - 1,static_cast<int>(std::ceil(std::max({v0.y,v1.y,v2.y}))));
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+            return;
+
+        // a shared edge is always set up from the same end,so the two triangles get exactly opposite
+        // edge functions and no pixel center on it can slip through both (no cracks in the occluder)
+        const std::array<glm::vec2,3> points{v0,v1,v2};
+        for (std::size_t i{0}; i < 3; ++i)
+        {
+            const glm::vec2& a = points[i];
+            const glm::vec2& b = points[(i + 1) % 3];
+            const bool flip{b.x < a.x || (b.x == a.x && b.y < a.y)};
+            const glm::vec2& from = flip ? b : a;
+            const glm::vec2& to = flip ? a : b;
+            const float sign{flip ? -1.0f : 1.0f};
+            triangle.edgeX[i] = sign * (from.y - to.y);
+            triangle.edgeY[i] = sign * (to.x - from.x);
+            triangle.edgeC[i] = sign * -((from.y - to.y) * from.x + (to.x - from.x) * from.y);
+        }
+
+        const glm::vec2 d1{v1 - v0};
+        const glm::vec2 d2{v2 - v0};
+        const float z1{ndc1.z - ndc0.z};
+        const float z2{ndc2.z - ndc0.z};
+        triangle.depthX = (z1 * d2.y - z2 * d1.y) / area;
+        triangle.depthY = (z2 * d1.x - z1 * d2.x) / area;
+        // sampled at pixel centers;pushing it back by half a pixel of slope keeps the buffer conservative
+        const float slopeBias{0.5f * (std::abs(triangle.depthX) + std::abs(triangle.depthY))};
+        triangle.depthC = ndc0.z - triangle.depthX * v0.x - triangle.depthY * v0.y + slopeBias;
+
+        triangles.push_back(triangle);
+    }
+
+    void rasterizeTileRow(const int tileRow)
+    {
+        const int rowBegin{tileRow * tileSize};
+        const int rowEnd{rowBegin + tileSize - 1};
+        std::fill(depthBuffer.begin() + rowBegin * width,depthBuffer.begin() + (rowEnd + 1) * width,1.0f);
+
+        for (const Triangle& triangle : triangles)
+        {
+            const int first{std::max(rowBegin,triangle.minY)};
+            const int last{std::min(rowEnd,triangle.maxY)};
+            for (int y{first}; y <= last; ++y)
+            {
+#ifdef OCCLUSIONCULLER_X86
+                if (useAVX2)
+                    rasterizeSpanAVX2(triangle,y,&depthBuffer[static_cast<std::size_t>(y * width)]);
+                else
+                    rasterizeSpanSSE(triangle,y,&depthBuffer[static_cast<std::size_t>(y * width)]);
+#else
+                rasterizeSpanScalar(triangle,y,&depthBuffer[static_cast<std::size_t>(y * width)]);
+#endif
+            }
+        }
+
+        for (int tileX{0}; tileX < tilesX; ++tileX)
+        {
+            float farthest{-1.0f};
+            for (int y{rowBegin}; y <= rowEnd; ++y)
+            {
+                const float* row{&depthBuffer[static_cast<std::size_t>(y * width + tileX * tileSize)]};
+                farthest = std::max(farthest,*std::max_element(row,row + tileSize));
+            }
+            tileMaxDepth[static_cast<std::size_t>(tileRow * tilesX + tileX)] = farthest;
+        }
+    }
+
+#ifdef OCCLUSIONCULLER_X86
+    // the spans start on a multiple of the lane count,so no lane ever reaches past the row
+    __attribute__((target("avx2"))) static void rasterizeSpanAVX2(const Triangle& triangle,const int y,float* row)
+    {
+        const float centerY{static_cast<float>(y) + 0.5f};
+        const __m256 laneOffsets{_mm256_setr_ps(0.5f,1.5f,2.5f,3.5f,4.5f,5.5f,6.5f,7.5f)};
+        __m256 edgeX[3];
+        __m256 edgeRow[3];
+        for (std::size_t i{0}; i < 3; ++i)
+        {
+            edgeX[i] = _mm256_set1_ps(triangle.edgeX[i]);
+            edgeRow[i] = _mm256_set1_ps(triangle.edgeY[i] * centerY + triangle.edgeC[i]);
+        }
+        const __m256 depthX{_mm256_set1_ps(triangle.depthX)};
+        const __m256 depthRow{_mm256_set1_ps(triangle.depthY * centerY + triangle.depthC)};
+        const __m256 zero{_mm256_setzero_ps()};
+
+        for (int x{triangle.minX & ~7}; x <= triangle.maxX; x += 8)
+        {
+            const __m256 centerX{_mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)),laneOffsets)};
+            __m256 inside{_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeX[0],centerX),edgeRow[0]),zero,_CMP_GE_OQ)};
+            inside = _mm256_and_ps(inside,_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeX[1],centerX),edgeRow[1]),zero,_CMP_GE_OQ));
+            inside = _mm256_and_ps(inside,_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeX[2],centerX),edgeRow[2]),zero,_CMP_GE_OQ));
+            if (_mm256_testz_ps(inside,inside))
+                continue;
+
+            const __m256 depth{_mm256_add_ps(_mm256_mul_ps(depthX,centerX),depthRow)};
+            const __m256 stored{_mm256_loadu_ps(row + x)};
+            _mm256_storeu_ps(row + x,_mm256_blendv_ps(stored,_mm256_min_ps(stored,depth),inside));
+        }
+    }
+
+    static void rasterizeSpanSSE(const Triangle& triangle,const int y,float* row)
+    {
+        const float centerY{static_cast<float>(y) + 0.5f};
+        const __m128 laneOffsets{_mm_setr_ps(0.5f,1.5f,2.5f,3.5f)};
+        __m128 edgeX[3];
+        __m128 edgeRow[3];
+        for (std::size_t i{0}; i < 3; ++i)
+        {
+            edgeX[i] = _mm_set1_ps(triangle.edgeX[i]);
+            edgeRow[i] = _mm_set1_ps(triangle.edgeY[i] * centerY + triangle.edgeC[i]);
+        }
+        const __m128 depthX{_mm_set1_ps(triangle.depthX)};
+        const __m128 depthRow{_mm_set1_ps(triangle.depthY * centerY + triangle.depthC)};
+        const __m128 zero{_mm_setzero_ps()};
+
+        for (int x{triangle.minX & ~3}; x <= triangle.maxX; x += 4)
+        {
+            const __m128 centerX{_mm_add_ps(_mm_set1_ps(static_cast<float>(x)),laneOffsets)};
+            __m128 inside{_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeX[0],centerX),edgeRow[0]),zero)};
+            inside = _mm_and_ps(inside,_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeX[1],centerX),edgeRow[1]),zero));
+            inside = _mm_and_ps(inside,_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeX[2],centerX),edgeRow[2]),zero));
+            if (!_mm_movemask_ps(inside))
+                continue;
+
+            const __m128 depth{_mm_add_ps(_mm_mul_ps(depthX,centerX),depthRow)};
+            const __m128 stored{_mm_loadu_ps(row + x)};
+            const __m128 nearer{_mm_min_ps(stored,depth)};
+            _mm_storeu_ps(row + x,_mm_or_ps(_mm_and_ps(inside,nearer),_mm_andnot_ps(inside,stored)));
+        }
+    }
+#else
+    static void rasterizeSpanScalar(const Triangle& triangle,const int y,float* row)
+    {
+        const float centerY{static_cast<float>(y) + 0.5f};
+        for (int x{triangle.minX}; x <= triangle.maxX; ++x)
+        {
+            const float centerX{static_cast<float>(x) + 0.5f};
+            bool inside{true};
+            for (std::size_t i{0}; i < 3; ++i)
+                inside = inside && triangle.edgeX[i] * centerX + triangle.edgeY[i] * centerY + triangle.edgeC[i] >= 0.0f;
+            if (inside)
+                row[x] = std::min(row[x],triangle.depthX * centerX + triangle.depthY * centerY + triangle.depthC);
+        }
+    }
+#endif
+};
+
+#endif //MYOPENPROJECT_OCCLUSIONCULLER_H
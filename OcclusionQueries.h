@@ -0,0 +1,258 @@
+#ifndef MYOPENPROJECT_OCCLUSIONQUERIES_H
+#define MYOPENPROJECT_OCCLUSIONQUERIES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Mesh.h"
+#include "Shader.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Hardware occlusion queries for the meshes of a Model. attach() points every mesh at them (Mesh::occlusion),so
+// whatever draws a mesh runs them without its caller knowing:a RenderQueue mesh packet,the indirect StaticBatch. Before a big mesh is drawn on its own its bounding box goes through a depth-only
+// program inside a GL_ANY_SAMPLES_PASSED query (beforeDraw),and the mesh itself is drawn under
+// glBeginConditionalRender on that query,so the GPU throws the draw away if no sample of the box survived the
+// depth test. Meshes drawn together by one multi-draw can't be dropped one by one on the GPU:they're left out
+// when the results read back hide them (isOccluded) and their boxes are tested after the batch (test).
+// The results are also read back on the CPU,but only once they are available (one or two frames later),
+// never with a stall. They drive a hysteresis:
+//  - a mesh is considered occluded only after hideAfter occluded results in a row,one visible result shows it again;
+//  - a visible mesh is drawn without a query and only checked again every requeryInterval frames;
+//  - a mesh believed occluded waits for its query (GL_QUERY_WAIT),so it can't pop in late when it comes back into view,
+//    while a visible one never waits (GL_QUERY_NO_WAIT draws it if the result isn't there yet).
+// A mesh counts its frames itself,one per frame it's drawn in.
+// The box uses the model transform the mesh is drawn with and the Perspective uniform block (binding 0);drawing it
+// leaves depth writes off,the box program bound and no vertex array,the caller restores what it needs.
+class OcclusionQueries
+{
+public:
+    static constexpr unsigned int latency{2};                // frames a result can take before it is read
+    static constexpr unsigned int queriesPerMesh{latency + 1};
+    static constexpr unsigned int hideAfter{3};
+    static constexpr unsigned int requeryInterval{4};
+    static constexpr std::size_t minQueryIndices{3 * 512};   // a box query costs about as much as a small mesh
+
+    inline static bool enabled{true};
+
+    OcclusionQueries() = default;
+    OcclusionQueries(const OcclusionQueries&) = delete;
+    OcclusionQueries& operator=(const OcclusionQueries&) = delete;
+
+    ~OcclusionQueries()
+    {
+        for (MeshState& state : states)
+            glDeleteQueries(queriesPerMesh,state.queries.data());
+    }
+
+    // what to draw a mesh under:glBeginConditionalRender(query,mode)
+    struct Conditional {
+        unsigned int query;
+        GLenum mode;
+    };
+
+    // once the model's meshes are final:gives each its query state
+    void attach(std::vector<Mesh>& meshes)
+    {
+        resize(meshes.size());
+        for (std::size_t i{0}; i < meshes.size(); ++i)
+        {
+            meshes[i].occlusion = this;
+            meshes[i].occlusionIndex = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    // right before the mesh is drawn on its own: draws its box query if one is due and returns the conditional
+    // render to draw the mesh under;nothing if it's drawn as it is (and nothing was drawn)
+    [[nodiscard]] std::optional<Conditional> beforeDraw(const std::size_t meshIndex,const Mesh& mesh,const glm::mat4& transform)
+    {
+        if (!isQueried(mesh))
+            return std::nullopt;
+
+        MeshState& state = states[meshIndex];
+        ++state.frame;
+        collectResults(state);
+        if (!isDue(state))
+            return std::nullopt;
+        return Conditional{issue(meshIndex,mesh.bounds,transform),static_cast<GLenum>(state.visible ? GL_QUERY_NO_WAIT : GL_QUERY_WAIT)};
+    }
+
+    // for a mesh of a batch: true if the results read back so far hide it
+    [[nodiscard]] bool isOccluded(const std::size_t meshIndex,const Mesh& mesh)
+    {
+        if (!isQueried(mesh))
+            return false;
+        MeshState& state = states[meshIndex];
+        ++state.frame;
+        collectResults(state);
+        return !state.visible;
+    }
+
+    // for a mesh of a batch,after the batch was drawn (and isOccluded() this frame): its box query,if one is due
+    void test(const std::size_t meshIndex,const Mesh& mesh,const glm::mat4& transform)
+    {
+        if (isQueried(mesh) && isDue(states[meshIndex]))
+            static_cast<void>(issue(meshIndex,mesh.bounds,transform));
+    }
+
+    [[nodiscard]] std::size_t occludedMeshes() const // by the last results read back
+    {
+        std::size_t occluded{0};
+        for (const MeshState& state : states)
+            occluded += !state.visible;
+        return occluded;
+    }
+
+private:
+    static constexpr std::uint64_t noQuery{~std::uint64_t{0}};
+
+    struct MeshState {
+        std::array<unsigned int,queriesPerMesh> queries{};
+        std::array<std::uint64_t,queriesPerMesh> issuedFrame{noQuery,noQuery,noQuery};
+        unsigned int occludedResults{};
+        unsigned int framesUntilQuery{};
+        std::uint64_t frame{};  // the frames the mesh was drawn in
+        bool visible{true};
+    };
+
+    struct BoxProgram {
+        Shader shader{"occlusionbox.vs","occlusionbox.fs"};
+        int boxMinLocation{glGetUniformLocation(shader.getProgramID(),"boxMin")};
+        int boxMaxLocation{glGetUniformLocation(shader.getProgramID(),"boxMax")};
+        int transformLocation{glGetUniformLocation(shader.getProgramID(),"transform")};
+        unsigned int VAO{};
+        unsigned int VBO{};
+        unsigned int EBO{};
+
+        BoxProgram()
+        {
+            const unsigned int program{shader.getProgramID()};
+            glUniformBlockBinding(program,glGetUniformBlockIndex(program,"Perspective"),0);
+
+            // unit cube,stretched over the bounds in occlusionbox.vs
+            constexpr std::array<float,24> corners{
+                0.0f,0.0f,0.0f, 1.0f,0.0f,0.0f, 1.0f,1.0f,0.0f, 0.0f,1.0f,0.0f,
+                0.0f,0.0f,1.0f, 1.0f,0.0f,1.0f, 1.0f,1.0f,1.0f, 0.0f,1.0f,1.0f,
+            };
+            constexpr std::array<unsigned int,36> indices{
+                0,2,1, 0,3,2,  4,5,6, 4,6,7,  0,1,5, 0,5,4,
+                3,6,2, 3,7,6,  0,4,7, 0,7,3,  1,2,6, 1,6,5,
+            };
+
+            glGenVertexArrays(1,&VAO);
+            glGenBuffers(1,&VBO);
+            glGenBuffers(1,&EBO);
+            glBindVertexArray(VAO);
+            glBindBuffer(GL_ARRAY_BUFFER,VBO);
+            glBufferData(GL_ARRAY_BUFFER,sizeof(corners),corners.data(),GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,EBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(indices),indices.data(),GL_STATIC_DRAW);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,3 * sizeof(float),nullptr);
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER,0);
+        }
+    };
+
+    inline static std::unique_ptr<BoxProgram> boxProgram; // shared by every model,made on first use so a context exists
+
+    std::vector<MeshState> states;
+
+    [[nodiscard]] static bool isQueried(const Mesh& mesh)
+    {
+        return enabled && mesh.indices.size() >= minQueryIndices;
+    }
+
+    // false for a visible mesh between its queries
+    [[nodiscard]] static bool isDue(MeshState& state)
+    {
+        if (state.visible && state.framesUntilQuery > 0)
+        {
+            --state.framesUntilQuery;
+            return false;
+        }
+        return true;
+    }
+
+    [[nodiscard]] unsigned int issue(const std::size_t meshIndex,const AABB& bounds,const glm::mat4& transform)
+    {
+        MeshState& state = states[meshIndex];
+        const unsigned int slot{static_cast<unsigned int>(state.frame % queriesPerMesh)}; // a result of this slot still unread by now is simply dropped
+        state.issuedFrame[slot] = state.frame;
+        state.framesUntilQuery = requeryInterval + static_cast<unsigned int>(meshIndex % requeryInterval); // spread the queries of visible meshes over frames
+        drawBox(state.queries[slot],bounds,transform);
+        return state.queries[slot];
+    }
+
+    void resize(const std::size_t meshCount)
+    {
+        for (MeshState& state : states)
+            glDeleteQueries(queriesPerMesh,state.queries.data());
+        states.assign(meshCount,MeshState{});
+        for (MeshState& state : states)
+            glGenQueries(queriesPerMesh,state.queries.data());
+    }
+
+    // reads every result that is ready,oldest first;never blocks
+    static void collectResults(MeshState& state)
+    {
+        for (unsigned int age{queriesPerMesh}; age > 0; --age)
+        {
+            if (state.frame < age)
+                continue;
+            const unsigned int slot{static_cast<unsigned int>((state.frame - age) % queriesPerMesh)};
+            if (state.issuedFrame[slot] == noQuery)
+                continue;
+
+            int available{0};
+            glGetQueryObjectiv(state.queries[slot],GL_QUERY_RESULT_AVAILABLE,&available);
+            if (!available)
+                break; // the newer ones can't be done either
+
+            unsigned int anySamples{0};
+            glGetQueryObjectuiv(state.queries[slot],GL_QUERY_RESULT,&anySamples);
+            state.issuedFrame[slot] = noQuery;
+
+            if (anySamples)
+            {
+                state.visible = true;
+                state.occludedResults = 0;
+            }
+            else if (++state.occludedResults >= hideAfter)
+            {
+                state.visible = false;
+                state.framesUntilQuery = 0;
+            }
+        }
+    }
+
+    static void drawBox(const unsigned int query,const AABB& bounds,const glm::mat4& transform)
+    {
+        if (!boxProgram)
+            boxProgram = std::make_unique<BoxProgram>();
+
+        glColorMask(GL_FALSE,GL_FALSE,GL_FALSE,GL_FALSE);
+        glDepthMask(GL_FALSE);
+
+        boxProgram->shader.use();
+        glUniform3fv(boxProgram->boxMinLocation,1,glm::value_ptr(bounds.min));
+        glUniform3fv(boxProgram->boxMaxLocation,1,glm::value_ptr(bounds.max));
+        glUniformMatrix4fv(boxProgram->transformLocation,1,GL_FALSE,glm::value_ptr(transform));
+
+        glBeginQuery(GL_ANY_SAMPLES_PASSED,query);
+        glBindVertexArray(boxProgram->VAO);
+        glDrawElements(GL_TRIANGLES,36,GL_UNSIGNED_INT,nullptr);
+        glBindVertexArray(0);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+        glColorMask(GL_TRUE,GL_TRUE,GL_TRUE,GL_TRUE);
+    }
+};
+
+#endif //MYOPENPROJECT_OCCLUSIONQUERIES_H
@@ -0,0 +1,257 @@
+#ifndef MYOPENPROJECT_POINTSHADOWATLAS_H
+#define MYOPENPROJECT_POINTSHADOWATLAS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Bounds.h"
+#include "ClusteredLights.h"
+#include "Frustum.h"
+#include "Shader.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Omnidirectional shadows for the first maxLights point lights. Their cube maps share one depth texture array,
+// six layers a light (+X,-X,+Y,-Y,+Z,-Z,like a cube map array,which a 3.3 context doesn't have);shader.fs picks
+// the face from the major axis of the light to fragment vector and compares against it with sampler2DArrayShadow.
+// A light's six faces are drawn in one pass: the whole array is attached as a layered framebuffer and
+// pointshadow.gs sends every triangle to the faces it can be seen in through gl_Layer.
+//
+// Only updatesPerFrame lights are drawn again each frame. update() ranks them by
+//   importance: how big the light's range looks from the camera,0 when its range misses the view or the receivers,
+//   change:     how far it moved since its map was drawn,relative to its range (or never drawn,or invalidate()),
+// and schedules the ones with the highest importance * change. Until its turn a light keeps the map it has,
+// looked up from the position it was drawn from,so its shadows lag behind instead of breaking.
+class PointShadowAtlas
+{
+public:
+    static constexpr unsigned int maxLights{8}; // NR_POINT_LIGHTS of shader.fs
+    static constexpr unsigned int atlasUnit{15};
+    static constexpr float nearPlane{0.05f};
+    static constexpr float minChange{0.002f}; // moves shorter than this part of the range don't need a new map
+    static constexpr float slopeBias{2.0f};   // glPolygonOffset of the casters
+    static constexpr float constantBias{4.0f};
+
+    inline static bool enabled{true};
+    inline static unsigned int updatesPerFrame{2};
+
+    explicit PointShadowAtlas(const unsigned int faceResolution)
+        : faceResolution{faceResolution}
+    {
+        glGenTextures(1,&atlas);
+        glBindTexture(GL_TEXTURE_2D_ARRAY,atlas);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY,0,GL_DEPTH_COMPONENT32F,static_cast<int>(faceResolution),static_cast<int>(faceResolution),
+                     static_cast<int>(maxLights * 6),0,GL_DEPTH_COMPONENT,GL_FLOAT,nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_COMPARE_MODE,GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_COMPARE_FUNC,GL_LEQUAL);
+        glBindTexture(GL_TEXTURE_2D_ARRAY,0);
+
+        glGenFramebuffers(1,&layeredFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER,layeredFBO);
+        glFramebufferTexture(GL_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,atlas,0); // every layer,gl_Layer picks one
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        const GLenum status{glCheckFramebufferStatus(GL_FRAMEBUFFER)};
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "ERROR::POINTSHADOWATLAS:: Framebuffer is not complete: 0x" << std::hex << status << std::dec << std::endl;
+            supported = false;
+        }
+
+        glGenFramebuffers(1,&clearFBO); // one layer at a time,clearing the layered one would clear every light
+        glBindFramebuffer(GL_FRAMEBUFFER,clearFBO);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+    }
+
+    PointShadowAtlas(const PointShadowAtlas&) = delete;
+    PointShadowAtlas& operator=(const PointShadowAtlas&) = delete;
+
+    ~PointShadowAtlas()
+    {
+        glDeleteFramebuffers(1,&layeredFBO);
+        glDeleteFramebuffers(1,&clearFBO);
+        glDeleteTextures(1,&atlas);
+    }
+
+    [[nodiscard]] bool isSupported() const
+    {
+        return supported;
+    }
+
+    // the casters changed,every map is drawn again,by priority over the next frames
+    void invalidate()
+    {
+        for (Slot& slot : slots)
+            slot.stale = true;
+    }
+
+    // ranks the lights and schedules the ones drawn this frame;lights past maxLights get no shadows
+    void update(std::span<const ClusteredLights::PointLight> lights,const glm::vec3& cameraPosition,const Frustum& view,const AABB& receivers)
+    {
+        scheduled.clear();
+        active = enabled && supported;
+        if (!active)
+            return;
+
+        lightCount = static_cast<unsigned int>(std::min<std::size_t>(lights.size(),maxLights));
+        std::vector<std::pair<float,unsigned int>> candidates; // priority,light
+        for (unsigned int i{0}; i < lightCount; ++i)
+        {
+            Slot& slot{slots[i]};
+            const BoundingSphere reach{lights[i].position,ClusteredLights::rangeOf(lights[i])};
+            slot.position = reach.center;
+            slot.range = reach.radius;
+
+            if (!view.intersects(reach) || !reach.intersects(receivers))
+                continue; // none of its shadows can be seen
+            const float importance{reach.radius / std::max(glm::distance(cameraPosition,reach.center),nearPlane)};
+            const float change{slot.stale ? std::numeric_limits<float>::max()
+                                          : glm::distance(reach.center,slot.drawnPosition) / reach.radius + std::abs(reach.radius - slot.drawnFar) / reach.radius};
+            if (change > minChange)
+                candidates.emplace_back(change == std::numeric_limits<float>::max() ? change : importance * change,i);
+        }
+
+        const std::size_t count{std::min<std::size_t>(candidates.size(),updatesPerFrame)};
+        std::partial_sort(candidates.begin(),candidates.begin() + static_cast<long>(count),candidates.end(),std::greater<>{});
+        for (std::size_t i{0}; i < count; ++i)
+            scheduled.push_back(candidates[i].second);
+    }
+
+    // draws the scheduled lights;drawCasters is called with the light's reach and draws the casters inside it
+    // with shader() (the "transform" uniform and instances like shader.vs)
+    template<typename DrawCasters>
+    void render(DrawCasters&& drawCasters)
+    {
+        if (scheduled.empty())
+            return;
+
+        pointShader.use();
+        glViewport(0,0,static_cast<int>(faceResolution),static_cast<int>(faceResolution));
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(slopeBias,constantBias);
+
+        for (const unsigned int light : scheduled)
+        {
+            Slot& slot{slots[light]};
+            const auto firstLayer{static_cast<int>(light * 6)};
+
+            glBindFramebuffer(GL_FRAMEBUFFER,clearFBO);
+            for (int face{0}; face < 6; ++face)
+            {
+                glFramebufferTextureLayer(GL_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,atlas,0,firstLayer + face);
+                glClear(GL_DEPTH_BUFFER_BIT);
+            }
+
+            glBindFramebuffer(GL_FRAMEBUFFER,layeredFBO);
+            const std::array<glm::mat4,6> faces{faceMatrices(slot.position,slot.range)};
+            const unsigned int program{pointShader.getProgramID()};
+            glUniformMatrix4fv(glGetUniformLocation(program,"faceMatrices"),6,GL_FALSE,glm::value_ptr(faces[0]));
+            pointShader.setInt("firstLayer",firstLayer);
+            drawCasters(BoundingSphere{slot.position,slot.range});
+
+            slot.drawnPosition = slot.position;
+            slot.drawnFar = slot.range;
+            slot.drawn = true;
+            slot.stale = false;
+        }
+
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+    }
+
+    // the program the casters are drawn with
+    [[nodiscard]] const Shader& shader() const
+    {
+        return pointShader;
+    }
+
+    // the uniforms of the point shadow lookup in shader.fs and deferredlight.fs;binds the array to atlasUnit
+    void bind(const Shader& shader) const
+    {
+        glActiveTexture(GL_TEXTURE0 + atlasUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY,atlas);
+        glActiveTexture(GL_TEXTURE0);
+
+        std::array<glm::vec4,maxLights> shadows{}; // w 0: no map
+        for (unsigned int i{0}; active && i < lightCount; ++i)
+        {
+            if (slots[i].drawn)
+                shadows[i] = glm::vec4(slots[i].drawnPosition,slots[i].drawnFar);
+        }
+
+        shader.use();
+        shader.setInt("pointShadowMap",static_cast<int>(atlasUnit));
+        shader.setFloat("pointShadowNear",nearPlane);
+        glUniform4fv(glGetUniformLocation(shader.getProgramID(),"pointShadows"),static_cast<int>(maxLights),glm::value_ptr(shadows[0]));
+    }
+
+    [[nodiscard]] std::size_t redrawsThisFrame() const
+    {
+        return scheduled.size();
+    }
+
+    // whether the shaders sample the maps this frame (update() was called)
+    [[nodiscard]] bool isActive() const
+    {
+        return active;
+    }
+
+    [[nodiscard]] unsigned int getTextureID() const
+    {
+        return atlas;
+    }
+
+private:
+    struct Slot {
+        glm::vec3 position{0.0f};      // this frame
+        float range{0.0f};
+        glm::vec3 drawnPosition{0.0f}; // when the map was drawn
+        float drawnFar{0.0f};
+        bool drawn{false};
+        bool stale{true};
+    };
+
+    Shader pointShader{"pointshadow.vs","pointshadow.gs","depthshader.fs"};
+    unsigned int faceResolution;
+    unsigned int atlas{};
+    unsigned int layeredFBO{};
+    unsigned int clearFBO{};
+    bool supported{true};
+    bool active{false};
+
+    std::array<Slot,maxLights> slots{};
+    unsigned int lightCount{0};
+    std::vector<unsigned int> scheduled;
+
+    // world to clip space of the six faces,oriented like the faces of a cube map so shader.fs can use its rules
+    [[nodiscard]] static std::array<glm::mat4,6> faceMatrices(const glm::vec3& position,const float far)
+    {
+        const glm::mat4 projection{glm::perspective(glm::radians(90.0f),1.0f,nearPlane,far)};
+        return {projection * glm::lookAt(position,position + glm::vec3( 1.0f, 0.0f, 0.0f),glm::vec3(0.0f,-1.0f, 0.0f)),
+                projection * glm::lookAt(position,position + glm::vec3(-1.0f, 0.0f, 0.0f),glm::vec3(0.0f,-1.0f, 0.0f)),
+                projection * glm::lookAt(position,position + glm::vec3( 0.0f, 1.0f, 0.0f),glm::vec3(0.0f, 0.0f, 1.0f)),
+                projection * glm::lookAt(position,position + glm::vec3( 0.0f,-1.0f, 0.0f),glm::vec3(0.0f, 0.0f,-1.0f)),
+                projection * glm::lookAt(position,position + glm::vec3( 0.0f, 0.0f, 1.0f),glm::vec3(0.0f,-1.0f, 0.0f)),
+                projection * glm::lookAt(position,position + glm::vec3( 0.0f, 0.0f,-1.0f),glm::vec3(0.0f,-1.0f, 0.0f))};
+    }
+};
+
+#endif //MYOPENPROJECT_POINTSHADOWATLAS_H
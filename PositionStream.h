@@ -0,0 +1,85 @@
+#ifndef MYOPENPROJECT_POSITIONSTREAM_H
+#define MYOPENPROJECT_POSITIONSTREAM_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// The positions of a set of meshes,copied once into one vertex buffer of their own (12 bytes a vertex
+// instead of the whole Mesh::Vertex) with one index buffer,for the passes that only write depth
+// (DepthPrepass,CascadedShadowMap). Attribute 0 is the position;a mesh is drawn by its index in the span.
+class PositionStream
+{
+public:
+    explicit PositionStream(std::span<const Mesh> meshes)
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+        for (const Mesh& mesh : meshes)
+        {
+            draws.push_back({static_cast<int>(mesh.indices.size()),indices.size() * sizeof(unsigned int),static_cast<int>(positions.size())});
+            for (const Mesh::Vertex& vertex : mesh.vertices)
+                positions.push_back(vertex.Position);
+            indices.insert(indices.end(),mesh.indices.begin(),mesh.indices.end());
+        }
+
+        glGenVertexArrays(1,&VAO);
+        glGenBuffers(1,&VBO);
+        glGenBuffers(1,&EBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER,VBO);
+        glBufferData(GL_ARRAY_BUFFER,static_cast<long>(positions.size() * sizeof(glm::vec3)),positions.data(),GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,static_cast<long>(indices.size() * sizeof(unsigned int)),indices.data(),GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(glm::vec3),nullptr);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER,0);
+    }
+
+    PositionStream(const PositionStream&) = delete;
+    PositionStream& operator=(const PositionStream&) = delete;
+
+    ~PositionStream()
+    {
+        glDeleteVertexArrays(1,&VAO);
+        glDeleteBuffers(1,&VBO);
+        glDeleteBuffers(1,&EBO);
+    }
+
+    // with the vao bound
+    void draw(const std::uint32_t mesh) const
+    {
+        glDrawElementsBaseVertex(GL_TRIANGLES,draws[mesh].count,GL_UNSIGNED_INT,reinterpret_cast<void*>(draws[mesh].firstIndex),draws[mesh].baseVertex);
+    }
+
+    [[nodiscard]] unsigned int getVAO() const
+    {
+        return VAO;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return draws.size();
+    }
+
+private:
+    struct Draw {
+        int count;
+        std::size_t firstIndex; // bytes
+        int baseVertex;
+    };
+
+    unsigned int VAO{};
+    unsigned int VBO{};
+    unsigned int EBO{};
+    std::vector<Draw> draws; // per mesh
+};
+
+#endif //MYOPENPROJECT_POSITIONSTREAM_H
@@ -0,0 +1,371 @@
+#ifndef MYOPENPROJECT_POSTPROCESS_H
+#define MYOPENPROJECT_POSTPROCESS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "FrameGraph.h"
+#include "Shader.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// The post-processing chain between the resolved scene and the screen,as a list of effects run in order:
+//   pixel:     a GLSL function vec3 name(vec3 color) (and the uniforms it uses),one pixel in,one pixel out,
+//   kernel:    a 3x3 convolution,
+//   separable: a symmetric 1D kernel (centre weight first) run horizontally and then vertically,
+// the filters at full,half or quarter resolution. The effects aren't one pass each: the chain is compiled into as few
+// full screen passes as it can be,each a generated fragment shader,
+//   - a kernel is one pass and a separable filter two (2n+1 taps each instead of (2n+1)^2),
+//   - the pixel effects before the first filter run on every tap it reads,the ones after a filter run at the end of
+//     its pass,so they never cost a pass of their own,
+//   - a filter below full resolution reads the pass before it with bilinear filtering (the downsample is free) and
+//     the pixel effects after the last filter go into a full resolution pass that also upsamples it;the last pass
+//     writes the output at its own size,so a scene rendered below the window's (DynamicResolution) is stretched there.
+// Only a chain without any filter needs the single pass that copies the scene. The passes go into the FrameGraph,
+// each writing an RGBA16F transient of its resolution (the graph lets them share textures like a ping-pong would),
+// so the rounding to 8 bits happens once,on the screen.
+// The plan is rebuilt when effects are switched on or off;the generated programs are kept by their source,
+// so switching back doesn't compile anything.
+class PostProcess
+{
+public:
+    enum class Resolution : unsigned int
+    {
+        full = 1,
+        half = 2,
+        quarter = 4,
+    };
+
+    explicit PostProcess(const char* vertexPath = "frameBufferShader.vs")
+    {
+        std::ifstream file{vertexPath};
+        std::stringstream stream;
+        stream << file.rdbuf();
+        vertexCode = stream.str();
+        if (vertexCode.empty())
+            std::cout << "ERROR::POSTPROCESS:: couldn't read " << vertexPath << std::endl;
+    }
+
+    PostProcess(const PostProcess&) = delete;
+    PostProcess& operator=(const PostProcess&) = delete;
+
+    ~PostProcess()
+    {
+        for (const auto& [source,program] : programs)
+            program.end();
+    }
+
+    // source declares the uniforms the function uses and vec3 name(vec3 color);setUniforms sets them,every frame
+    void addPixel(std::string name,std::string source,std::function<void(const Shader&)> setUniforms = {},const bool enabled = true)
+    {
+        effects.push_back({std::move(name),Kind::pixel,std::move(source),std::move(setUniforms),{},Resolution::full,enabled});
+        dirty = true;
+    }
+
+    // weights row by row,top left first
+    void addKernel(std::string name,const std::array<float,9>& weights,const Resolution resolution = Resolution::full,const bool enabled = true)
+    {
+        effects.push_back({std::move(name),Kind::kernel,{},{},{weights.begin(),weights.end()},resolution,enabled});
+        dirty = true;
+    }
+
+    // weights from the centre out,the other side mirrors them
+    void addSeparable(std::string name,std::vector<float> weights,const Resolution resolution = Resolution::full,const bool enabled = true)
+    {
+        effects.push_back({std::move(name),Kind::separable,{},{},std::move(weights),resolution,enabled});
+        dirty = true;
+    }
+
+    // the centre out half of a normalised gaussian
+    [[nodiscard]] static std::vector<float> gaussian(const unsigned int radius,const float sigma)
+    {
+        std::vector<float> weights(radius + 1);
+        float sum{0.0f};
+        for (unsigned int i{0}; i <= radius; ++i)
+        {
+            weights[i] = std::exp(-static_cast<float>(i * i) / (2.0f * sigma * sigma));
+            sum += i ? 2.0f * weights[i] : weights[i];
+        }
+        for (float& weight : weights)
+            weight /= sum;
+        return weights;
+    }
+
+    void setEnabled(const std::string_view name,const bool enabled)
+    {
+        for (Effect& effect : effects)
+        {
+            if (effect.name == name && effect.enabled != enabled)
+            {
+                effect.enabled = enabled;
+                dirty = true;
+            }
+        }
+    }
+
+    // adds the chain's passes to graph,from input (the scene,inputWidth x inputHeight) to output (outputWidth x outputHeight);
+    // the resolutions of the effects are relative to the input,the last pass scales to the output.
+    // quadVAO is the full screen quad of frameBufferShader.vs
+    void addTo(FrameGraph& graph,const FrameGraph::Handle input,const unsigned int inputWidth,const unsigned int inputHeight,
+               const FrameGraph::Handle output,const unsigned int outputWidth,const unsigned int outputHeight,const unsigned int quadVAO)
+    {
+        if (dirty)
+            compile();
+
+        FrameGraph::Handle previous{input};
+        FrameGraph::TextureDesc previousSize{inputWidth,inputHeight,GL_NONE};
+        for (std::size_t i{0}; i < passes.size(); ++i)
+        {
+            const Pass& pass{passes[i]};
+            const bool last{i + 1 == passes.size()};
+            const FrameGraph::TextureDesc desc{last ? outputWidth : std::max(inputWidth / pass.scale,1u),
+                                               last ? outputHeight : std::max(inputHeight / pass.scale,1u),GL_RGBA16F};
+            // the taps are a texel of the smaller of the two,so a filter that upscales doesn't shrink
+            const glm::vec2 texelSize{1.0f / static_cast<float>(std::min(desc.width,previousSize.width)),
+                                      1.0f / static_cast<float>(std::min(desc.height,previousSize.height))};
+            FrameGraph::Handle result{output};
+            graph.addPass(pass.name,[&](FrameGraph::Builder& builder){
+                builder.read(previous);
+                if (last)
+                    builder.write(output);
+                else
+                    result = builder.create(pass.name,desc);
+            },[this,i,previous,texelSize,quadVAO](const FrameGraph::Context& context){
+                draw(passes[i],context.texture(previous),texelSize,quadVAO);
+            });
+            previous = result;
+            previousSize = desc;
+        }
+    }
+
+    [[nodiscard]] std::size_t passCount()
+    {
+        if (dirty)
+            compile();
+        return passes.size();
+    }
+
+private:
+    enum class Kind
+    {
+        pixel,
+        kernel,
+        separable,
+    };
+
+    struct Effect {
+        std::string name;
+        Kind kind;
+        std::string source;                           // pixel
+        std::function<void(const Shader&)> setUniforms;
+        std::vector<float> weights;                   // kernel,separable
+        Resolution resolution;
+        bool enabled;
+    };
+
+    enum class Sampling
+    {
+        copy,
+        kernel,
+        horizontal,
+        vertical,
+    };
+
+    // a pass before it gets its program
+    struct Draft {
+        Sampling sampling;
+        std::size_t filter;                 // the kernel or separable effect,unless sampling is copy
+        unsigned int scale;
+        std::vector<std::size_t> onTaps;    // pixel effects run on every sample read
+        std::vector<std::size_t> onResult;  // pixel effects run on the filtered color
+    };
+
+    struct Pass {
+        std::string name;                   // in the frame graph
+        const Shader* program;
+        unsigned int scale;
+        std::vector<std::size_t> effects;   // whose uniforms it sets
+    };
+
+    std::string vertexCode;
+    std::vector<Effect> effects;
+    std::vector<Pass> passes;
+    std::unordered_map<std::string,Shader> programs; // by fragment source
+    bool dirty{true};
+
+    void compile()
+    {
+        dirty = false;
+        std::vector<Draft> drafts;
+        std::vector<std::size_t> leading; // pixel effects before the first filter
+        for (std::size_t i{0}; i < effects.size(); ++i)
+        {
+            const Effect& effect{effects[i]};
+            if (!effect.enabled)
+                continue;
+            const auto scale{static_cast<unsigned int>(effect.resolution)};
+            if (effect.kind == Kind::pixel)
+            {
+                if (drafts.empty())
+                    leading.push_back(i);
+                else
+                    drafts.back().onResult.push_back(i);
+            }
+            else if (effect.kind == Kind::kernel)
+            {
+                drafts.push_back({Sampling::kernel,i,scale,std::move(leading),{}});
+                leading.clear();
+            }
+            else
+            {
+                drafts.push_back({Sampling::horizontal,i,scale,std::move(leading),{}});
+                leading.clear();
+                drafts.push_back({Sampling::vertical,i,scale,{},{}});
+            }
+        }
+        if (drafts.empty())
+            drafts.push_back({Sampling::copy,0,1,{},std::move(leading)});
+        else if (drafts.back().scale != 1) // back to full resolution,the last pixel effects with it
+        {
+            std::vector<std::size_t> trailing{std::move(drafts.back().onResult)};
+            drafts.back().onResult.clear();
+            drafts.push_back({Sampling::copy,0,1,{},std::move(trailing)});
+        }
+
+        passes.clear();
+        unsigned int inputScale{1};
+        std::ostringstream plan;
+        plan << "POST-PROCESS: " << drafts.size() << (drafts.size() == 1 ? " pass" : " passes");
+        for (std::size_t i{0}; i < drafts.size(); ++i)
+        {
+            const Draft& draft{drafts[i]};
+            const std::string source{fragmentSource(draft,i > 0 && draft.scale == inputScale)}; // the first one reads the scene
+            auto program{programs.find(source)};
+            if (program == programs.end())
+                program = programs.emplace(source,Shader::fromSource(vertexCode,source)).first;
+
+            std::string name; // what it runs,in order
+            for (const std::size_t effect : draft.onTaps)
+                name += effects[effect].name + '+';
+            if (draft.sampling != Sampling::copy)
+                name += effects[draft.filter].name + (draft.sampling == Sampling::horizontal ? ".x+" : draft.sampling == Sampling::vertical ? ".y+" : "+");
+            for (const std::size_t effect : draft.onResult)
+                name += effects[effect].name + '+';
+            name = name.empty() ? "copy" : name.substr(0,name.size() - 1);
+
+            Pass pass{name,&program->second,draft.scale,{}};
+            pass.effects.insert(pass.effects.end(),draft.onTaps.begin(),draft.onTaps.end());
+            pass.effects.insert(pass.effects.end(),draft.onResult.begin(),draft.onResult.end());
+            passes.push_back(std::move(pass));
+
+            plan << "     [" << (draft.scale == 1 ? "full " : draft.scale == 2 ? "half " : "quarter ") << name << ']';
+            inputScale = draft.scale;
+        }
+        std::cout << plan.str() << '\n';
+    }
+
+    // the graph has bound the pass's target and set its viewport
+    void draw(const Pass& pass,const unsigned int input,const glm::vec2& texelSize,const unsigned int quadVAO) const
+    {
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        pass.program->use();
+        pass.program->setInt("inputTexture",0);
+        pass.program->setVec2("texelSize",texelSize.x,texelSize.y);
+        for (const std::size_t effect : pass.effects)
+        {
+            if (effects[effect].setUniforms)
+                effects[effect].setUniforms(*pass.program);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D,input);
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLES,0,6);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D,0);
+        glEnable(GL_BLEND);
+    }
+
+    [[nodiscard]] static std::string literal(const float value)
+    {
+        std::ostringstream stream;
+        stream << std::showpoint << std::setprecision(std::numeric_limits<float>::max_digits10) << value;
+        return stream.str();
+    }
+
+    // pairedTaps: the input has the pass's resolution and nothing runs on the taps,so two neighbouring taps of a
+    // separable filter can be one bilinear sample between them
+    [[nodiscard]] std::string fragmentSource(const Draft& draft,const bool pairedTaps) const
+    {
+        std::ostringstream code;
+        code << "#version 330 core\n"
+                "// generated by PostProcess\n"
+                "out vec4 FragColor;\n"
+                "in vec2 TexCoords;\n"
+                "uniform sampler2D inputTexture;\n"
+                "uniform vec2 texelSize;\n";
+        for (const std::size_t effect : draft.onTaps)
+            code << effects[effect].source << '\n';
+        for (const std::size_t effect : draft.onResult)
+            code << effects[effect].source << '\n';
+
+        code << "vec3 tap(vec2 offset)\n{\n    vec3 color = texture(inputTexture,TexCoords + offset * texelSize).rgb;\n";
+        for (const std::size_t effect : draft.onTaps)
+            code << "    color = " << effects[effect].name << "(color);\n";
+        code << "    return color;\n}\n";
+
+        code << "void main()\n{\n    vec3 color = vec3(0.0);\n";
+        if (draft.sampling == Sampling::copy)
+            code << "    color = tap(vec2(0.0));\n";
+        else if (draft.sampling == Sampling::kernel)
+        {
+            const std::vector<float>& weights{effects[draft.filter].weights};
+            for (int y{0}; y < 3; ++y)
+            {
+                for (int x{0}; x < 3; ++x)
+                {
+                    const float weight{weights[static_cast<std::size_t>(y * 3 + x)]};
+                    if (weight != 0.0f)
+                        code << "    color += " << literal(weight) << " * tap(vec2(" << x - 1 << ".0," << 1 - y << ".0));\n";
+                }
+            }
+        }
+        else
+        {
+            const std::string axis{draft.sampling == Sampling::horizontal ? "vec2(1.0,0.0)" : "vec2(0.0,1.0)"};
+            const std::vector<float>& weights{effects[draft.filter].weights};
+            code << "    color += " << literal(weights[0]) << " * tap(vec2(0.0));\n";
+            for (std::size_t i{1}; i < weights.size(); i += pairedTaps ? 2 : 1)
+            {
+                float weight{weights[i]};
+                auto offset{static_cast<float>(i)};
+                if (pairedTaps && i + 1 < weights.size())
+                {
+                    weight += weights[i + 1];
+                    offset = (static_cast<float>(i) * weights[i] + static_cast<float>(i + 1) * weights[i + 1]) / weight;
+                }
+                code << "    color += " << literal(weight) << " * (tap(" << literal(offset) << " * " << axis << ") + tap(" << literal(-offset) << " * " << axis << "));\n";
+            }
+        }
+        for (const std::size_t effect : draft.onResult)
+            code << "    color = " << effects[effect].name << "(color);\n";
+        code << "    FragColor = vec4(color,1.0);\n}\n";
+        return code.str();
+    }
+};
+
+#endif //MYOPENPROJECT_POSTPROCESS_H
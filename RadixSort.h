@@ -0,0 +1,155 @@
+#ifndef MYOPENPROJECT_RADIXSORT_H
+#define MYOPENPROJECT_RADIXSORT_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace RadixSort
+{
+    template <typename Key>
+    struct Entry {
+        Key key;
+        std::uint32_t index; // where the sorted thing lives in the caller's array
+    };
+
+    // how a Key is cut into digits: 32 bit keys go in three 11 bit digits,wider keys in 8 bit ones
+    // (their histograms would stop fitting in L1 otherwise). Keys known to stay below 2^keyBits only get
+    // the digits that cover those bits,as even as they can be: fewer buckets make a cheaper pass.
+    template <typename Key,std::size_t keyBits = sizeof(Key) * 8>
+    struct Digits {
+        static constexpr std::size_t maxBits{sizeof(Key) <= 4 ? 11 : 8};
+        static constexpr std::size_t passes{(keyBits + maxBits - 1) / maxBits};
+        static constexpr std::size_t bits{(keyBits + passes - 1) / passes};
+        static constexpr std::size_t radix{std::size_t{1} << bits};
+        static constexpr Key mask{static_cast<Key>(radix - 1)};
+
+        using Histograms = std::array<std::array<std::uint32_t,radix>,passes>;
+
+        // counts the key in every digit's histogram
+        static void count(Histograms& histograms,const Key key)
+        {
+            for (std::size_t digit{0}; digit < passes; ++digit)
+                ++histograms[digit][(key >> (digit * bits)) & mask];
+        }
+    };
+
+    // turns counts into the offset where each bucket starts
+    template <std::size_t radix>
+    void prefixSum(std::array<std::uint32_t,radix>& histogram)
+    {
+        std::uint32_t offset{0};
+        for (std::uint32_t& bucket : histogram)
+        {
+            const std::uint32_t size{bucket};
+            bucket = offset;
+            offset += size;
+        }
+    }
+
+    // LSD radix sort,ascending and stable,with the histograms of every key already counted (by a caller that
+    // counts them while it makes the keys,saving a pass over them);they're used up. Digits where every key
+    // agrees are skipped,and scratch is only ever grown,so a buffer that is reused every frame stops
+    // allocating after the first few frames.
+    template <typename Key,std::size_t radix,std::size_t passes>
+    void sort(std::vector<Entry<Key>>& entries,std::vector<Entry<Key>>& scratch,
+              std::array<std::array<std::uint32_t,radix>,passes>& histograms)
+    {
+        static_assert(std::is_unsigned_v<Key> && std::has_single_bit(radix));
+        constexpr std::size_t bits{std::countr_zero(radix)};
+        constexpr Key mask{static_cast<Key>(radix - 1)};
+
+        const std::size_t count{entries.size()};
+        if (count < 2)
+            return;
+        if (scratch.size() < count)
+            scratch.resize(count);
+
+        Entry<Key>* source{entries.data()};
+        Entry<Key>* destination{scratch.data()};
+        for (std::size_t digit{0}; digit < passes; ++digit)
+        {
+            std::array<std::uint32_t,radix>& histogram = histograms[digit];
+            const std::size_t shift{digit * bits};
+            if (histogram[(source[0].key >> shift) & mask] == count) // every key has the same digit here
+                continue;
+
+            prefixSum(histogram);
+            for (std::size_t i{0}; i < count; ++i)
+                destination[histogram[(source[i].key >> shift) & mask]++] = source[i];
+
+            std::swap(source,destination);
+        }
+
+        if (source != entries.data())
+            std::memcpy(entries.data(),source,count * sizeof(Entry<Key>));
+    }
+
+    // the same sort for callers that only want the order: the last pass that moves anything writes the
+    // indices,in key order,to indices instead of moving the entries once more (they're left scrambled)
+    template <typename Key,std::size_t radix,std::size_t passes>
+    void sortIndices(std::vector<Entry<Key>>& entries,std::vector<Entry<Key>>& scratch,
+                     std::array<std::array<std::uint32_t,radix>,passes>& histograms,std::vector<std::uint32_t>& indices)
+    {
+        static_assert(std::is_unsigned_v<Key> && std::has_single_bit(radix));
+        constexpr std::size_t bits{std::countr_zero(radix)};
+        constexpr Key mask{static_cast<Key>(radix - 1)};
+
+        const std::size_t count{entries.size()};
+        indices.resize(count);
+        if (scratch.size() < count)
+            scratch.resize(count);
+
+        std::array<std::size_t,passes> moving{}; // the digits where the keys differ
+        std::size_t movingPasses{0};
+        for (std::size_t digit{0}; digit < passes && count; ++digit)
+        {
+            if (histograms[digit][(entries[0].key >> (digit * bits)) & mask] != count)
+                moving[movingPasses++] = digit;
+        }
+
+        Entry<Key>* source{entries.data()};
+        Entry<Key>* destination{scratch.data()};
+        for (std::size_t pass{0}; pass < movingPasses; ++pass)
+        {
+            std::array<std::uint32_t,radix>& histogram = histograms[moving[pass]];
+            const std::size_t shift{moving[pass] * bits};
+            prefixSum(histogram);
+            if (pass + 1 == movingPasses)
+            {
+                for (std::size_t i{0}; i < count; ++i)
+                    indices[histogram[(source[i].key >> shift) & mask]++] = source[i].index;
+                return;
+            }
+            for (std::size_t i{0}; i < count; ++i)
+                destination[histogram[(source[i].key >> shift) & mask]++] = source[i];
+            std::swap(source,destination);
+        }
+
+        for (std::size_t i{0}; i < count; ++i) // nothing to move,every key is the same
+            indices[i] = entries[i].index;
+    }
+
+    template <typename Key>
+    void sort(std::vector<Entry<Key>>& entries,std::vector<Entry<Key>>& scratch)
+    {
+        typename Digits<Key>::Histograms histograms{};
+        for (const Entry<Key>& entry : entries)
+            Digits<Key>::count(histograms,entry.key);
+        sort(entries,scratch,histograms);
+    }
+
+    // maps a float to an unsigned int that sorts the same way (negative numbers included)
+    inline std::uint32_t sortableFloat(const float value)
+    {
+        const auto bits{std::bit_cast<std::uint32_t>(value)};
+        const std::uint32_t mask{(bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u};
+        return bits ^ mask;
+    }
+}
+
+#endif //MYOPENPROJECT_RADIXSORT_H
@@ -0,0 +1,270 @@
+#ifndef MYOPENPROJECT_RENDERQUEUE_H
+#define MYOPENPROJECT_RENDERQUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Mesh.h"
+#include "Shader.h"
+#include "RadixSort.h"
+#include "Bounds.h"
+#include "Frustum.h"
+#include "FrustumCuller.h"
+#include "GpuProfiler.h"
+#include "InstanceBuffer.h"
+#include "OcclusionQueries.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Systems submit draw packets here instead of drawing straight away. Every packet gets a 64 bit
+// sort key,the keys are radix sorted once per frame and the packets run in that order,touching
+// only the GL state that differs from the packet before. Packets with bounds can be frustum
+// culled in one batch before sorting. Model meshes run the OcclusionQueries of their model,their box
+// query goes right before them,against the depth of everything drawn so far.
+//
+// key layout,most significant bits first:
+//   opaque,prepassed,skybox: pass(4) | program(8) | material(16) | vao(12) | depth(24)   -> front-to-back inside a state bucket
+//   transparent:   pass(4) | far-to-near depth(24) | program(8) | material(16) | vao(12)   -> back-to-front
+class RenderQueue
+{
+public:
+    enum class Pass : std::uint64_t
+    {
+        opaque,
+        prepassed,   // opaque,with its depth already in the buffer (DepthPrepass): tested,not written
+        skybox,
+        transparent,
+    };
+
+    struct Packet {
+        const Shader* shader{};
+        unsigned int vao{};
+        const Mesh* mesh{};                  // model meshes bring their own vao,material and index count
+        unsigned int texture{};              // otherwise one texture on unit 0 (0 leaves the unit alone)
+        GLenum textureTarget{GL_TEXTURE_2D};
+        int vertexCount{};
+        int instances{};
+        InstanceBuffer::Range instanceData{}; // per-instance streams;when set,its count is the number of instances
+        glm::mat4 transform{1.0f};           // goes to the "transform" uniform,if the program has one
+        AABB bounds{};                       // world space;packets left empty are never culled
+    };
+
+    RenderQueue(const float nearPlane,const float farPlane,const std::size_t expectedPackets = 1024)
+        : nearPlane{nearPlane},farPlane{farPlane}
+    {
+        packets.reserve(expectedPackets);
+        cullIndices.reserve(expectedPackets);
+        entries.reserve(expectedPackets);
+        scratch.reserve(expectedPackets);
+    }
+
+    // viewDepth is the distance along the camera's front vector
+    void submit(const Pass pass,const float viewDepth,const Packet& packet)
+    {
+        const std::uint64_t program{packet.shader->getProgramID() & 0xFFu};
+        const std::uint64_t material{(packet.mesh ? packet.mesh->material.id : packet.texture) & 0xFFFFu};
+        const std::uint64_t vao{(packet.mesh ? packet.mesh->VAO : packet.vao) & 0xFFFu};
+        const std::uint64_t depth{quantizeDepth(viewDepth)};
+
+        std::uint64_t key{static_cast<std::uint64_t>(pass) << 60};
+        if (pass == Pass::transparent)
+            key |= ((maxDepth - depth) << 36) | (program << 28) | (material << 12) | vao;
+        else
+            key |= (program << 52) | (material << 36) | (vao << 24) | depth;
+
+        entries.push_back({key,static_cast<std::uint32_t>(packets.size())});
+        cullIndices.push_back(packet.bounds.isEmpty() ? notCulled : culler.add(packet.bounds));
+        packets.push_back(packet);
+    }
+
+    // drops the packets whose bounds are outside the frustum,call it after the last submit
+    void cull(const Frustum& frustum)
+    {
+        culler.cull(frustum);
+        std::erase_if(entries,[this](const RadixSort::Entry<std::uint64_t>& entry){
+            const std::size_t cullIndex{cullIndices[entry.index]};
+            return cullIndex != notCulled && !culler.isVisible(cullIndex);
+        });
+    }
+
+    void sort()
+    {
+        RadixSort::sort(entries,scratch);
+    }
+
+    // every pass of the key that has packets is a section of the profiler,if there is one
+    void execute(GpuProfiler* profiler = nullptr)
+    {
+        unsigned int program{0};
+        int transformLocation{-1};
+        unsigned int material{0}; // Material::id,they start at 1
+        unsigned int texture{0};
+        unsigned int vao{0};
+        std::uint64_t pass{~0ull};
+        bool writesDepth{true};
+        stateChanges = 0;
+
+        for (const RadixSort::Entry<std::uint64_t>& entry : entries)
+        {
+            const Packet& packet = packets[entry.index];
+
+            if (const std::uint64_t packetPass{entry.key >> 60}; packetPass != pass)
+            {
+                if (profiler)
+                {
+                    if (pass != ~0ull)
+                        profiler->end();
+                    profiler->begin(sectionNames[packetPass]);
+                }
+                pass = packetPass;
+                writesDepth = static_cast<Pass>(pass) == Pass::opaque || static_cast<Pass>(pass) == Pass::transparent;
+                glDepthMask(writesDepth ? GL_TRUE : GL_FALSE); // the skybox sits behind everything
+            }
+
+            std::optional<OcclusionQueries::Conditional> conditional;
+            if (packet.mesh && packet.mesh->occlusion) // its box is tested first and it's drawn conditionally
+            {
+                conditional = packet.mesh->occlusion->beforeDraw(packet.mesh->occlusionIndex,*packet.mesh,packet.transform);
+                if (conditional) // the box took the program,the vao and the depth writes
+                {
+                    program = 0;
+                    vao = 0;
+                    glDepthMask(writesDepth ? GL_TRUE : GL_FALSE);
+                }
+            }
+
+            if (packet.shader->getProgramID() != program)
+            {
+                program = packet.shader->getProgramID();
+                packet.shader->use();
+                transformLocation = locationOfTransform(program);
+                material = 0; // the layer uniform of a material belongs to the program
+                ++stateChanges;
+            }
+
+            if (packet.mesh)
+            {
+                if (packet.mesh->material.id != material)
+                {
+                    material = packet.mesh->material.id;
+                    packet.mesh->material.bind(*packet.shader);
+                    texture = 0; // unit 0 now holds the material's diffuse map
+                    ++stateChanges;
+                }
+            }
+            else if (packet.texture && packet.texture != texture)
+            {
+                texture = packet.texture;
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(packet.textureTarget,texture);
+                material = 0;
+                ++stateChanges;
+            }
+
+            const unsigned int packetVAO{packet.mesh ? packet.mesh->VAO : packet.vao};
+            if (packetVAO != vao)
+            {
+                vao = packetVAO;
+                glBindVertexArray(vao);
+                ++stateChanges;
+            }
+
+            if (transformLocation != -1)
+                glUniformMatrix4fv(transformLocation,1,GL_FALSE,glm::value_ptr(packet.transform));
+
+            const int instances{packet.instanceData.count ? packet.instanceData.count : packet.instances};
+            if (packet.instanceData.count)
+                InstanceBuffer::bindAttributes(packet.instanceData);
+
+            if (conditional)
+                glBeginConditionalRender(conditional->query,conditional->mode);
+            if (packet.mesh)
+            {
+                const auto count{static_cast<int>(packet.mesh->indices.size())};
+                if (!instances)
+                    glDrawElements(GL_TRIANGLES,count,GL_UNSIGNED_INT,nullptr);
+                else
+                    glDrawElementsInstanced(GL_TRIANGLES,count,GL_UNSIGNED_INT,nullptr,instances);
+            }
+            else
+            {
+                if (!instances)
+                    glDrawArrays(GL_TRIANGLES,0,packet.vertexCount);
+                else
+                    glDrawArraysInstanced(GL_TRIANGLES,0,packet.vertexCount,instances);
+            }
+            if (conditional)
+                glEndConditionalRender();
+
+            if (packet.instanceData.count) // the vao may be drawn again without instance data
+                InstanceBuffer::unbindAttributes();
+        }
+
+        if (profiler && pass != ~0ull)
+            profiler->end();
+        glBindVertexArray(0);
+        glDepthMask(GL_TRUE);
+    }
+
+    // keeps the capacity,so a steady scene stops allocating after the first frames
+    void clear()
+    {
+        packets.clear();
+        cullIndices.clear();
+        entries.clear();
+        culler.clear();
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return packets.size();
+    }
+
+    [[nodiscard]] unsigned int getStateChanges() const // program,material,texture and vao switches of the last execute
+    {
+        return stateChanges;
+    }
+
+private:
+    static constexpr std::uint64_t maxDepth{0xFFFFFF};
+    static constexpr std::size_t notCulled{~std::size_t{0}};
+    static constexpr std::array<std::string_view,4> sectionNames{"opaqueDraws","prepassedDraws","skyboxDraws","transparentDraws"}; // by Pass
+
+    float nearPlane;
+    float farPlane;
+    unsigned int stateChanges{};
+
+    std::vector<Packet> packets;
+    std::vector<std::size_t> cullIndices; // per packet,into culler
+    FrustumCuller culler;
+    std::vector<RadixSort::Entry<std::uint64_t>> entries;
+    std::vector<RadixSort::Entry<std::uint64_t>> scratch;
+    std::vector<std::pair<unsigned int,int>> transformLocations; // (program,location)
+
+    [[nodiscard]] std::uint64_t quantizeDepth(const float viewDepth) const
+    {
+        const float normalized{std::clamp((viewDepth - nearPlane) / (farPlane - nearPlane),0.0f,1.0f)};
+        return static_cast<std::uint64_t>(normalized * static_cast<float>(maxDepth));
+    }
+
+    int locationOfTransform(const unsigned int program)
+    {
+        for (const auto& [programID,location] : transformLocations)
+        {
+            if (programID == program)
+                return location;
+        }
+        const int location{glGetUniformLocation(program,"transform")};
+        transformLocations.emplace_back(program,location);
+        return location;
+    }
+};
+
+#endif //MYOPENPROJECT_RENDERQUEUE_H
@@ -7,6 +7,8 @@
 
 #include <glad/glad.h>
 
+#include "CpuProfiler.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -20,6 +22,7 @@ public:
     // constructor reads and builds the shader
     Shader(const char* vertexPath, const char* fragmentPath)
     {
+        PROFILE_SCOPE("Shader");
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -52,33 +55,21 @@ public:
         std::cout << "Vertex shader size: " << vertexCode.size() << "\n";
         std::cout << "Fragment shader size: " << fragmentCode.size() << "\n";
 
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
         // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, nullptr);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, nullptr);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+        compile(vertexCode, fragmentCode);
+    }
+    // for generated code (PostProcess),the sources themselves instead of their paths
+    [[nodiscard]] static Shader fromSource(const std::string& vertexCode, const std::string& fragmentCode)
+    {
+        PROFILE_FUNCTION();
+        Shader shader;
+        shader.compile(vertexCode, fragmentCode);
+        return shader;
     }
     //for three shaders(I might move it into the other constructor)
     Shader(const char* vertexPath,const char* geometryPath, const char* fragmentPath)
     {
+        PROFILE_SCOPE("Shader");
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -181,6 +172,11 @@ public:
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()),1,GL_FALSE, glm::value_ptr(matrix));
     }
 
+    void setVec2(const std::string &name , float x,float y) const
+    {
+        glUniform2f(glGetUniformLocation(ID,name.c_str()),x,y);
+    }
+
     void setVec3(const std::string &name , float x,float y,float z) const
     {
         glUniform3f(glGetUniformLocation(ID,name.c_str()),x,y,z);
@@ -207,7 +203,35 @@ public:
 
 private:
 
-    unsigned int ID;
+    unsigned int ID{};
+
+    Shader() = default;
+
+    void compile(const std::string& vertexCode, const std::string& fragmentCode)
+    {
+        const char* vShaderCode = vertexCode.c_str();
+        const char * fShaderCode = fragmentCode.c_str();
+        unsigned int vertex, fragment;
+        // vertex shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, nullptr);
+        glCompileShader(vertex);
+        checkCompileErrors(vertex, "VERTEX");
+        // fragment Shader
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, nullptr);
+        glCompileShader(fragment);
+        checkCompileErrors(fragment, "FRAGMENT");
+        // shader Program
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        glAttachShader(ID, fragment);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        // delete the shaders as they're linked into our program now and no longer necessary
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+    }
 
 
     static void checkCompileErrors(unsigned int shader, std::string_view type)
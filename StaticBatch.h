@@ -0,0 +1,254 @@
+#ifndef MYOPENPROJECT_STATICBATCH_H
+#define MYOPENPROJECT_STATICBATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "GLExtensions.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "OcclusionQueries.h"
+#include "Shader.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// GPU driven submission for static meshes that share the Vertex layout and one program.
+// The meshes are copied into a single vertex/index buffer once;every frame the visible ones are
+// added with their transform,and draw() writes one DrawElementsIndirectCommand per instance and
+// issues a single glMultiDrawElementsIndirect for every set of meshes with the same texture bindings.
+// Transforms and material indices go through shader storage buffers read with gl_DrawID
+// (shader_indirect.vs),so the CPU cost barely grows with the number of meshes.
+// A multi-draw can't drop meshes one by one,so the meshes' OcclusionQueries work on the CPU side here:add() leaves
+// out what the read-back results hide,and draw() tests the boxes of every added mesh after the batch.
+// Needs GL 4.3 (GLExtensions::multiDrawIndirect);without it the meshes keep their own draw calls.
+class StaticBatch
+{
+public:
+    explicit StaticBatch(const std::vector<Mesh>& meshes) // they have to outlive the batch
+        : meshes{meshes}
+    {
+        if (!GLExtensions::multiDrawIndirect)
+            return;
+
+        std::vector<Mesh::Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<glm::ivec4> materialLayers;
+        for (const Mesh& mesh : meshes)
+        {
+            ranges.push_back({static_cast<unsigned int>(mesh.indices.size()),static_cast<unsigned int>(indices.size()),
+                              static_cast<int>(vertices.size()),groupFor(mesh.material),static_cast<unsigned int>(materialLayers.size())});
+            vertices.insert(vertices.end(),mesh.vertices.begin(),mesh.vertices.end());
+            indices.insert(indices.end(),mesh.indices.begin(),mesh.indices.end());
+            materialLayers.emplace_back(mesh.material.layers[0],mesh.material.layers[1],mesh.material.layers[2],mesh.material.layers[3]);
+        }
+
+        glGenVertexArrays(1,&VAO);
+        glGenBuffers(1,&VBO);
+        glGenBuffers(1,&EBO);
+        glGenBuffers(1,&drawIndexBuffer);
+        glGenBuffers(1,&indirectBuffer);
+        glGenBuffers(1,&drawBuffer);
+        glGenBuffers(1,&materialBuffer);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER,VBO);
+        glBufferData(GL_ARRAY_BUFFER,static_cast<long>(vertices.size() * sizeof(Mesh::Vertex)),vertices.data(),GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,static_cast<long>(indices.size() * sizeof(unsigned int)),indices.data(),GL_STATIC_DRAW);
+        Mesh::setupVertexAttributes();
+        glBindVertexArray(0);
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER,materialBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER,static_cast<long>(materialLayers.size() * sizeof(glm::ivec4)),materialLayers.data(),GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+
+        growBuffers(static_cast<unsigned int>(meshes.size()));
+    }
+
+    StaticBatch(const StaticBatch&) = delete;
+    StaticBatch& operator=(const StaticBatch&) = delete;
+
+    ~StaticBatch() // all 0 without multi-draw support,which GL ignores
+    {
+        glDeleteVertexArrays(1,&VAO);
+        const std::array<unsigned int,6> buffers{VBO,EBO,drawIndexBuffer,indirectBuffer,drawBuffer,materialBuffer};
+        glDeleteBuffers(static_cast<int>(buffers.size()),buffers.data());
+    }
+
+    [[nodiscard]] bool isSupported() const
+    {
+        return VAO != 0;
+    }
+
+    // one visible instance of meshes[mesh] for this frame
+    void add(const std::size_t mesh,const glm::mat4& transform)
+    {
+        if (const Mesh& added = meshes[mesh]; added.occlusion)
+        {
+            queried.push_back({static_cast<unsigned int>(mesh),transform});
+            if (added.occlusion->isOccluded(added.occlusionIndex,added))
+                return;
+        }
+        const MeshRange& range = ranges[mesh];
+        groups[range.group].instances.push_back({static_cast<unsigned int>(mesh),transform});
+    }
+
+    void draw(const Shader& shader)
+    {
+        commands.clear();
+        draws.clear();
+        for (Group& group : groups)
+        {
+            group.firstCommand = static_cast<unsigned int>(commands.size());
+            for (const Instance& instance : group.instances)
+            {
+                const MeshRange& range = ranges[instance.mesh];
+                const auto drawIndex{static_cast<unsigned int>(commands.size())};
+                commands.push_back({range.count,1,range.firstIndex,range.baseVertex,drawIndex}); // baseInstance feeds aDrawIndex
+                draws.push_back({instance.transform,{range.material,0,0,0}});
+            }
+        }
+        if (commands.empty())
+        {
+            testOcclusion();
+            return;
+        }
+
+        if (commands.size() > capacity)
+            growBuffers(static_cast<unsigned int>(commands.size()) * 2);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER,indirectBuffer);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER,0,static_cast<long>(commands.size() * sizeof(DrawElementsIndirectCommand)),commands.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER,drawBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER,0,static_cast<long>(draws.size() * sizeof(DrawData)),draws.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER,0,drawBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER,1,materialBuffer);
+
+        shader.use();
+        const int drawOffsetLocation{glGetUniformLocation(shader.getProgramID(),"drawOffset")};
+        glBindVertexArray(VAO);
+        for (Group& group : groups)
+        {
+            if (group.instances.empty())
+                continue;
+
+            group.material->bind(shader);
+            glUniform1i(drawOffsetLocation,static_cast<int>(group.firstCommand)); // gl_DrawID starts at 0 for every call
+            GLExtensions::multiDrawElementsIndirect(GL_TRIANGLES,GL_UNSIGNED_INT,
+                reinterpret_cast<const void*>(group.firstCommand * sizeof(DrawElementsIndirectCommand)),
+                static_cast<GLsizei>(group.instances.size()),0);
+            group.instances.clear();
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER,0);
+        testOcclusion();
+    }
+
+    [[nodiscard]] std::size_t drawCalls() const // multi draws issued per draw(),one per texture binding set
+    {
+        return groups.size();
+    }
+
+private:
+    struct DrawElementsIndirectCommand {
+        unsigned int count;
+        unsigned int instanceCount;
+        unsigned int firstIndex;
+        int baseVertex;
+        unsigned int baseInstance;
+    };
+
+    struct DrawData { // std430 layout of DrawData in shader_indirect.vs
+        glm::mat4 transform;
+        glm::uvec4 material; // x is the index into the material buffer
+    };
+
+    struct MeshRange {
+        unsigned int count;
+        unsigned int firstIndex;
+        int baseVertex;
+        std::size_t group;
+        unsigned int material;
+    };
+
+    struct Instance {
+        unsigned int mesh;
+        glm::mat4 transform;
+    };
+
+    struct Group {
+        const Material* material;
+        std::vector<Instance> instances;
+        unsigned int firstCommand;
+    };
+
+    const std::vector<Mesh>& meshes;
+    unsigned int VAO{};
+    unsigned int VBO{};
+    unsigned int EBO{};
+    unsigned int drawIndexBuffer{}; // 0,1,2... read per instance,so baseInstance turns into the draw index without ARB_shader_draw_parameters
+    unsigned int indirectBuffer{};
+    unsigned int drawBuffer{};
+    unsigned int materialBuffer{};
+    unsigned int capacity{};
+
+    std::vector<MeshRange> ranges;
+    std::vector<Group> groups;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<DrawData> draws;
+    std::vector<Instance> queried; // the added meshes that have occlusion queries,this frame
+
+    // the box queries that are due,against everything the batch drew;leaves depth writes off and the box program bound
+    void testOcclusion()
+    {
+        for (const Instance& instance : queried)
+        {
+            const Mesh& mesh = meshes[instance.mesh];
+            mesh.occlusion->test(mesh.occlusionIndex,mesh,instance.transform);
+        }
+        queried.clear();
+    }
+
+    std::size_t groupFor(const Material& material)
+    {
+        for (std::size_t i{0}; i < groups.size(); ++i)
+        {
+            if (groups[i].material->sameBindings(material))
+                return i;
+        }
+        groups.push_back({&material,{},0});
+        return groups.size() - 1;
+    }
+
+    void growBuffers(const unsigned int newCapacity)
+    {
+        capacity = newCapacity;
+
+        std::vector<unsigned int> drawIndices(capacity);
+        for (unsigned int i{0}; i < capacity; ++i)
+            drawIndices[i] = i;
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER,drawIndexBuffer);
+        glBufferData(GL_ARRAY_BUFFER,static_cast<long>(capacity * sizeof(unsigned int)),drawIndices.data(),GL_STATIC_DRAW);
+        glEnableVertexAttribArray(7);
+        glVertexAttribIPointer(7,1,GL_UNSIGNED_INT,sizeof(unsigned int),nullptr);
+        glVertexAttribDivisor(7,1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER,0);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER,indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER,static_cast<long>(capacity * sizeof(DrawElementsIndirectCommand)),nullptr,GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER,0);
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER,drawBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER,static_cast<long>(capacity * sizeof(DrawData)),nullptr,GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+    }
+};
+
+#endif //MYOPENPROJECT_STATICBATCH_H
@@ -0,0 +1,187 @@
+#ifndef MYOPENPROJECT_TEMPORALAA_H
+#define MYOPENPROJECT_TEMPORALAA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "FrameGraph.h"
+#include "Shader.h"
+
+#include <array>
+#include <cmath>
+
+// Temporal anti-aliasing,one of the modes of AntiAliasing. The scene is drawn into its single sampled target,
+// the projection shifted every frame by a sub-pixel offset from a Halton(2,3) sequence,so over a few frames every
+// pixel gets sampled in different places. addTo() adds two passes after the scene:
+//   motion:   how far every pixel moved on screen since the last frame: what moves on its own wrote its motion into
+//             the scene's velocity attachment (renderVelocity()),everything else gets the camera's,from its depth
+//             and the last frame's view projection (taamotion.fs),
+//   temporal: at the output size,reprojects the last result with the motion and blends this frame's nearest
+//             sample into it (taaresolve.fs). The history is clipped to the color box of the 3x3 samples around
+//             the pixel first,so what got uncovered or changed doesn't smear,and read with Catmull-Rom so it stays sharp.
+// Its result is the next frame's history. When the scene is rendered below the output size (temporal upscaling)
+// the jitter sequence gets longer,so the output pixels between the rendered ones get samples in turn;a sample
+// counts less the further it lands from the pixel.
+class TemporalAA
+{
+public:
+    static constexpr float blend{0.1f};            // of this frame's sample,where it lands right on the pixel
+    static constexpr unsigned int jitterPhases{8}; // at the output resolution,times the output pixels per rendered one
+
+    TemporalAA(const unsigned int width,const unsigned int height) // of the output
+        : width{width},height{height}
+    {
+        glGenTextures(2,history.data());
+        for (const unsigned int texture : history)
+        {
+            glBindTexture(GL_TEXTURE_2D,texture);
+            glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA16F,static_cast<int>(width),static_cast<int>(height),0,GL_RGBA,GL_HALF_FLOAT,nullptr);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
+        }
+        glBindTexture(GL_TEXTURE_2D,0);
+
+        motionPass.use();
+        motionPass.setInt("sceneDepth",0);
+        motionPass.setInt("velocity",1);
+        const unsigned int velocityProgram{velocityPass.getProgramID()};
+        glUniformBlockBinding(velocityProgram,glGetUniformBlockIndex(velocityProgram,"Perspective"),0);
+        resolvePass.use();
+        resolvePass.setInt("scene",0);
+        resolvePass.setInt("sceneDepth",1);
+        resolvePass.setInt("motion",2);
+        resolvePass.setInt("history",3);
+        resolvePass.setVec2("outputSize",static_cast<float>(width),static_cast<float>(height));
+        resolvePass.setFloat("blend",blend);
+    }
+
+    TemporalAA(const TemporalAA&) = delete;
+    TemporalAA& operator=(const TemporalAA&) = delete;
+
+    ~TemporalAA()
+    {
+        glDeleteTextures(2,history.data());
+    }
+
+    // a frame without it,the history is stale by the time it's back on
+    void invalidate()
+    {
+        historyValid = false;
+    }
+
+    // the projection the scene is drawn with this frame,shifted by the next offset of the sequence;
+    // projection and view are the unjittered ones,culling and shadows keep using those
+    [[nodiscard]] glm::mat4 beginFrame(const glm::mat4& projection,const glm::mat4& view,const unsigned int renderWidth,const unsigned int renderHeight)
+    {
+        renderSize = {static_cast<float>(renderWidth),static_cast<float>(renderHeight)};
+        const float outputPerRendered{static_cast<float>(width) / renderSize.x};
+        const auto phases{jitterPhases * static_cast<unsigned int>(std::ceil(outputPerRendered * outputPerRendered - 1e-3f))};
+        phase = (phase + 1) % phases;
+        jitter = {halton(phase + 1,2) - 0.5f,halton(phase + 1,3) - 0.5f};
+
+        viewProjection = projection * view;
+        if (!historyValid)
+            previousViewProjection = viewProjection;
+        return glm::translate(glm::mat4(1.0f),glm::vec3(2.0f * jitter / renderSize,0.0f)) * projection; // in NDC,after the divide
+    }
+
+    // the velocity of what moves on its own (the light cubes),which the depth can't tell,into the bound framebuffer's
+    // draw buffers cleared to 0 (no velocity written). After the opaque passes: drawMoving(shader) draws the moving
+    // objects again with shader (velocity.vs),instanced,with the displacement of their instances set;depth writes are
+    // off,so only what is on screen writes
+    template<typename DrawMoving>
+    void renderVelocity(DrawMoving&& drawMoving)
+    {
+        velocityPass.use();
+        velocityPass.setMat4("viewProjection",viewProjection);
+        velocityPass.setMat4("previousViewProjection",previousViewProjection);
+        glDepthMask(GL_FALSE);
+        glDisable(GL_BLEND);
+        drawMoving(velocityPass);
+        glEnable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+    }
+
+    // the motion and temporal passes,reading the bottom left renderWidth x renderHeight of the scene's color,velocity
+    // and depth textures (scene is the graph's handle of their framebuffer);returns the result,at the output size
+    FrameGraph::Handle addTo(FrameGraph& graph,const FrameGraph::Handle scene,const FrameGraph::Handle colors,
+                             const FrameGraph::Handle velocity,const FrameGraph::Handle depth,const unsigned int quadVAO)
+    {
+        const FrameGraph::Handle previous{graph.importTexture("history",history[current ^ 1])};
+        const FrameGraph::Handle result{graph.importTexture("temporal",history[current],{width,height,GL_RGBA16F})};
+
+        FrameGraph::Handle motion{};
+        graph.addPass("motion",[&](FrameGraph::Builder& builder){
+            builder.read(scene);
+            builder.read(velocity);
+            builder.read(depth);
+            motion = builder.create("motion",{static_cast<unsigned int>(renderSize.x),static_cast<unsigned int>(renderSize.y),GL_RG16F});
+        },[this,velocity,depth,quadVAO](const FrameGraph::Context& context){
+            motionPass.use();
+            motionPass.setVec2("renderSize",renderSize.x,renderSize.y);
+            motionPass.setVec2("jitter",jitter.x,jitter.y);
+            motionPass.setMat4("inverseViewProjection",glm::inverse(viewProjection));
+            motionPass.setMat4("previousViewProjection",previousViewProjection);
+            FrameGraph::drawQuad(quadVAO,{context.texture(depth),context.texture(velocity)});
+        });
+
+        graph.addPass("temporal",[&](FrameGraph::Builder& builder){
+            builder.read(scene);
+            builder.read(colors);
+            builder.read(depth);
+            builder.read(motion);
+            builder.read(previous);
+            builder.write(result);
+        },[this,colors,depth,motion,previous,quadVAO](const FrameGraph::Context& context){
+            resolvePass.use();
+            resolvePass.setVec2("renderSize",renderSize.x,renderSize.y);
+            resolvePass.setVec2("jitter",jitter.x,jitter.y);
+            resolvePass.setBool("historyValid",historyValid);
+            FrameGraph::drawQuad(quadVAO,{context.texture(colors),context.texture(depth),context.texture(motion),context.texture(previous)});
+        });
+        return result;
+    }
+
+    // after the frame's passes ran: this frame's result becomes the history
+    void endFrame()
+    {
+        current ^= 1;
+        previousViewProjection = viewProjection;
+        historyValid = true;
+    }
+
+private:
+    std::array<unsigned int,2> history{}; // ping-pong,the result of one frame is read by the next
+    Shader motionPass{"frameBufferShader.vs","taamotion.fs"};
+    Shader resolvePass{"frameBufferShader.vs","taaresolve.fs"};
+    Shader velocityPass{"velocity.vs","velocity.fs"};
+    unsigned int width;
+    unsigned int height;
+
+    unsigned int current{0};
+    bool historyValid{false};
+    unsigned int phase{0};
+    glm::vec2 jitter{0.0f};         // in rendered pixels
+    glm::vec2 renderSize{1.0f};
+    glm::mat4 viewProjection{1.0f}; // unjittered
+    glm::mat4 previousViewProjection{1.0f};
+
+    // the index-th number of the van der Corput sequence in base
+    [[nodiscard]] static float halton(unsigned int index,const unsigned int base)
+    {
+        float result{0.0f};
+        float fraction{1.0f};
+        while (index > 0)
+        {
+            fraction /= static_cast<float>(base);
+            result += fraction * static_cast<float>(index % base);
+            index /= base;
+        }
+        return result;
+    }
+};
+
+#endif //MYOPENPROJECT_TEMPORALAA_H
@@ -0,0 +1,165 @@
+#ifndef MYOPENPROJECT_TEXTUREPACKER_H
+#define MYOPENPROJECT_TEXTUREPACKER_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <optional>
+#include <vector>
+
+// Packs already loaded 2D textures into GL_TEXTURE_2D_ARRAY objects,one array for every
+// (width,height,internal format) combination. A material then only needs the array and a layer
+// index,so meshes that share an array can be drawn without rebinding anything. The packer owns the
+// arrays,they're deleted with it.
+class TexturePacker
+{
+public:
+    struct Location {
+        unsigned int arrayID;
+        int layer;
+    };
+
+    TexturePacker() = default;
+    TexturePacker(const TexturePacker&) = delete;
+    TexturePacker& operator=(const TexturePacker&) = delete;
+
+    ~TexturePacker()
+    {
+        for (const Group& group : groups)
+        {
+            if (group.arrayID)
+                glDeleteTextures(1,&group.arrayID);
+        }
+    }
+
+    void add(const unsigned int textureID)
+    {
+        glBindTexture(GL_TEXTURE_2D,textureID);
+        int width{};
+        int height{};
+        int internalFormat{};
+        glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_WIDTH,&width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_HEIGHT,&height);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D,0,GL_TEXTURE_INTERNAL_FORMAT,&internalFormat);
+        glBindTexture(GL_TEXTURE_2D,0);
+
+        if (!width || !height || !pixelFormat(internalFormat)) // failed loads and formats we can't read back stay as they are
+            return;
+
+        for (Group& group : groups)
+        {
+            if (group.width == width && group.height == height && group.internalFormat == internalFormat)
+            {
+                group.textures.push_back(textureID);
+                return;
+            }
+        }
+        groups.push_back({width,height,internalFormat,{textureID},0});
+    }
+
+    // creates the arrays and copies the base level of every texture into its layer
+    void build()
+    {
+        int packAlignment{};
+        int unpackAlignment{};
+        glGetIntegerv(GL_PACK_ALIGNMENT,&packAlignment);
+        glGetIntegerv(GL_UNPACK_ALIGNMENT,&unpackAlignment);
+        glPixelStorei(GL_PACK_ALIGNMENT,1); // rgb rows aren't 4 byte aligned in general
+        glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+
+        std::vector<unsigned char> pixels;
+        for (Group& group : groups)
+        {
+            const GLenum format{*pixelFormat(group.internalFormat)};
+            const auto layers{static_cast<int>(group.textures.size())};
+
+            glGenTextures(1,&group.arrayID);
+            glBindTexture(GL_TEXTURE_2D_ARRAY,group.arrayID);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY,0,group.internalFormat,group.width,group.height,layers,0,format,GL_UNSIGNED_BYTE,nullptr);
+
+            pixels.resize(static_cast<std::size_t>(group.width) * static_cast<std::size_t>(group.height) * channels(format));
+            for (int layer{0}; layer < layers; ++layer)
+            {
+                glBindTexture(GL_TEXTURE_2D,group.textures[static_cast<std::size_t>(layer)]);
+                glGetTexImage(GL_TEXTURE_2D,0,format,GL_UNSIGNED_BYTE,pixels.data());
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY,0,0,0,layer,group.width,group.height,1,format,GL_UNSIGNED_BYTE,pixels.data());
+            }
+            glBindTexture(GL_TEXTURE_2D,0);
+
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_WRAP_S,GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_WRAP_T,GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+
+            std::cout << "TEXTURE ARRAY: " << group.width << "x" << group.height << "     LAYERS: " << layers << '\n';
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY,0);
+
+        glPixelStorei(GL_PACK_ALIGNMENT,packAlignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT,unpackAlignment);
+    }
+
+    [[nodiscard]] std::optional<Location> find(const unsigned int textureID) const
+    {
+        for (const Group& group : groups)
+        {
+            for (std::size_t layer{0}; layer < group.textures.size(); ++layer)
+            {
+                if (group.textures[layer] == textureID)
+                    return Location{group.arrayID,static_cast<int>(layer)};
+            }
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] std::size_t arrayCount() const
+    {
+        return groups.size();
+    }
+
+private:
+    struct Group {
+        int width;
+        int height;
+        int internalFormat;
+        std::vector<unsigned int> textures; // the index is the layer
+        unsigned int arrayID;
+    };
+
+    std::vector<Group> groups;
+
+    // TextureFromFile only creates 8 bit red/rgb/rgba textures,linear or srgb
+    static std::optional<GLenum> pixelFormat(const int internalFormat)
+    {
+        switch (internalFormat)
+        {
+            case GL_RED:
+            case GL_R8:
+                return GL_RED;
+            case GL_RGB:
+            case GL_RGB8:
+            case GL_SRGB:
+            case GL_SRGB8:
+                return GL_RGB;
+            case GL_RGBA:
+            case GL_RGBA8:
+            case GL_SRGB_ALPHA:
+            case GL_SRGB8_ALPHA8:
+                return GL_RGBA;
+            default:
+                return std::nullopt;
+        }
+    }
+
+    static std::size_t channels(const GLenum format)
+    {
+        if (format == GL_RED)
+            return 1;
+        if (format == GL_RGB)
+            return 3;
+        return 4;
+    }
+};
+
+#endif //MYOPENPROJECT_TEXTUREPACKER_H
@@ -0,0 +1,99 @@
+#ifndef MYOPENPROJECT_THREADPOOL_H
+#define MYOPENPROJECT_THREADPOOL_H
+
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// A fixed set of worker threads pulling jobs from one queue,for CPU work that can be split
+// into independent pieces (BVH builds,occlusion rasterization). Jobs must not wait on other
+// jobs of the same pool;split the work up front and wait from the calling thread instead.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(const unsigned int threadCount = std::max(2u,std::thread::hardware_concurrency()) - 1)
+    {
+        workers.reserve(threadCount);
+        for (unsigned int i{0}; i < threadCount; ++i)
+            workers.emplace_back([this](const std::stop_token& stop){ work(stop); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template<typename F>
+    std::future<void> submit(F&& job)
+    {
+        std::packaged_task<void()> task{std::forward<F>(job)};
+        std::future<void> done{task.get_future()};
+        {
+            std::scoped_lock lock{mutex};
+            jobs.push(std::move(task));
+        }
+        wakeUp.notify_one();
+        return done;
+    }
+
+    // calls job(begin,end) over [0,count) in about one chunk per thread,the calling thread takes the last one
+    template<typename F>
+    void parallelFor(const std::size_t count,F&& job)
+    {
+        const std::size_t chunks{std::min(count,workers.size() + 1)};
+        if (chunks <= 1)
+        {
+            job(std::size_t{0},count);
+            return;
+        }
+
+        const std::size_t chunkSize{(count + chunks - 1) / chunks};
+        std::vector<std::future<void>> pending;
+        pending.reserve(chunks - 1);
+        std::size_t begin{0};
+        for (; begin + chunkSize < count; begin += chunkSize)
+            pending.push_back(submit([&job,begin,end = begin + chunkSize]{ job(begin,end); }));
+
+        job(begin,count);
+        for (std::future<void>& done : pending)
+            done.get();
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return workers.size();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable_any wakeUp;
+    std::queue<std::packaged_task<void()>> jobs;
+    std::vector<std::jthread> workers; // last,so the threads are stopped and joined before the queue goes away
+
+    void work(const std::stop_token& stop)
+    {
+        PROFILE_THREAD("worker");
+        while (true)
+        {
+            std::packaged_task<void()> job;
+            {
+                std::unique_lock lock{mutex};
+                if (!wakeUp.wait(lock,stop,[this]{ return !jobs.empty(); }))
+                    return; // stop was requested with nothing left to do
+                job = std::move(jobs.front());
+                jobs.pop();
+            }
+            PROFILE_SCOPE("job");
+            job();
+        }
+    }
+};
+
+#endif //MYOPENPROJECT_THREADPOOL_H
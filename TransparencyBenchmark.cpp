@@ -0,0 +1,122 @@
+// Times TransparencySorter on random instances around the camera (keys,radix sort and the draw list,the way
+// renderWindows uses it each frame) against std::sort on the same distances,and checks the order it gives:
+// every instance once,farthest first (up to the key's precision,instances whose squared distances are within
+// 1/4096 of each other may come in the order they were added). Prints whether the sort made the 1 ms target
+// for 100k instances. Needs no window or GL context.
+//   ./TRANSPARENCY_BENCHMARK [instance counts...]   defaults to 1000,100000 and 1000000
+
+#include <glm/glm.hpp>
+
+#include "TransparencySorter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace
+{
+    constexpr float tieTolerance{1.0f + 1.0f / 2048.0f}; // TransparencySorter keeps 12 bits of mantissa,ties are within 1/4096
+    constexpr double targetMilliseconds{1.0};           // per frame,for targetInstances
+    constexpr std::size_t targetInstances{100'000};
+
+    template<typename F>
+    double milliseconds(F&& work,const int repeats = 1) // best of repeats
+    {
+        double best{1e30};
+        for (int i{0}; i < repeats; ++i)
+        {
+            const auto start{std::chrono::steady_clock::now()};
+            work();
+            const std::chrono::duration<double,std::milli> elapsed{std::chrono::steady_clock::now() - start};
+            best = std::min(best,elapsed.count());
+        }
+        return best;
+    }
+
+    void report(const char* name,const double time,const std::size_t result)
+    {
+        std::cout << "  " << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed
+                  << std::setprecision(3) << time << " ms   (" << result << ")\n";
+    }
+
+    float squaredDistance(const glm::vec3& position,const glm::vec3& camera)
+    {
+        const glm::vec3 offset{position - camera};
+        return glm::dot(offset,offset);
+    }
+
+    // farthest first,up to the key's precision,and a permutation of the instances
+    bool isBackToFront(const std::span<const std::uint32_t> order,const std::vector<glm::vec3>& positions,const glm::vec3& camera)
+    {
+        if (order.size() != positions.size())
+            return false;
+        std::vector<std::uint8_t> seen(positions.size());
+        for (std::size_t i{0}; i < order.size(); ++i)
+        {
+            if (order[i] >= positions.size() || seen[order[i]]++)
+                return false;
+            if (i && squaredDistance(positions[order[i - 1]],camera) * tieTolerance < squaredDistance(positions[order[i]],camera))
+                return false;
+        }
+        return true;
+    }
+
+    void run(const std::size_t count)
+    {
+        const float worldSize{std::cbrt(static_cast<float>(count)) * 4.0f};
+        std::mt19937 random{42};
+        std::uniform_real_distribution<float> coordinate{-worldSize,worldSize};
+        std::vector<glm::vec3> positions(count);
+        for (glm::vec3& position : positions)
+            position = {coordinate(random),coordinate(random),coordinate(random)};
+        positions[count / 2] = positions[0]; // instances at the same distance have to stay in the list
+
+        const glm::vec3 camera{1.0f,2.0f,3.0f};
+        std::cout << count << " instances\n";
+
+        TransparencySorter sorter{count};
+        std::span<const std::uint32_t> order;
+        const double sortTime{milliseconds([&]{
+            sorter.begin(camera);
+            sorter.add(positions);
+            order = sorter.backToFront();
+        },50)};
+        report("TransparencySorter",sortTime,order.size());
+        std::cout << "  back to front: " << (isBackToFront(order,positions,camera) ? "yes" : "NO") << '\n';
+        if (count == targetInstances)
+            std::cout << "  under " << targetMilliseconds << " ms: " << (sortTime < targetMilliseconds ? "yes" : "NO") << '\n';
+
+        std::vector<std::pair<float,std::uint32_t>> distances(count);
+        const double standardTime{milliseconds([&]{
+            for (std::uint32_t i{0}; i < count; ++i)
+                distances[i] = {squaredDistance(positions[i],camera),i};
+            std::ranges::sort(distances,std::greater{});
+        },5)};
+        report("std::sort",standardTime,distances.size());
+        std::cout << '\n';
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::vector<std::size_t> counts{1'000,100'000,1'000'000};
+    if (argc > 1)
+    {
+        counts.clear();
+        for (int i{1}; i < argc; ++i)
+            counts.push_back(std::strtoull(argv[i],nullptr,10));
+    }
+
+    for (const std::size_t count : counts)
+    {
+        if (count)
+            run(count);
+    }
+    return 0;
+}
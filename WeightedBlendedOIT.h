@@ -0,0 +1,95 @@
+#ifndef MYOPENPROJECT_WEIGHTEDBLENDEDOIT_H
+#define MYOPENPROJECT_WEIGHTEDBLENDEDOIT_H
+
+#include <glad/glad.h>
+
+#include "Buffers/RenderTarget.h"
+#include "Shader.h"
+
+#include <array>
+
+// Weighted blended order-independent transparency (McGuire and Bavoil). Transparent surfaces are drawn
+// in any order between begin() and end() with oitshader.fs,which writes into two targets:
+//   accumulation (RGBA16F): sum of premultiplied color * weight and alpha * weight,the weight falling off with depth
+//   revealage (R16F):       sum of -log(1 - alpha),so the fraction of the background still showing is exp(-sum)
+// Both are plain additive blends,which keeps the pass on GL 3.3 (the usual multiplicative revealage would need
+// a different glBlendFunci per target). The targets share the depth renderbuffer of the multisampled scene,
+// depth tested and never written,so the opaque geometry still hides what's behind it and MSAA edges stay.
+// composite() resolves the samples and blends the average over the resolved scene,right before renderQuad.
+class WeightedBlendedOIT
+{
+public:
+    WeightedBlendedOIT(const unsigned int width,const unsigned int height,const int samples,const unsigned int sceneDepthRenderbuffer)
+        : targets{width,height,{{GL_RGBA16F,GL_RGBA,GL_HALF_FLOAT},{GL_R16F,GL_RED,GL_HALF_FLOAT}},samples}
+    {
+        targets.attachDepthRenderbuffer(sceneDepthRenderbuffer);
+        supported = samples > 0 && targets.isComplete(); // oitcomposite.fs reads multisampled textures
+
+        compositeShader.use();
+        compositeShader.setInt("accumulation",0);
+        compositeShader.setInt("revealage",1);
+        compositeShader.setInt("samples",samples);
+    }
+
+    [[nodiscard]] bool isSupported() const
+    {
+        return supported;
+    }
+
+    [[nodiscard]] unsigned int getTextureID(const std::size_t attachment) const // 0 accumulation,1 revealage
+    {
+        return targets.getTextureID(attachment);
+    }
+
+    // binds the targets and the blend state,the caller draws its transparent surfaces after this
+    void begin() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER,targets.getFrameBufferID());
+        constexpr std::array<float,4> zero{0.0f,0.0f,0.0f,0.0f};
+        glClearBufferfv(GL_COLOR,0,zero.data());
+        glClearBufferfv(GL_COLOR,1,zero.data());
+
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_FALSE);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE,GL_ONE);
+    }
+
+    void end() const
+    {
+        glDepthMask(GL_TRUE);
+        glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    // blends the transparent layers over framebuffer,which holds the resolved opaque scene;quadVAO is the full screen quad
+    void composite(const unsigned int framebuffer,const unsigned int quadVAO) const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER,framebuffer);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE,GL_SRC_ALPHA); // premultiplied color + background * revealage
+
+        compositeShader.use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(targets.getTextureTarget(),targets.getTextureID(0));
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(targets.getTextureTarget(),targets.getTextureID(1));
+
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLES,0,6);
+        glBindVertexArray(0);
+
+        glBindTexture(targets.getTextureTarget(),0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(targets.getTextureTarget(),0);
+        glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+private:
+    RenderTarget targets;
+    Shader compositeShader{"frameBufferShader.vs","oitcomposite.fs"};
+    bool supported{false};
+};
+
+#endif //MYOPENPROJECT_WEIGHTEDBLENDEDOIT_H
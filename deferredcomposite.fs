@@ -0,0 +1,22 @@
+#version 330 core
+
+// last pass of DeferredRenderer: the lit G-buffer pixels go into the scene framebuffer,with their depth,
+// so everything drawn forward after it is hidden by the deferred geometry as usual
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D lighting;
+uniform sampler2D gDepth;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth,texel,0).r;
+    if (depth == 1.0)
+        discard; // keeps the clear color and depth
+
+    FragColor = vec4(texelFetch(lighting,texel,0).rgb,1.0);
+    gl_FragDepth = depth;
+}
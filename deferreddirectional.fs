@@ -0,0 +1,118 @@
+#version 330 core
+
+// first lighting pass of DeferredRenderer,a full screen quad: the directional light of every G-buffer pixel.
+// The light volumes are added on top of it. Same terms as calculateDirLight in shader.fs,shadow included.
+
+struct Material {
+    float shininess;
+};
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform Material material;
+uniform DirLight dirLight;
+uniform vec3 viewPos;
+uniform bool blinnPhong;
+
+uniform sampler2D gDiffuse;
+uniform sampler2D gSpecular;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+// cascaded shadow map of the directional light (CascadedShadowMap)
+uniform bool shadows;
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 cascadeMatrices[4];
+uniform vec4 cascadeSplits;     // view depth where each cascade ends
+uniform vec4 cascadeTexelSizes; // world size of a shadow map texel in each cascade
+
+vec3 diffuseMap;
+vec3 specularMap;
+vec3 FragPos;
+float fragmentViewDepth;
+
+float near = 0.1;
+float far  = 100.0;
+
+vec3 calculateDirLight(DirLight light,vec3 normal,vec3 viewDir);
+float dirShadow(vec3 position,float viewDepth,vec3 normal,vec3 lightDirection);
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth,texel,0).r;
+    if (depth == 1.0)
+        discard; // nothing was drawn here
+
+    vec4 clip = vec4(TexCoords * 2.0 - 1.0,depth * 2.0 - 1.0,1.0);
+    vec4 world = inverseViewProjection * clip;
+    FragPos = world.xyz / world.w;
+    fragmentViewDepth = 2.0 * near * far / (far + near - clip.z * (far - near));
+
+    diffuseMap = texelFetch(gDiffuse,texel,0).rgb;
+    specularMap = texelFetch(gSpecular,texel,0).rgb;
+    vec3 normal = texelFetch(gNormal,texel,0).xyz;
+
+    FragColor = vec4(calculateDirLight(dirLight,normal,normalize(viewPos - FragPos)),1.0);
+}
+
+vec3 calculateDirLight(DirLight light,vec3 normal,vec3 viewDir)
+{
+    vec3 lightDirection = normalize(-light.direction);
+
+    vec3 rayDirection;
+    float specularStrength;
+
+    if(blinnPhong)
+    {
+    rayDirection = normalize(lightDirection + viewDir);
+    specularStrength = pow(max(dot(normal,rayDirection),0.0f),material.shininess);
+    }// blinn-phong
+    else
+    {
+    rayDirection = reflect(-lightDirection,normal);
+    specularStrength = pow(max(dot(viewDir,rayDirection),0.0f),material.shininess);
+    } // phong model
+
+    float diffuseStrength = max(dot(normal,lightDirection),0.0f);
+
+    vec3 ambient = light.ambient * diffuseMap;
+    vec3 diffuse = light.diffuse * diffuseMap * diffuseStrength;
+    vec3 specular = light.specular * specularMap * specularStrength;
+
+    return (ambient + (diffuse + specular) * dirShadow(FragPos,fragmentViewDepth,normal,lightDirection));
+}
+
+// 1.0 lit,0.0 in the shadow of the directional light: 3x3 hardware comparisons in the cascade the depth falls in
+float dirShadow(vec3 position,float viewDepth,vec3 normal,vec3 lightDirection)
+{
+    if(!shadows || viewDepth > cascadeSplits.w)
+        return 1.0;
+    int cascade = 0;
+    while(cascade < 3 && viewDepth > cascadeSplits[cascade])
+        ++cascade;
+
+    // normal offset against acne: a texel of the cascade away from the surface,two at grazing angles
+    float grazing = 1.0 - max(dot(normal,lightDirection),0.0);
+    vec3 offsetPosition = position + normal * cascadeTexelSizes[cascade] * (1.0 + grazing);
+    vec3 coords = (cascadeMatrices[cascade] * vec4(offsetPosition,1.0)).xyz * 0.5 + 0.5;
+    coords.z = min(coords.z,1.0);
+
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap,0).xy);
+    float lit = 0.0;
+    for(int x = -1; x <= 1; ++x)
+        for(int y = -1; y <= 1; ++y)
+            lit += texture(shadowMap,vec4(coords.xy + vec2(x,y) * texel,float(cascade),coords.z));
+    return lit / 9.0;
+}
@@ -0,0 +1,216 @@
+#version 330 core
+
+// lights the G-buffer pixels inside one light volume,added to the directional pass (glBlendFunc(GL_ONE,GL_ONE)).
+// Same terms as calculatePointLight and calculateSpotLight in shader.fs,shadows included,and the same range cut as its clustered loop,
+// so the deferred and the forward paths give the same picture.
+
+struct Material {
+    float shininess;
+};
+
+struct PointLight {
+    vec3 position;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    float linear;
+    float quadratic;
+    float constant;
+};
+
+struct SpotLight {
+    vec3 direction;
+    vec3 position;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    float linear;
+    float quadratic;
+    float constant;
+    float cutOff;
+    float outerCutOff;
+};
+
+out vec4 FragColor;
+
+flat in int lightIndex;
+
+uniform Material material;
+uniform SpotLight spotLight;
+uniform bool spotVolume;
+uniform vec3 viewPos;
+uniform bool blinnPhong;
+
+uniform samplerBuffer clusterLights; // four texels per light,see ClusteredLights
+uniform sampler2D gDiffuse;
+uniform sampler2D gSpecular;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize;
+
+#define NR_POINT_LIGHTS 8
+
+// omnidirectional shadows of the first NR_POINT_LIGHTS point lights (PointShadowAtlas),six layers a light
+uniform sampler2DArrayShadow pointShadowMap;
+uniform vec4 pointShadows[NR_POINT_LIGHTS]; // where the light's map was drawn from and its far plane;w is 0 without one
+uniform float pointShadowNear;
+
+vec3 diffuseMap;
+vec3 specularMap;
+
+PointLight fetchClusterLight(int index);
+vec3 calculatePointLight(PointLight light,vec3 normal,vec3 viewDir,vec3 FragPos,float shadow);
+float pointShadow(int index,vec3 position,vec3 normal);
+vec3 calculateSpotLight(SpotLight light,vec3 normal,vec3 viewDirection,vec3 FragPos);
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth,texel,0).r;
+    if (depth == 1.0)
+        discard; // nothing was drawn here
+
+    vec4 clip = vec4(gl_FragCoord.xy / screenSize * 2.0 - 1.0,depth * 2.0 - 1.0,1.0);
+    vec4 world = inverseViewProjection * clip;
+    vec3 FragPos = world.xyz / world.w;
+
+    vec4 positionRange = texelFetch(clusterLights,lightIndex * 4);
+    if (!spotVolume && distance(positionRange.xyz,FragPos) > positionRange.w)
+        discard; // inside the volume's screen footprint,but not in its range
+
+    diffuseMap = texelFetch(gDiffuse,texel,0).rgb;
+    specularMap = texelFetch(gSpecular,texel,0).rgb;
+    vec3 normal = texelFetch(gNormal,texel,0).xyz;
+    vec3 viewDirection = normalize(viewPos - FragPos);
+
+    vec3 light = spotVolume ? calculateSpotLight(spotLight,normal,viewDirection,FragPos)
+                            : calculatePointLight(fetchClusterLight(lightIndex),normal,viewDirection,FragPos,pointShadow(lightIndex,FragPos,normal));
+    FragColor = vec4(light,0.0);
+}
+
+PointLight fetchClusterLight(int index)
+{
+    vec4 positionRange = texelFetch(clusterLights,index * 4);
+    vec4 diffuseConstant = texelFetch(clusterLights,index * 4 + 1);
+    vec4 specularLinear = texelFetch(clusterLights,index * 4 + 2);
+    vec4 ambientQuadratic = texelFetch(clusterLights,index * 4 + 3);
+
+    PointLight light;
+    light.position = positionRange.xyz;
+    light.diffuse = diffuseConstant.rgb;
+    light.constant = diffuseConstant.a;
+    light.specular = specularLinear.rgb;
+    light.linear = specularLinear.a;
+    light.ambient = ambientQuadratic.rgb;
+    light.quadratic = ambientQuadratic.a;
+    return light;
+}
+
+vec3 calculatePointLight(PointLight light,vec3 normal,vec3 viewDir,vec3 FragPos,float shadow)
+{
+    vec3 lightDirection = normalize(light.position - FragPos);
+
+    vec3 rayDirection;
+    float specularStrength;
+
+    if(blinnPhong)
+    {
+        rayDirection = normalize(lightDirection + viewDir);
+        specularStrength = pow(max(dot(normal,rayDirection),0.0f),material.shininess);
+    }// blinn-phong
+    else
+    {
+        rayDirection = reflect(-lightDirection,normal);
+        specularStrength = pow(max(dot(viewDir,rayDirection),0.0f),material.shininess);
+    } // phong model
+
+    float distanceLength = length(light.position - FragPos);
+    float attenuation = 1.0f/(light.constant + (distanceLength * light.linear) + (distanceLength * distanceLength) * light.quadratic);
+
+    float diffuseStrength = max(dot(normal,lightDirection),0.0f);
+
+    vec3 ambient = light.ambient * diffuseMap * attenuation;
+    vec3 diffuse = light.diffuse * diffuseMap * diffuseStrength * attenuation;
+    vec3 specular = light.specular * specularMap * specularStrength * attenuation;
+
+    return (ambient + (diffuse + specular) * shadow);
+}
+
+// 1.0 lit,0.0 in the shadow of point light index: the face of its cube the fragment is in,picked and addressed
+// like a cube map,and one hardware 2x2 comparison against it
+float pointShadow(int index,vec3 position,vec3 normal)
+{
+    if(index >= NR_POINT_LIGHTS || pointShadows[index].w == 0.0)
+        return 1.0;
+    vec3 lightPosition = pointShadows[index].xyz;
+    float texels = float(textureSize(pointShadowMap,0).x);
+
+    // normal offset against acne: a texel and a half of the face at that distance
+    vec3 v = position + normal * (3.0 * distance(position,lightPosition) / texels) - lightPosition;
+    vec3 a = abs(v);
+    float ma;
+    int face;
+    vec2 sc;
+    if(a.x >= a.y && a.x >= a.z)
+    {
+        ma = a.x;
+        face = v.x > 0.0 ? 0 : 1;
+        sc = vec2(v.x > 0.0 ? -v.z : v.z,-v.y);
+    }
+    else if(a.y >= a.z)
+    {
+        ma = a.y;
+        face = v.y > 0.0 ? 2 : 3;
+        sc = vec2(v.x,v.y > 0.0 ? v.z : -v.z);
+    }
+    else
+    {
+        ma = a.z;
+        face = v.z > 0.0 ? 4 : 5;
+        sc = vec2(v.z > 0.0 ? v.x : -v.x,-v.y);
+    }
+
+    float farPlane = pointShadows[index].w;
+    float nearPlane = pointShadowNear;
+    float depth = (farPlane + nearPlane) / (farPlane - nearPlane) - 2.0 * farPlane * nearPlane / ((farPlane - nearPlane) * ma); // what the face's projection gives
+    vec2 uv = clamp(sc / ma * 0.5 + 0.5,0.5 / texels,1.0 - 0.5 / texels);
+    return texture(pointShadowMap,vec4(uv,float(index * 6 + face),min(depth * 0.5 + 0.5,1.0)));
+}
+
+vec3 calculateSpotLight(SpotLight light,vec3 normal,vec3 viewDirection,vec3 FragPos)
+{
+    vec3 lightDirection = normalize(light.position - FragPos);
+
+    float specularStrength;
+
+    if(blinnPhong)
+    {
+        vec3 rayDirection = normalize(lightDirection + viewDirection);
+        specularStrength = pow(max(dot(normal,rayDirection),0.0f),material.shininess);
+    }// blinn-phong
+    else
+    {
+        vec3 rayDirection = reflect(-lightDirection,normal);
+        specularStrength = pow(max(dot(viewDirection,rayDirection),0.0f),material.shininess);
+    } // phong model
+
+    float distanceLength = length(light.position - FragPos);
+    float attenuation = 1.0f/(light.constant + (distanceLength * light.linear) + (distanceLength * distanceLength) * light.quadratic);
+
+    float theta = dot(lightDirection, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon,0.0,1.0);
+
+    float diffuseStrength = max(dot(normal,lightDirection),0.0f);
+
+    vec3 ambient = light.ambient * diffuseMap * attenuation * intensity;
+    vec3 diffuse = light.diffuse * diffuseMap * diffuseStrength * attenuation * intensity;
+    vec3 specular = light.specular * specularMap * specularStrength * attenuation * intensity ;
+
+    return (ambient + diffuse + specular);
+}
@@ -0,0 +1,29 @@
+#version 330 core
+
+// light volumes of DeferredRenderer: an instanced sphere per point light,placed and sized from the
+// ClusteredLights buffer (position and range in the first texel of every light),or the cone of the spot light
+
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 viewProjection;
+uniform samplerBuffer clusterLights;
+uniform bool spotVolume;
+uniform mat4 volumeTransform; // the cone,when spotVolume is set
+
+flat out int lightIndex;
+
+void main()
+{
+    vec3 world;
+    if (spotVolume)
+    {
+        world = vec3(volumeTransform * vec4(aPos,1.0));
+    }
+    else
+    {
+        vec4 positionRange = texelFetch(clusterLights,gl_InstanceID * 4);
+        world = positionRange.xyz + aPos * positionRange.w;
+    }
+    lightIndex = gl_InstanceID;
+    gl_Position = viewProjection * vec4(world,1.0);
+}
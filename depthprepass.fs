@@ -0,0 +1,7 @@
+#version 330 core
+
+// depth pre-pass (DepthPrepass): the depth test is all there is,colour writes are masked off
+
+void main()
+{
+}
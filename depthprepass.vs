@@ -0,0 +1,30 @@
+#version 330 core
+
+// depth pre-pass (DepthPrepass): positions only,transformed exactly like shader.vs so the lit pass
+// finds the same depths (invariant),or,with coverage set,a full screen triangle on the far plane
+layout (location = 0) in vec3 aPos;
+layout(location = 8) in mat4 aInstanceTransform; // identity,the pre-pass draws aren't instanced
+
+layout (std140) uniform Perspective
+{
+    mat4 projection;
+    mat4 view;
+
+};
+
+invariant gl_Position;
+
+uniform mat4 transform;
+uniform bool coverage;
+
+void main()
+{
+if (coverage)
+{
+    vec2 corner = vec2(gl_VertexID == 1 ? 3.0 : -1.0,gl_VertexID == 2 ? 3.0 : -1.0);
+    gl_Position = vec4(corner,1.0,1.0);
+    return;
+}
+mat4 model = transform * aInstanceTransform;
+gl_Position = projection* view * model * vec4(aPos, 1.0) ;
+}
@@ -0,0 +1,6 @@
+#version 330 core
+
+// depth only,the cascade's framebuffer has no color attachment
+void main()
+{
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+// shadow casters (CascadedShadowMap): positions only,into the cascade of lightMatrix
+layout (location = 0) in vec3 aPos;
+layout (location = 8) in mat4 aInstanceTransform; // per instance (InstanceBuffer),identity for plain draws
+
+uniform mat4 lightMatrix;
+uniform mat4 transform;
+
+void main()
+{
+mat4 model = transform * aInstanceTransform;
+gl_Position = lightMatrix * model * vec4(aPos, 1.0);
+}
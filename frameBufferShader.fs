@@ -1,51 +0,0 @@
-#version 330 core
-out vec4 FragColor;
-
-in vec2 TexCoords;
-
-uniform sampler2D screenTexture;
-uniform bool gammaCorrected;
-
-
-const float gamma = 2.2f;
-const float offset= 1.0/30000.0;
-void main()
-{
-    vec2 offsets[9] = vec2[](
-            vec2(-offset,  offset), // top-left
-            vec2( 0.0f,    offset), // top-center
-            vec2( offset,  offset), // top-right
-            vec2(-offset,  0.0f),   // center-left
-            vec2( 0.0f,    0.0f),   // center-center
-            vec2( offset,  0.0f),   // center-right
-            vec2(-offset, -offset), // bottom-left
-            vec2( 0.0f,   -offset), // bottom-center
-            vec2( offset, -offset)  // bottom-right
-        );
-
-        float kernel[9] = float[]( //gaussian blur
-            -1, -1, -1,
-            -1,  9, -1,
-            -1, -1, -1
-        );
-
-        vec3 sampleTex[9];
-        for(int i = 0; i < 9; i++)
-        {
-            sampleTex[i] = vec3(texture(screenTexture, TexCoords.st + offsets[i]));
-        }
-        vec3 col = vec3(0.0);
-        for(int i = 0; i < 9; i++)
-            col += sampleTex[i] * kernel[i];
-
-
-        FragColor = vec4(col, 1.0);
-        if(gammaCorrected)
-            FragColor.rgb = pow(FragColor.rgb,vec3(1.0/gamma)); // gamma correction
-        //FragColor = texture(screenTexture,TexCoords);
-
-//         //for depth testing purposes
-//         float depthValue = texture(screenTexture, TexCoords).r;
-//         // FragColor = vec4(vec3(LinearizeDepth(depthValue) / far_plane), 1.0); // perspective
-//         FragColor = vec4(vec3(depthValue), 1.0); // orthographic
-}
@@ -0,0 +1,134 @@
+#version 330 core
+
+// AntiAliasing: FXAA 3.11 quality (Lottes),on the single sampled scene. The luma around the pixel decides whether
+// it is on an edge and whether that edge runs horizontally or vertically,the search along it finds where it ends,
+// and the pixel is sampled that far across it as the line from the nearer end would cover it
+
+out vec4 FragColor;
+
+uniform sampler2D scene;
+uniform vec2 texelSize;  // of the scene texture,the rendered area is its bottom left renderSize
+uniform vec2 renderSize;
+
+const float edgeThreshold = 0.125;    // of the brightest luma around,the contrast below which nothing is done
+const float edgeThresholdMin = 0.0312;
+const float subpixelQuality = 0.75;
+const int searchSteps = 10;
+const float searchStep[10] = float[](1.0,1.5,2.0,2.0,2.0,2.0,2.0,2.0,4.0,8.0);
+
+// the HDR scene clamped and square rooted,close enough to the perceived brightness for finding edges
+float luma(vec3 color)
+{
+    return sqrt(dot(clamp(color,0.0,1.0),vec3(0.299,0.587,0.114)));
+}
+
+float lumaAt(vec2 uv)
+{
+    return luma(texture(scene,clamp(uv,0.5 * texelSize,(renderSize - 0.5) * texelSize)).rgb);
+}
+
+float lumaAt(ivec2 texel)
+{
+    return luma(texelFetch(scene,clamp(texel,ivec2(0),ivec2(renderSize) - 1),0).rgb);
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec2 uv = gl_FragCoord.xy * texelSize;
+    vec3 color = texelFetch(scene,texel,0).rgb;
+
+    float lumaM = luma(color);
+    float lumaS = lumaAt(texel + ivec2( 0,-1));
+    float lumaN = lumaAt(texel + ivec2( 0, 1));
+    float lumaW = lumaAt(texel + ivec2(-1, 0));
+    float lumaE = lumaAt(texel + ivec2( 1, 0));
+    float lumaMax = max(lumaM,max(max(lumaS,lumaN),max(lumaW,lumaE)));
+    float lumaMin = min(lumaM,min(min(lumaS,lumaN),min(lumaW,lumaE)));
+    float range = lumaMax - lumaMin;
+    if (range < max(edgeThresholdMin,lumaMax * edgeThreshold))
+    {
+        FragColor = vec4(color,1.0);
+        return;
+    }
+
+    float lumaSW = lumaAt(texel + ivec2(-1,-1));
+    float lumaNE = lumaAt(texel + ivec2( 1, 1));
+    float lumaNW = lumaAt(texel + ivec2(-1, 1));
+    float lumaSE = lumaAt(texel + ivec2( 1,-1));
+
+    // how much the luma changes across each direction,the middle row or column counting twice
+    float edgeHorizontal = abs(lumaNW - 2.0 * lumaN + lumaNE) + 2.0 * abs(lumaW - 2.0 * lumaM + lumaE) + abs(lumaSW - 2.0 * lumaS + lumaSE);
+    float edgeVertical = abs(lumaNW - 2.0 * lumaW + lumaSW) + 2.0 * abs(lumaN - 2.0 * lumaM + lumaS) + abs(lumaNE - 2.0 * lumaE + lumaSE);
+    bool horizontal = edgeHorizontal >= edgeVertical;
+
+    // the side of the pixel the edge is on: towards the neighbor with the bigger gradient
+    float luma1 = horizontal ? lumaS : lumaW;
+    float luma2 = horizontal ? lumaN : lumaE;
+    float gradient1 = luma1 - lumaM;
+    float gradient2 = luma2 - lumaM;
+    bool steepest1 = abs(gradient1) >= abs(gradient2);
+    float gradientScaled = 0.25 * max(abs(gradient1),abs(gradient2));
+    float stepLength = horizontal ? texelSize.y : texelSize.x;
+    float lumaLocalAverage;
+    if (steepest1)
+    {
+        stepLength = -stepLength;
+        lumaLocalAverage = 0.5 * (luma1 + lumaM);
+    }
+    else
+        lumaLocalAverage = 0.5 * (luma2 + lumaM);
+
+    // walks both ways along the edge,half a texel off the pixel,until the luma leaves the edge's average
+    vec2 edgeUV = uv;
+    if (horizontal)
+        edgeUV.y += 0.5 * stepLength;
+    else
+        edgeUV.x += 0.5 * stepLength;
+    vec2 offset = horizontal ? vec2(texelSize.x,0.0) : vec2(0.0,texelSize.y);
+    vec2 uv1 = edgeUV - offset;
+    vec2 uv2 = edgeUV + offset;
+    float lumaEnd1 = lumaAt(uv1) - lumaLocalAverage;
+    float lumaEnd2 = lumaAt(uv2) - lumaLocalAverage;
+    bool reached1 = abs(lumaEnd1) >= gradientScaled;
+    bool reached2 = abs(lumaEnd2) >= gradientScaled;
+    for (int i = 1; i < searchSteps && !(reached1 && reached2); i++)
+    {
+        if (!reached1)
+        {
+            uv1 -= offset * searchStep[i];
+            lumaEnd1 = lumaAt(uv1) - lumaLocalAverage;
+            reached1 = abs(lumaEnd1) >= gradientScaled;
+        }
+        if (!reached2)
+        {
+            uv2 += offset * searchStep[i];
+            lumaEnd2 = lumaAt(uv2) - lumaLocalAverage;
+            reached2 = abs(lumaEnd2) >= gradientScaled;
+        }
+    }
+
+    float distance1 = horizontal ? uv.x - uv1.x : uv.y - uv1.y;
+    float distance2 = horizontal ? uv2.x - uv.x : uv2.y - uv.y;
+    bool nearer1 = distance1 < distance2;
+    float distanceNearer = min(distance1,distance2);
+    float edgeLength = distance1 + distance2;
+
+    // only when the luma at the nearer end goes the other way than at the pixel does the line cross it there
+    bool lumaCenterSmaller = lumaM < lumaLocalAverage;
+    bool correctVariation = ((nearer1 ? lumaEnd1 : lumaEnd2) < 0.0) != lumaCenterSmaller;
+    float pixelOffset = correctVariation ? 0.5 - distanceNearer / edgeLength : 0.0;
+
+    // and small features the search can't see,by how much the pixel differs from the average around it
+    float lumaAverage = (2.0 * (lumaN + lumaS + lumaE + lumaW) + lumaNW + lumaNE + lumaSW + lumaSE) / 12.0;
+    float subpixel = clamp(abs(lumaAverage - lumaM) / range,0.0,1.0);
+    subpixel = (-2.0 * subpixel + 3.0) * subpixel * subpixel;
+    pixelOffset = max(pixelOffset,subpixel * subpixel * subpixelQuality);
+
+    vec2 finalUV = uv;
+    if (horizontal)
+        finalUV.y += pixelOffset * stepLength;
+    else
+        finalUV.x += pixelOffset * stepLength;
+    FragColor = vec4(texture(scene,clamp(finalUV,0.5 * texelSize,(renderSize - 0.5) * texelSize)).rgb,1.0);
+}
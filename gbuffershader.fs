@@ -0,0 +1,31 @@
+#version 330 core
+
+// geometry pass of DeferredRenderer: the surface terms shader.fs lights with,written out instead of lit
+//   0 diffuse (RGBA8),1 specular (RGBA8),2 world space normal (RGBA16F);the depth goes to the depth texture
+
+struct Material {
+    sampler2D texture_diffuse1;
+    sampler2D texture_specular1;
+    sampler2DArray diffuseLayers;
+    sampler2DArray specularLayers;
+};
+
+layout (location = 0) out vec4 gDiffuse;
+layout (location = 1) out vec4 gSpecular;
+layout (location = 2) out vec4 gNormal;
+
+in vec2 TexCoord;
+in vec3 Normal;
+in vec3 FragPos;
+flat in ivec4 Layers; // layer of the diffuse,specular,normal and height map in its array;-1 when the map is a plain sampler2D
+
+uniform Material material;
+
+void main()
+{
+    gDiffuse = Layers.x < 0 ? texture(material.texture_diffuse1,TexCoord)
+                            : texture(material.diffuseLayers,vec3(TexCoord,Layers.x));
+    gSpecular = Layers.y < 0 ? texture(material.texture_specular1,TexCoord)
+                             : texture(material.specularLayers,vec3(TexCoord,Layers.y));
+    gNormal = vec4(normalize(Normal),0.0);
+}
@@ -14,6 +14,7 @@ uniform vec3 cameraPos;
 
 in vec3 Normal;
 in vec3 Position;
+in vec4 Color;
 
 float airToGlass = 1.00f / 1.52f;
 float airToDiamond = 1.00f / 2.42f;
@@ -23,7 +24,7 @@ float airToWater = 1.00f / 1.33f;
 void main()
 {
 //FragColor = vec4(lightColor * objectColor,1.0);
-FragColor = vec4(1.0f,1.0f,1.0f,1.0f);
+FragColor = Color;
 //FragColor = vec4(texture(lightTexture,TexCoord));
 
 // vec3 ray = normalize(Position - cameraPos);
@@ -2,6 +2,8 @@
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
+layout (location = 8) in mat4 aInstanceTransform; // per instance (InstanceBuffer),identity for plain draws
+layout (location = 12) in vec4 aInstanceColor;
 
 layout (std140) uniform Perspective
 {
@@ -10,17 +12,22 @@ layout (std140) uniform Perspective
 
 };
 
+invariant gl_Position; // the velocity of the light cubes (velocity.vs) has to land on the same depths
+
 uniform mat4 transform;
 
 
 out vec3 Normal;
 out vec3 Position;
+out vec4 Color;
 
 
 void main()
 {
-Normal = mat3(transpose(inverse(transform))) * aNormal;
-Position = vec3(transform * vec4(aPos+gl_InstanceID,1.0));
+mat4 model = transform * aInstanceTransform;
+Normal = mat3(transpose(inverse(model))) * aNormal;
+Position = vec3(model * vec4(aPos,1.0));
+Color = aInstanceColor;
 
 gl_Position = projection * view * vec4(Position, 1.0);
 
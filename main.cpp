@@ -15,33 +15,128 @@
 #include "VertexInformation.h"
 #include "Buffers/ArrayBuffer.h"
 #include "Input.h"
-
+#include "RenderQueue.h"
+#include "GLExtensions.h"
+#include "StaticBatch.h"
+#include "FrustumCuller.h"
+#include "BVH.h"
+#include "OcclusionCuller.h"
+#include "InstanceBuffer.h"
+#include "TransparencySorter.h"
+#include "WeightedBlendedOIT.h"
+#include "ClusteredLights.h"
+#include "DeferredRenderer.h"
+#include "DepthPrepass.h"
+#include "PositionStream.h"
+#include "CascadedShadowMap.h"
+#include "PointShadowAtlas.h"
+#include "PostProcess.h"
+#include "FrameGraph.h"
+#include "DynamicResolution.h"
+#include "AntiAliasing.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "GLCapture.h"
+#include "Benchmark.h"
+
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <span>
 #include <cmath>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <array>
+#include <cstdlib>
+
+static constexpr int cubesPerLight{100};
+static constexpr float flashlightCutOff{10.5f};      // degrees
+static constexpr float flashlightOuterCutOff{18.0f};
+static const glm::vec3 dirLightDirection{-1.0f,-1.0f,-1.0f}; // where the directional light travels,for the lighting and the shadows
+static constexpr std::array<std::string_view,4> postEffectNames{"sharpen","blur","toneMap","grade"}; // switched by Globals::postEffects
 
 static void framebuffer_size_callback(GLFWwindow* window,int width, int height);
 static void mouse_callback(GLFWwindow* window,double xpos, double ypos);
 
 void printFPS(double& zeroFrame,int& nFrames);
 
-void renderBackPack(const Shader& shader,const Camera& camera,const Model& backpack,std::vector<glm::vec3>& movingLight);
-void renderLightCubes(const Shader& lightShader,const Camera& camera,const ArrayBuffer& lightBuffer,const std::vector<glm::vec3>& movingLight);
-void renderPlane(const Shader& lightShader,const ArrayBuffer& planeBuffer,const uint floorTexture);
-void renderSkybox(const Shader& skyboxShader,const ArrayBuffer& cubeMapBuffer,glm::mat4& view,const uint cubemapTexture);
-void renderWindows(const Shader& stencilShader,const Camera& camera,const ArrayBuffer& grassBuffer,const uint grassTexture);
-void renderQuad(const Shader& frameBufferShader,const ArrayBuffer& quadBuffer,const uint textureFramebuffer);
+float viewDepth(const Camera& camera,const glm::vec3& position);
+
+glm::mat4 backPackTransform();
+AABB backPackBounds(const Model& backpack);
+void animateLights(std::vector<glm::vec3>& movingLight);
+void gatherLights(std::vector<ClusteredLights::PointLight>& sceneLights,const std::vector<glm::vec3>& movingLight);
+void setBackPackLighting(const Shader& shader,const Camera& camera,const std::vector<glm::vec3>& movingLight,const ClusteredLights& clusteredLights,const CascadedShadowMap& shadowMap,const PointShadowAtlas& pointShadows);
+glm::mat4 lightCubeTransform(const glm::vec3& light);
+AABB lightCubeBounds(const glm::vec3& light);
+glm::mat4 staticCubeTransform();
+std::vector<AABB> sceneBounds(const std::vector<glm::vec3>& movingLight);
+void refitScene(BVH& sceneBVH,const std::vector<glm::vec3>& movingLight);
+std::vector<std::size_t> selectOccluders(const Model& model,std::size_t triangleBudget);
+void renderOccluders(OcclusionCuller& occlusionCuller,const Model& backpack,std::span<const std::size_t> occluders,const glm::mat4& viewProjection);
+void cullBackPack(const Model& backpack,const glm::mat4& viewProjection,const OcclusionCuller* occlusion,std::vector<std::uint32_t>& visibleMeshes);
+void renderBackPack(const Shader& shader,const Camera& camera,const Model& backpack,const std::vector<glm::vec3>& movingLight,const ClusteredLights& clusteredLights,const CascadedShadowMap& shadowMap,const PointShadowAtlas& pointShadows,std::span<const std::uint32_t> visibleMeshes,bool depthPrepassed,RenderQueue& renderQueue);
+void renderBackPackIndirect(const Shader& indirectShader,const Camera& camera,StaticBatch& backpackBatch,const std::vector<glm::vec3>& movingLight,const ClusteredLights& clusteredLights,const CascadedShadowMap& shadowMap,const PointShadowAtlas& pointShadows,std::span<const std::uint32_t> visibleMeshes,bool depthPrepassed);
+template<typename Volume>
+void renderStaticShadowCasters(const Shader& depthShader,const PositionStream& backpackPositions,const Model& backpack,const ArrayBuffer& lightBuffer,const Volume& reach);
+void renderDynamicShadowCasters(const Shader& depthShader,const ArrayBuffer& lightBuffer,const std::vector<glm::vec3>& movingLight,InstanceBuffer& instanceBuffer,std::optional<InstanceBuffer::Range>& cubeInstances);
+std::optional<DeferredRenderer::SpotVolume> flashlightVolume(const Camera& camera);
+InstanceBuffer::Range renderLightCubes(const Shader& lightShader,const Camera& camera,const ArrayBuffer& lightBuffer,const std::vector<glm::vec3>& movingLight,const std::vector<glm::vec3>& previousLight,std::span<const std::uint8_t> visible,InstanceBuffer& instanceBuffer,RenderQueue& renderQueue);
+void renderLightCubeVelocity(const Shader& velocityShader,const ArrayBuffer& lightBuffer,const InstanceBuffer::Range& cubeInstances);
+void renderPlane(const Shader& lightShader,const Camera& camera,const ArrayBuffer& planeBuffer,const uint floorTexture,RenderQueue& renderQueue);
+void renderSkybox(const Shader& skyboxShader,const ArrayBuffer& cubeMapBuffer,glm::mat4& view,const uint cubemapTexture,RenderQueue& renderQueue);
+void renderWindows(const Shader& stencilShader,const Camera& camera,const ArrayBuffer& grassBuffer,const uint grassTexture,std::span<const std::uint8_t> visible,TransparencySorter& windowSorter);
+void renderWindowsOIT(const Shader& oitShader,const ArrayBuffer& grassBuffer,const uint grassTexture,std::span<const std::uint8_t> visible,InstanceBuffer& instanceBuffer,const WeightedBlendedOIT& oit);
+void setupPostProcess(PostProcess& postProcess);
+void renderQuad(PostProcess& postProcess,FrameGraph& frameGraph,const ArrayBuffer& quadBuffer,FrameGraph::Handle scene,unsigned int sceneWidth,unsigned int sceneHeight,FrameGraph::Handle screen);
+GLenum attachmentFormatOf(uint framebuffer,GLenum attachment);
+
+int main(int argc,char** argv) {
+    unsigned int captureFrames{0}; // --capture <frames> [path]: the GL calls of loading and the first frames,for GL_REPLAY
+    std::string capturePath{"capture.gltrace"};
+    bool benchmark{false}; // --bench [frames] [--camera-path file] [--bench-out file] [--prepass on|off]: headless,scripted,timed,see Benchmark
+    Benchmark::Settings benchSettings;
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        if (arg == "--capture" && i + 1 < argc)
+        {
+            captureFrames = static_cast<unsigned int>(std::max(1,std::atoi(argv[++i])));
+            if (i + 1 < argc && std::string_view{argv[i + 1]}.substr(0,2) != "--")
+                capturePath = argv[++i];
+        }
+        else if (arg == "--bench")
+        {
+            benchmark = true;
+            if (i + 1 < argc && std::string_view{argv[i + 1]}.substr(0,2) != "--")
+                benchSettings.frames = static_cast<unsigned int>(std::max(1,std::atoi(argv[++i])));
+        }
+        else if (arg == "--camera-path" && i + 1 < argc)
+            benchSettings.pathFile = argv[++i];
+        else if (arg == "--bench-out" && i + 1 < argc)
+            benchSettings.output = argv[++i];
+        else if (arg == "--prepass" && i + 1 < argc)
+            benchSettings.depthPrepass = std::string_view{argv[++i]} == "on";
+    }
 
-int main() {
     glfwInit(); //the opengl version being used and initialising the state
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4); // 4.5 for multi-draw indirect,3.3 is still enough for everything else
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_SAMPLES, 4);
-
+    if (benchmark)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // never shown,rendering goes on into its framebuffer (llvmpipe: LIBGL_ALWAYS_SOFTWARE=1,xvfb-run)
 
     GLFWwindow* window = glfwCreateWindow(Globals::SCREEN_WIDTH, Globals::SCREEN_HEIGHT, "Daemon Engine", nullptr, nullptr); // creating the pointer window with the necessary attributes
+    if (!window)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(Globals::SCREEN_WIDTH, Globals::SCREEN_HEIGHT, "Daemon Engine", nullptr, nullptr);
+    }
     if (!window) // if the pointer is null,end the process;
     {
         std::cout << "Failed to create GLFW window" << std::endl;
@@ -49,6 +144,8 @@ int main() {
         return -1;
     }
     glfwMakeContextCurrent(window); // makes the window the context(the state machine)
+    if (benchmark)
+        glfwSwapInterval(0); // as fast as it goes
 
     if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) // initialising glad
     {
@@ -56,11 +153,15 @@ int main() {
         return -1;
 
     }
+    GLExtensions::load(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+    if (captureFrames)
+        GLCapture::begin(capturePath,captureFrames,Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT);
 
 
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); // the function uses the window to resize it as appropriate
 
     stbi_set_flip_vertically_on_load(true);
+    PROFILE_THREAD("main");
 
     { // made this scope so as to properly delete the buffers
         Camera myCamera(glm::vec3(0.0f,0.0f,3.0f));
@@ -75,27 +176,35 @@ int main() {
         Shader myShader("shader.vs","shader.gs","shader.fs");
         Shader lightShader("lightingshader.vs","lightingshader.fs");
         Shader stencilShader("shader.vs","stencilshader.fs");
-        Shader frameBufferShader("frameBufferShader.vs","frameBufferShader.fs");
+        PostProcess postProcess; // what renderQuad runs on the scene,compiled into generated shaders
+        setupPostProcess(postProcess);
         Shader skyboxShader("skyboxshader.vs","skyboxshader.fs");
         Shader normalShader("NORMALSONLYSHADER.vs","NORMALSONLYSHADER.gs","NORMALSONLYSHADER.fs");
-        Shader depthShader("depthshader.vs","depthshader.fs");
+        Shader oitShader("shader.vs","oitshader.fs");
+        Shader gBufferShader("shader.vs","shader.gs","gbuffershader.fs");
+
+        std::optional<Shader> indirectShader; // needs a 4.3+ context
+        std::optional<Shader> indirectGBufferShader;
+        if (GLExtensions::multiDrawIndirect)
+        {
+            indirectShader.emplace("shader_indirect.vs","shader.gs","shader.fs");
+            indirectGBufferShader.emplace("shader_indirect.vs","shader.gs","gbuffershader.fs");
+        }
+        StaticBatch backpackBatch{myModel.meshes};
 
         UBO ubo(2*sizeof(glm::mat4),0,GL_STATIC_DRAW);
         //uint uniformBuffer = ubo.getBufferID();
 
-        Framebuffer myFrameBuffer{Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT};
-        uint framebuffer = myFrameBuffer.getFrameBufferID();
-        uint textureFramebuffer = myFrameBuffer.getTextureBufferID();
-        //uint renderObject = myFrameBuffer.getRenderBufferID();
-
         Framebuffer msBuffer{Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT,Framebuffer::Type::MULTISAMPLE};
         uint sampleFrameBuffer = msBuffer.getFrameBufferID();
+        const GLenum sceneColorFormat{attachmentFormatOf(sampleFrameBuffer,GL_COLOR_ATTACHMENT0)}; // of the resolved scene,a resolving blit needs the same on both sides
+        const std::size_t msaaBytes{ // the multisampled scene,its depth and the resolved copy,to compare the other anti-aliasing modes with
+            FrameGraph::bytesOf({Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT,sceneColorFormat,Globals::SAMPLE_NUMBER}) +
+            FrameGraph::bytesOf({Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT,attachmentFormatOf(sampleFrameBuffer,GL_DEPTH_ATTACHMENT),Globals::SAMPLE_NUMBER}) +
+            FrameGraph::bytesOf({Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT,sceneColorFormat})};
         //uint sampleTexture = msBuffer.getTextureBufferID();
         //uint sampleRenderBuffer = msBuffer.getRenderBufferID();
 
-        Framebuffer depthBuffer(Globals::SHADOW_WIDTH,Globals::SHADOW_HEIGHT,Framebuffer::Type::DEPTH);
-        uint depthBufferID = depthBuffer.getFrameBufferID();
-
         ArrayBuffer lightBuffer(sizeof(TemporaryVertices::cubeVertices),TemporaryVertices::cubeVertices);
         lightBuffer.setupAttribute(0,3,GL_FLOAT,6*sizeof(float),0);
         lightBuffer.setupAttribute(1,3,GL_FLOAT,6*sizeof(float),3*sizeof(float));
@@ -115,13 +224,58 @@ int main() {
         ArrayBuffer cubeMapBuffer(sizeof(TemporaryVertices::skyboxVertices),TemporaryVertices::skyboxVertices);
         cubeMapBuffer.setupAttribute(0,3,GL_FLOAT,3*sizeof(float),0);
 
+        RenderQueue renderQueue{0.1f,100.0f};
+        InstanceBuffer instanceBuffer{4096}; // per-instance transforms,colors and materials,three frames in flight
+        TransparencySorter windowSorter{TemporaryVertices::vegetation.size()};
+        ClusteredLights clusteredLights{Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT,0.1f,100.0f};
+        std::vector<ClusteredLights::PointLight> sceneLights;
+        WeightedBlendedOIT oit{Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT,Globals::SAMPLE_NUMBER,msBuffer.getRenderBufferID()};
+        DeferredRenderer deferredRenderer{Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT,ClusteredLights::lightsUnit};
+        PositionStream backpackPositions{myModel.meshes}; // for the depth-only passes
+        DepthPrepass depthPrepass{backpackPositions};
+        CascadedShadowMap shadowMap{Globals::SHADOW_WIDTH};
+        PointShadowAtlas pointShadows{Globals::POINT_SHADOW_SIZE};
+        FrameGraph frameGraph; // the passes of a frame,declared every frame,and the transient targets between them
+        DynamicResolution dynamicResolution{Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT,
+            {Globals::TARGET_FRAME_MILLISECONDS,Globals::MIN_RENDER_SCALE,Globals::MAX_RENDER_SCALE}};
+        AntiAliasing antiAliasing{Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT,Globals::TAA_UPSCALE_SCALE,msaaBytes};
+        GpuProfiler gpuProfiler; // every frame graph pass and the draws inside the opaque one,printed with M
+        std::optional<Benchmark> bench;
+        if (benchmark)
+        {
+            bench.emplace(benchSettings);
+            DynamicResolution::enabled = false; // the same pixels every run
+            DepthPrepass::mode = benchSettings.depthPrepass ? DepthPrepass::Mode::on : DepthPrepass::Mode::off; // the same passes every frame
+        }
+        const AABB backpackBounds{backPackBounds(myModel)}; // what receives the shadows
+        std::vector<AABB> dynamicCasters;
+        std::vector<std::uint32_t> backpackVisible;
+
+        BVH sceneBVH; // light cubes (refit every frame),the static cube and the windows,in that order
+        sceneBVH.build(sceneBounds(std::vector<glm::vec3>(8)));
+        std::vector<std::uint8_t> sceneVisible(sceneBVH.size());
+        std::vector<glm::vec3> previousLight; // where the lights were last frame,for the motion vectors of the light cubes
+
+        ThreadPool workers;
+        OcclusionCuller occlusionCuller{&workers};
+        const std::vector<std::size_t> occluders{selectOccluders(myModel,16384)}; // the biggest meshes of the backpack hide the rest of it
+        std::cout << "OCCLUSION RASTERIZER: " << occlusionCuller.instructionSet() << '\n';
+
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
         stencilShader.setInt("grass",0);
         lightShader.setInt("lightTexture",0);
-        frameBufferShader.setInt("screenTexture",0);
         skyboxShader.setInt("skybox",0);
+        oitShader.use();
+        oitShader.setInt("grass",0);
+        Material::setSamplers(myShader);
+        Material::setSamplers(gBufferShader);
+        if (indirectShader)
+        {
+            Material::setSamplers(*indirectShader);
+            Material::setSamplers(*indirectGBufferShader);
+        }
 
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINES);
         glEnable(GL_MULTISAMPLE);
@@ -134,10 +288,20 @@ int main() {
         ubo.uniformBlockBinding(myShader.getProgramID(),"Perspective");
         ubo.uniformBlockBinding(lightShader.getProgramID(),"Perspective");
         ubo.uniformBlockBinding(skyboxShader.getProgramID(),"Perspective");
+        ubo.uniformBlockBinding(oitShader.getProgramID(),"Perspective");
+        ubo.uniformBlockBinding(gBufferShader.getProgramID(),"Perspective");
+        if (indirectShader)
+        {
+            ubo.uniformBlockBinding(indirectShader->getProgramID(),"Perspective");
+            ubo.uniformBlockBinding(indirectGBufferShader->getProgramID(),"Perspective");
+        }
 
-        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-        glfwSetWindowUserPointer(window, &myCamera);
-        glfwSetCursorPosCallback(window, mouse_callback);
+        if (!bench)
+        {
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+            glfwSetWindowUserPointer(window, &myCamera);
+            glfwSetCursorPosCallback(window, mouse_callback);
+        }
 
         auto zeroFrame = glfwGetTime();
         int nFrames{0};
@@ -145,105 +309,286 @@ int main() {
         float deltaTime{0.0f};
         float lastFrame{0.0f};
 
-        while(!glfwWindowShouldClose(window)) // the while loop checks continuously whether the necessary keys have been pressed to close the window
+        while(!glfwWindowShouldClose(window) && !(bench && bench->isDone())) // the while loop checks continuously whether the necessary keys have been pressed to close the window
         {
+            PROFILE_SCOPE("frame");
             //glEnable(GL_DEPTH_TEST); // for one,for testing
             auto currentFrame = static_cast<float>(glfwGetTime());
             deltaTime = currentFrame - lastFrame;
             lastFrame = currentFrame;
             nFrames++;
+            Globals::sceneTime = bench ? bench->time() : glfwGetTime();
+            if (bench)
+                bench->place(myCamera);
+
+            dynamicResolution.setMaxScale(std::min(antiAliasing.renderScale(),Globals::MAX_RENDER_SCALE)); // temporal upscaling renders at less
+            const unsigned int renderWidth{dynamicResolution.width()}; // of the scene this frame,the window's or less when the GPU falls behind
+            const unsigned int renderHeight{dynamicResolution.height()};
+            const bool singleSampled{antiAliasing.isSingleSampled()}; // FXAA,SMAA or TAA instead of MSAA,the scene goes into its target
 
             glm::mat4 projection = glm::perspective(glm::radians(Globals::FOV),
                 static_cast<float>(Globals::SCREEN_WIDTH) / static_cast<float>(Globals::SCREEN_HEIGHT),0.1f,100.0f); // determines the perspective
             glm::mat4 view = myCamera.GetViewMatrix(); // view matrix
+            const glm::mat4 jitteredProjection{antiAliasing.beginFrame(projection,view,renderWidth,renderHeight)}; // what the scene is drawn with,jittered for TAA
 
-            ubo.updateUniform(0,sizeof(glm::mat4),projection);
-            ubo.updateUniform(sizeof(glm::mat4),sizeof(glm::mat4),view);
+            {
+                PROFILE_SCOPE("uniformUpload");
+                ubo.updateUniform(0,sizeof(glm::mat4),jitteredProjection);
+                ubo.updateUniform(sizeof(glm::mat4),sizeof(glm::mat4),view);
+            }
+            const glm::mat4 viewProjection{projection * view}; // unjittered,for culling
+            const Frustum frustum{myCamera.GetFrustum(projection)};
 
             std::vector<glm::vec3> movingLight(8);
-
-            printFPS(zeroFrame,nFrames);
-
-            Input::generalInput(window);
-            Input::movementInput(window,myCamera,deltaTime);
+            animateLights(movingLight);
+            if (previousLight.size() != movingLight.size())
+                previousLight = movingLight;
+            gatherLights(sceneLights,movingLight);
+            clusteredLights.setViewport(renderWidth,renderHeight);
+            clusteredLights.update(view,projection,sceneLights);
+
+            if (!bench)
+                printFPS(zeroFrame,nFrames);
+            FrustumCuller::resetFrameCounters();
+            instanceBuffer.beginFrame();
+
+            if (!bench)
+            {
+                Input::generalInput(window);
+                Input::movementInput(window,myCamera,deltaTime);
+            }
 
             glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-            // glClear(GL_DEPTH_BUFFER_BIT);
-            // depthShader.use();
-            //
-            // float near_plane = 1.0f;
-            // float far_plane = 7.5f;
-            // glm::mat4 lightProjection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
-            // for (glm::vec3& i :  movingLight)
-            // {
-            //     glm::mat4 lightView = glm::lookAt(i,glm::vec3(0.0f,0.0f,0.0f),glm::vec3(0.0f,1.0f,0.0f));
-            //     glm::mat4 lightMatrix = lightProjection * lightView;
-            //     depthShader.setMat4("lightMatrix",lightMatrix);
-            // }
-            //
-            // glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f,5.0f,0.0f),glm::vec3(0.0f,0.0f,0.0f),glm::vec3(0.0f,1.0f,0.0f));
-            // glm::mat4 lightMatrix = lightProjection * lightView;
-            // depthShader.setMat4("lightMatrix",lightMatrix);
-            //
-            //
-            //
-            // glViewport(0, 0, Globals::SHADOW_WIDTH, Globals::SHADOW_HEIGHT); // for shadow mapping
-            // glBindFramebuffer(GL_FRAMEBUFFER,depthBufferID);
-            // glClear(GL_DEPTH_BUFFER_BIT);
-            // glActiveTexture(GL_TEXTURE0);
-            // glBindTexture(GL_TEXTURE_2D,depthBuffer.getTextureBufferID());
-
-
-
-            // renderBackPack(myShader,myCamera,myModel,movingLight); // function for rendering the backpack
-            // renderLightCubes(lightShader,myCamera,lightBuffer,movingLight);
-            // renderPlane(lightShader,planeBuffer,floorTexture);
-            // renderSkybox(skyboxShader,cubeMapBuffer,view,cubemapTexture);
-            // renderWindows(stencilShader,myCamera,grassBuffer,grassTexture);
-
-
-
-            glBindFramebuffer(GL_FRAMEBUFFER,sampleFrameBuffer);
-            glEnable(GL_DEPTH_TEST);
-
-            // glViewport(0, 0, Globals::SCREEN_WIDTH, Globals::SCREEN_HEIGHT); // for shadow mapping
-            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-            renderBackPack(myShader,myCamera,myModel,movingLight); // function for rendering the backpack
-            renderLightCubes(lightShader,myCamera,lightBuffer,movingLight);
-            renderPlane(lightShader,planeBuffer,floorTexture);
-            renderSkybox(skyboxShader,cubeMapBuffer,view,cubemapTexture);
-            renderWindows(stencilShader,myCamera,grassBuffer,grassTexture);
-
-            glBindFramebuffer(GL_READ_FRAMEBUFFER, sampleFrameBuffer);
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
-            glBlitFramebuffer(0, 0, Globals::SCREEN_WIDTH, Globals::SCREEN_HEIGHT, 0, 0,
-                Globals::SCREEN_WIDTH, Globals::SCREEN_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-
-            glBindFramebuffer(GL_FRAMEBUFFER,0); // default framebuffer
-            glDisable(GL_DEPTH_TEST);
-
-            glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
-
-            renderQuad(frameBufferShader,quadBuffer,textureFramebuffer);
-
+            dynamicCasters.clear();
+            for (const glm::vec3& light : movingLight)
+                dynamicCasters.push_back(lightCubeBounds(light));
+            const CascadedShadowMap::View shadowView{view,glm::radians(Globals::FOV),
+                static_cast<float>(Globals::SCREEN_WIDTH) / static_cast<float>(Globals::SCREEN_HEIGHT),0.1f,100.0f};
+            shadowMap.update(shadowView,backpackBounds,dirLightDirection,dynamicCasters);
+            // the light cubes don't cast the point lights' shadows,the lights sit inside them
+            pointShadows.update(std::span{sceneLights}.first(movingLight.size()),myCamera.Position,frustum,backpackBounds);
+
+            const bool indirect{Globals::indirectDraw && backpackBatch.isSupported()};
+            const bool deferred{Globals::deferredShading && deferredRenderer.isSupported()};
+            const bool orderIndependent{Globals::orderIndependentTransparency && oit.isSupported() && !singleSampled}; // its targets share the multisampled depth
+            const std::span<const std::uint8_t> windowsVisible{std::span{sceneVisible}.subspan(movingLight.size() + 1)};
+
+            frameGraph.reset();
+            const FrameGraph::Handle cascades{frameGraph.importTexture("cascades",shadowMap.getTextureID())};
+            const FrameGraph::Handle pointShadowMaps{frameGraph.importTexture("pointShadows",pointShadows.getTextureID())};
+            const unsigned int sceneFrameBuffer{singleSampled ? antiAliasing.getFrameBufferID() : sampleFrameBuffer};
+            const FrameGraph::Handle scene{frameGraph.importFramebuffer(singleSampled ? "scene" : "msScene",sceneFrameBuffer,renderWidth,renderHeight)}; // its bottom left
+            const FrameGraph::Handle oitLayers{frameGraph.importTexture("oitLayers",oit.getTextureID(0))};
+            const FrameGraph::Handle screen{frameGraph.importFramebuffer("screen",0,Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT)};
+            frameGraph.markOutput(screen);
+
+            frameGraph.addPass("cascades",[&](FrameGraph::Builder& builder){ builder.write(cascades); },[&](const FrameGraph::Context&){
+                std::optional<InstanceBuffer::Range> cubeCasters; // uploaded by the first cascade that needs them
+                shadowMap.render([&](const Frustum& cascade){ renderStaticShadowCasters(shadowMap.shader(),backpackPositions,myModel,lightBuffer,cascade); },
+                                 [&](const Frustum&){ renderDynamicShadowCasters(shadowMap.shader(),lightBuffer,movingLight,instanceBuffer,cubeCasters); });
+            });
+            frameGraph.addPass("pointShadows",[&](FrameGraph::Builder& builder){ builder.write(pointShadowMaps); },[&](const FrameGraph::Context&){
+                pointShadows.render([&](const BoundingSphere& light){ renderStaticShadowCasters(pointShadows.shader(),backpackPositions,myModel,lightBuffer,light); });
+            });
+
+            frameGraph.addPass("opaque",[&](FrameGraph::Builder& builder){
+                if (shadowMap.isActive()) // otherwise nothing reads the cascades and their pass is culled
+                    builder.read(cascades);
+                if (pointShadows.isActive())
+                    builder.read(pointShadowMaps);
+                builder.write(scene);
+            },[&](const FrameGraph::Context&){
+                glEnable(GL_DEPTH_TEST);
+                glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                const OcclusionCuller* occlusion{nullptr};
+                if (Globals::occlusionCulling)
+                {
+                    renderOccluders(occlusionCuller,myModel,occluders,viewProjection);
+                    occlusion = &occlusionCuller;
+                }
+
+                cullBackPack(myModel,viewProjection,occlusion,backpackVisible);
+                renderQueue.clear();
+                bool depthPrepassed{false};
+                if (deferred)
+                {
+                    {
+                        const GpuProfiler::Scope scope{&gpuProfiler,"gBuffer"};
+                        deferredRenderer.beginGeometry(); // the backpack goes into the G-buffer,the rest of the scene stays forward
+                        if (indirect)
+                        {
+                            renderBackPackIndirect(*indirectGBufferShader,myCamera,backpackBatch,movingLight,clusteredLights,shadowMap,pointShadows,backpackVisible,false);
+                        }
+                        else
+                        {
+                            renderBackPack(gBufferShader,myCamera,myModel,movingLight,clusteredLights,shadowMap,pointShadows,backpackVisible,false,renderQueue);
+                            renderQueue.sort();
+                            renderQueue.execute(&gpuProfiler);
+                            renderQueue.clear();
+                        }
+                        deferredRenderer.endGeometry();
+                    }
+
+                    setBackPackLighting(deferredRenderer.directionalShader(),myCamera,movingLight,clusteredLights,shadowMap,pointShadows);
+                    setBackPackLighting(deferredRenderer.lightShader(),myCamera,movingLight,clusteredLights,shadowMap,pointShadows);
+                    deferredRenderer.setViewport(renderWidth,renderHeight);
+                    const GpuProfiler::Scope scope{&gpuProfiler,"deferredShading"};
+                    deferredRenderer.shade(sceneFrameBuffer,jitteredProjection * view,clusteredLights.lightCount(),flashlightVolume(myCamera),quadBuffer.getVAO());
+                }
+                else
+                {
+                    depthPrepassed = depthPrepass.beginFrame(); // times the opaque passes,up to renderQueue.execute
+                    {
+                        const GpuProfiler::Scope scope{&gpuProfiler,"depthPrepass"};
+                        depthPrepass.render(backpackVisible,backPackTransform());
+                    }
+                    if (indirect)
+                    {
+                        const GpuProfiler::Scope scope{&gpuProfiler,"backpackIndirect"}; // drawn right away,not through the queue
+                        renderBackPackIndirect(*indirectShader,myCamera,backpackBatch,movingLight,clusteredLights,shadowMap,pointShadows,backpackVisible,depthPrepassed);
+                    }
+                    else
+                        renderBackPack(myShader,myCamera,myModel,movingLight,clusteredLights,shadowMap,pointShadows,backpackVisible,depthPrepassed,renderQueue); // the render functions only set up their programs and submit
+                }
+
+                refitScene(sceneBVH,movingLight); // the light cubes follow the lights
+                std::ranges::fill(sceneVisible,std::uint8_t{0});
+                std::size_t visibleObjects{0};
+                sceneBVH.query(frustum,[&](const std::uint32_t object){
+                    if (occlusion && !occlusion->isVisible(sceneBVH.boundsOf(object)))
+                        return;
+                    sceneVisible[object] = 1;
+                    ++visibleObjects;
+                });
+                FrustumCuller::countFrame(visibleObjects,sceneVisible.size() - visibleObjects);
+
+                const InstanceBuffer::Range cubeInstances{renderLightCubes(lightShader,myCamera,lightBuffer,movingLight,previousLight,sceneVisible,instanceBuffer,renderQueue)};
+                renderPlane(lightShader,myCamera,planeBuffer,floorTexture,renderQueue);
+                renderSkybox(skyboxShader,cubeMapBuffer,view,cubemapTexture,renderQueue);
+                renderQueue.cull(frustum);
+                renderQueue.sort();
+                renderQueue.execute(&gpuProfiler); // the backpack's meshes are prepassedDraws after a pre-pass,opaqueDraws with the cubes and the plane otherwise
+                antiAliasing.renderVelocity([&](const Shader& velocityShader){ renderLightCubeVelocity(velocityShader,lightBuffer,cubeInstances); }); // TAA only
+                if (!deferred)
+                    depthPrepass.endFrame();
+            });
+
+            if (orderIndependent) // no sorting,composited after the resolve
+            {
+                frameGraph.addPass("windowsOIT",[&](FrameGraph::Builder& builder){ builder.read(scene); builder.write(oitLayers); },[&](const FrameGraph::Context&){
+                    renderWindowsOIT(oitShader,grassBuffer,grassTexture,windowsVisible,instanceBuffer,oit);
+                });
+            }
+            else
+            {
+                frameGraph.addPass("windows",[&](FrameGraph::Builder& builder){ builder.read(scene); builder.write(scene); },[&](const FrameGraph::Context&){
+                    renderWindows(stencilShader,myCamera,grassBuffer,grassTexture,windowsVisible,windowSorter);
+                });
+            }
+
+            AntiAliasing::Output resolved{0,renderWidth,renderHeight};
+            if (singleSampled) // no blit,the edges are smoothed by the mode's passes
+            {
+                resolved = antiAliasing.addTo(frameGraph,scene,renderWidth,renderHeight,quadBuffer.getVAO());
+            }
+            else
+            {
+                frameGraph.addPass("resolve",[&](FrameGraph::Builder& builder){
+                    builder.read(scene);
+                    resolved.texture = builder.create("resolved",{renderWidth,renderHeight,sceneColorFormat});
+                },[&](const FrameGraph::Context&){
+                    glBindFramebuffer(GL_READ_FRAMEBUFFER, sampleFrameBuffer); // the resolved target is bound for drawing
+                    glBlitFramebuffer(0, 0, static_cast<int>(renderWidth), static_cast<int>(renderHeight), 0, 0,
+                        static_cast<int>(renderWidth), static_cast<int>(renderHeight), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+                });
+            }
+
+            if (orderIndependent)
+            {
+                frameGraph.addPass("oitComposite",[&](FrameGraph::Builder& builder){
+                    builder.read(oitLayers);
+                    builder.read(resolved.texture);
+                    builder.write(resolved.texture);
+                },[&](const FrameGraph::Context& context){
+                    oit.composite(context.framebuffer(),quadBuffer.getVAO());
+                });
+            }
+
+            renderQuad(postProcess,frameGraph,quadBuffer,resolved.texture,resolved.width,resolved.height,screen); // and up to the window's size
+
+            {
+                PROFILE_SCOPE("frameGraphCompile");
+                frameGraph.compile();
+            }
+            if (Globals::dumpFrameGraph)
+            {
+                frameGraph.dump(std::cout);
+                Globals::dumpFrameGraph = false;
+            }
+            dynamicResolution.beginFrame();
+            gpuProfiler.beginFrame();
+            {
+                PROFILE_SCOPE("frameGraphExecute");
+                frameGraph.execute(&gpuProfiler);
+            }
+            gpuProfiler.endFrame();
+            dynamicResolution.endFrame();
+            if (Globals::printGpuProfile)
+            {
+                gpuProfiler.print(std::cout);
+                Globals::printGpuProfile = false;
+            }
+            antiAliasing.recordFrame(dynamicResolution.gpuMilliseconds());
+            antiAliasing.endFrame();
+            previousLight = movingLight;
+            instanceBuffer.endFrame(); // every draw reading this frame's instances was issued
+
+            PROFILE_SCOPE("swapBuffers");
             glfwSwapBuffers(window); // double buffers(front and back) used simultaneously to make whatever is on screen appear smooth
+            GLCapture::endFrame(); // a frame of the trace,if one is being captured
+            if (bench)
+            {
+                bench->count("drawnObjects",FrustumCuller::drawnThisFrame());
+                bench->count("culledObjects",FrustumCuller::culledThisFrame());
+                bench->count("queuedDraws",static_cast<double>(renderQueue.size()));
+                bench->count("stateChanges",renderQueue.getStateChanges());
+                bench->count("lights",static_cast<double>(clusteredLights.lightCount()));
+                bench->count("frameGraphMegabytes",static_cast<double>(frameGraph.allocatedMemory()) / (1024.0 * 1024.0));
+                bench->endFrame(gpuProfiler);
+            }
             glfwPollEvents(); // this calls the callback functions,takes input,updates the window;
         }
 
+        if (bench)
+        {
+            bench->print(std::cout);
+            if (!bench->write(reinterpret_cast<const char*>(glGetString(GL_RENDERER)),Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT))
+                std::cout << "BENCH: can't write " << bench->getSettings().output << '\n';
+        }
+
         myShader.end();
         lightShader.end();
         stencilShader.end();
-        frameBufferShader.end();
         skyboxShader.end();
         normalShader.end();
+        oitShader.end();
+        gBufferShader.end();
+        if (indirectShader)
+        {
+            indirectShader->end();
+            indirectGBufferShader->end();
+        }
     }
 
+    GLCapture::finish(); // if the window closed before the frames asked for were captured
+
+    if (const std::size_t zones{PROFILE_WRITE_TRACE("trace.json")}) // the CPU zones of the last frames,for chrome://tracing or Perfetto
+        std::cout << "CPU TRACE: " << zones << " zones written to trace.json\n";
+
     glfwTerminate(); // end the window
 
     return 0;
@@ -275,15 +620,128 @@ void printFPS(double& zeroFrame,int& nFrames)
 
     if (currentFrame - zeroFrame > 1.0f) // FPS calculator
     {
-        std::cout << "FPS: " << nFrames  << '\n';
+        std::cout << "FPS: " << nFrames << "     DRAWN: " << FrustumCuller::drawnThisFrame()
+                  << "     CULLED: " << FrustumCuller::culledThisFrame() << '\n';
         nFrames = 0.0;
         zeroFrame = currentFrame;
     }
 }
 
-void renderBackPack(const Shader& shader,const Camera& camera,const Model& backpack,std::vector<glm::vec3>& movingLight){
+float viewDepth(const Camera& camera,const glm::vec3& position) // distance along the view direction,used for the sort keys
+{
+    return glm::dot(position - camera.Position,camera.Front);
+}
+
+glm::mat4 lightCubeTransform(const glm::vec3& light)
+{
+    auto lightModel = glm::mat4(1.0f);
+    lightModel = glm::translate(lightModel,glm::vec3(std::sin(light.x),0.0f,light.z));
+    lightModel = glm::scale(lightModel,glm::vec3(1.4f));
+    return lightModel;
+}
+
+AABB lightCubeBounds(const glm::vec3& light) // every light is a line of cubes,see renderLightCubes
+{
+    const AABB instancedCubeBounds{glm::vec3(-0.5f),glm::vec3(static_cast<float>(cubesPerLight) - 0.5f)};
+    return instancedCubeBounds.transformed(lightCubeTransform(light));
+}
 
-    auto currentFrame = static_cast<float>(glfwGetTime());
+glm::mat4 staticCubeTransform()
+{
+    auto model = glm::mat4(1.0f);
+    model = glm::translate(model,glm::vec3(0.0f,5.0f,0.0f));
+    model = glm::scale(model,glm::vec3(2.0f,2.0f,2.0f));
+    return model;
+}
+
+std::vector<AABB> sceneBounds(const std::vector<glm::vec3>& movingLight)
+{
+    const AABB cubeBounds{glm::vec3(-0.5f),glm::vec3(0.5f)};
+    const AABB windowBounds{glm::vec3(0.0f,-0.5f,0.0f),glm::vec3(1.0f,0.5f,0.0f)}; // the quad in vegetationPosition
+
+    std::vector<AABB> bounds;
+    for (const glm::vec3& light : movingLight)
+        bounds.push_back(lightCubeBounds(light));
+    bounds.push_back(cubeBounds.transformed(staticCubeTransform()));
+    for (const glm::vec3& pos : TemporaryVertices::vegetation)
+        bounds.push_back({windowBounds.min + pos,windowBounds.max + pos});
+    return bounds;
+}
+
+void refitScene(BVH& sceneBVH,const std::vector<glm::vec3>& movingLight)
+{
+    PROFILE_FUNCTION();
+    for (std::uint32_t i{0}; i < movingLight.size(); ++i)
+        sceneBVH.update(i,lightCubeBounds(movingLight[i]));
+    sceneBVH.refit();
+}
+
+glm::mat4 backPackTransform()
+{
+    auto model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, 0.0f, -20.0f)); // translate it down so it's at the center of the scene
+    model = glm::scale(model, glm::vec3(2.3f, 2.3f, 2.3f));	// it's a bit too big for our scene, so scale it down
+    return model;
+}
+
+AABB backPackBounds(const Model& backpack)
+{
+    const glm::mat4 model{backPackTransform()};
+    AABB bounds;
+    for (const Mesh& mesh : backpack.meshes)
+        bounds.expand(mesh.bounds.transformed(model));
+    return bounds;
+}
+
+void animateLights(std::vector<glm::vec3>& movingLight)
+{
+    PROFILE_FUNCTION();
+    for (unsigned int i{0}; i < movingLight.size();++i)
+        movingLight[i] = glm::vec3(std::sin(Globals::sceneTime) * 1.0f * i ,static_cast<float>(i) * 1.0f,std::cos(Globals::sceneTime) * 3.0f * i);
+}
+
+// the moving lights,plus a swarm of small colored ones when Globals::manyLights is on
+void gatherLights(std::vector<ClusteredLights::PointLight>& sceneLights,const std::vector<glm::vec3>& movingLight)
+{
+    PROFILE_FUNCTION();
+    sceneLights.clear();
+    for (const glm::vec3& position : movingLight)
+        sceneLights.push_back({.position = position,.diffuse = glm::vec3(0.15f),.specular = glm::vec3(1.0f),.ambient = glm::vec3(0.05f)});
+
+    if (!Globals::manyLights)
+        return;
+
+    struct Orbit {
+        float radius;
+        float height;
+        float phase;
+        float speed;
+        glm::vec3 color;
+    };
+    static const std::vector<Orbit> orbits{[]{
+        std::mt19937 generator{7};
+        std::uniform_real_distribution<float> unit{0.0f,1.0f};
+        std::vector<Orbit> result(Globals::MANY_LIGHTS);
+        for (Orbit& orbit : result)
+            orbit = {2.0f + 28.0f * unit(generator),-1.0f + 8.0f * unit(generator),6.2831853f * unit(generator),
+                     0.1f + 0.4f * unit(generator),glm::vec3(unit(generator),unit(generator),unit(generator))};
+        return result;
+    }()};
+
+    const auto time{static_cast<float>(Globals::sceneTime)};
+    for (const Orbit& orbit : orbits)
+    {
+        const float angle{orbit.phase + time * orbit.speed};
+        sceneLights.push_back({.position = glm::vec3(std::cos(angle) * orbit.radius,orbit.height,std::sin(angle) * orbit.radius),
+                               .diffuse = orbit.color * 0.8f,.constant = 1.0f,.specular = orbit.color * 0.3f,.linear = 0.7f,
+                               .ambient = glm::vec3(0.0f),.quadratic = 1.8f});
+    }
+}
+
+void setBackPackLighting(const Shader& shader,const Camera& camera,const std::vector<glm::vec3>& movingLight,const ClusteredLights& clusteredLights,const CascadedShadowMap& shadowMap,const PointShadowAtlas& pointShadows){
+    PROFILE_FUNCTION();
+
+    auto currentFrame = static_cast<float>(Globals::sceneTime);
 
     shader.use();
     shader.setVec3("viewPos",camera.Position);
@@ -294,7 +752,6 @@ void renderBackPack(const Shader& shader,const Camera& camera,const Model& backp
 
     for (unsigned int i{0}; i < movingLight.size();++i)
     {
-        movingLight[i] = glm::vec3(std::sin(glfwGetTime()) * 1.0f * i ,static_cast<float>(i) * 1.0f,std::cos(glfwGetTime()) * 3.0f * i);
         std::string index{std::to_string(i)};
         shader.setVec3("pointLights[" + index + "].position",movingLight[i]);
         shader.setFloat("pointLights["+ index +"].constant",1.0f);
@@ -304,6 +761,8 @@ void renderBackPack(const Shader& shader,const Camera& camera,const Model& backp
         shader.setVec3("pointLights["+ index +"].diffuse",  0.15f,0.15f,0.15f); // darken diffuse light a bit
         shader.setVec3("pointLights["+ index +"].specular", 1.0f, 1.0f, 1.0f);
     }
+    shader.setBool("clusteredLights",Globals::clusteredLighting);
+    clusteredLights.bind(shader);
     shader.setBool("hasFlashed",Globals::hasFlashed); // spotlight turning off and on
     shader.setBool("blinnPhong",Globals::blinnPhong);
             // spotlight details
@@ -312,104 +771,347 @@ void renderBackPack(const Shader& shader,const Camera& camera,const Model& backp
     shader.setFloat("spotLight.quadratic",0.032f);
     shader.setVec3("spotLight.position",camera.Position);
     shader.setVec3("spotLight.direction",camera.Front);
-    shader.setFloat("spotLight.cutOff",glm::cos(glm::radians(10.5f)));
-    shader.setFloat("spotLight.outerCutOff",glm::cos(glm::radians(18.0f)));
+    shader.setFloat("spotLight.cutOff",glm::cos(glm::radians(flashlightCutOff)));
+    shader.setFloat("spotLight.outerCutOff",glm::cos(glm::radians(flashlightOuterCutOff)));
     shader.setVec3("spotLight.ambient",  glm::vec3(0.0f));
     shader.setVec3("spotLight.diffuse",  1.0f,1.0f,1.0f); // darken diffuse light a bit
     shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
             //direction light details
-    shader.setVec3("dirLight.direction",-1.0f,-1.0f,-1.0f); // direction light
+    shader.setVec3("dirLight.direction",dirLightDirection); // direction light
     shader.setVec3("dirLight.ambient",  0.05f,0.05f,0.05f);
     shader.setVec3("dirLight.diffuse", 0.05f,0.05f,0.05f); // darken diffuse light a bit
     shader.setVec3("dirLight.specular", 1.0f, 1.0f, 1.0f);
+    shadowMap.bind(shader);
+    pointShadows.bind(shader);
+}
 
-    auto model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(0.0f, 0.0f, -20.0f)); // translate it down so it's at the center of the scene
-    model = glm::scale(model, glm::vec3(2.3f, 2.3f, 2.3f));	// it's a bit too big for our scene, so scale it down
+// the cone the flashlight of setBackPackLighting reaches,for the deferred path;none while it's off
+std::optional<DeferredRenderer::SpotVolume> flashlightVolume(const Camera& camera)
+{
+    if (!Globals::hasFlashed)
+        return std::nullopt;
+    const float range{ClusteredLights::rangeOf({.diffuse = glm::vec3(1.0f),.specular = glm::vec3(1.0f),.ambient = glm::vec3(0.0f)})}; // same attenuation
+    return DeferredRenderer::SpotVolume{camera.Position,camera.Front,glm::radians(flashlightOuterCutOff),range};
+}
 
+// indices of the meshes with the biggest bounds,as many as fit in the triangle budget
+std::vector<std::size_t> selectOccluders(const Model& model,const std::size_t triangleBudget)
+{
+    std::vector<std::size_t> bySize(model.meshes.size());
+    for (std::size_t i{0}; i < bySize.size(); ++i)
+        bySize[i] = i;
+
+    const auto area = [&](const std::size_t mesh){
+        const glm::vec3 extents{model.meshes[mesh].bounds.extents()};
+        return extents.x * extents.y + extents.y * extents.z + extents.z * extents.x;
+    };
+    std::ranges::sort(bySize,[&](const std::size_t a,const std::size_t b){ return area(a) > area(b); });
+
+    std::vector<std::size_t> occluders;
+    std::size_t triangles{0};
+    for (const std::size_t mesh : bySize)
+    {
+        const std::size_t meshTriangles{model.meshes[mesh].indices.size() / 3};
+        if (triangles + meshTriangles > triangleBudget)
+            continue;
+        occluders.push_back(mesh);
+        triangles += meshTriangles;
+    }
+    return occluders;
+}
 
-    shader.setMat4("transform",model);
-    backpack.Draw(shader);
+void renderOccluders(OcclusionCuller& occlusionCuller,const Model& backpack,std::span<const std::size_t> occluders,const glm::mat4& viewProjection)
+{
+    PROFILE_FUNCTION();
+    occlusionCuller.beginFrame(viewProjection);
+    const glm::mat4 model{backPackTransform()};
+    for (const std::size_t mesh : occluders)
+        occlusionCuller.addOccluder(std::span<const Mesh::Vertex>{backpack.meshes[mesh].vertices},std::span<const unsigned int>{backpack.meshes[mesh].indices},model);
+    occlusionCuller.rasterize(); // on the worker threads,the caller takes the last rows
 }
-void renderLightCubes(const Shader& lightShader,const Camera& camera,const ArrayBuffer& lightBuffer,const std::vector<glm::vec3>& movingLight) {
 
-    lightShader.use();
-    lightShader.setInt("skybox",0);
-    lightShader.setVec3("cameraPos",camera.Position);
+// the meshes of the backpack that pass the frustum test and,when it's on,the occlusion test
+void cullBackPack(const Model& backpack,const glm::mat4& viewProjection,const OcclusionCuller* occlusion,std::vector<std::uint32_t>& visibleMeshes){
+    PROFILE_FUNCTION();
+
+    const glm::mat4 model{backPackTransform()};
+    visibleMeshes.clear();
+    backpack.meshBVH.query(Frustum{viewProjection * model},[&](const std::uint32_t mesh){ // the frustum in model space,so the tree never changes
+        if (occlusion && !occlusion->isVisible(backpack.meshes[mesh].bounds.transformed(model)))
+            return;
+        visibleMeshes.push_back(mesh);
+    });
+    FrustumCuller::countFrame(visibleMeshes.size(),backpack.meshes.size() - visibleMeshes.size());
+}
+
+void renderBackPack(const Shader& shader,const Camera& camera,const Model& backpack,const std::vector<glm::vec3>& movingLight,const ClusteredLights& clusteredLights,const CascadedShadowMap& shadowMap,const PointShadowAtlas& pointShadows,std::span<const std::uint32_t> visibleMeshes,const bool depthPrepassed,RenderQueue& renderQueue){
+    PROFILE_FUNCTION();
+
+    setBackPackLighting(shader,camera,movingLight,clusteredLights,shadowMap,pointShadows);
+
+    const glm::mat4 model{backPackTransform()};
+    const float depth{viewDepth(camera,glm::vec3(model[3]))};
+    const RenderQueue::Pass pass{depthPrepassed ? RenderQueue::Pass::prepassed : RenderQueue::Pass::opaque};
+    for (const std::uint32_t mesh : visibleMeshes)
+        renderQueue.submit(pass,depth,{.shader = &shader,.mesh = &backpack.meshes[mesh],.transform = model});
+}
 
-    for (const glm::vec3& light : movingLight) {
-        auto lightModel = glm::mat4(1.0f);
-        lightModel = glm::translate(lightModel,glm::vec3(std::sin(light.x),0.0f,light.z));
-        lightModel = glm::scale(lightModel,glm::vec3(1.4f));
+void renderBackPackIndirect(const Shader& indirectShader,const Camera& camera,StaticBatch& backpackBatch,const std::vector<glm::vec3>& movingLight,const ClusteredLights& clusteredLights,const CascadedShadowMap& shadowMap,const PointShadowAtlas& pointShadows,std::span<const std::uint32_t> visibleMeshes,const bool depthPrepassed){
+    PROFILE_FUNCTION();
 
-        lightShader.setMat4("transform",lightModel);
+    setBackPackLighting(indirectShader,camera,movingLight,clusteredLights,shadowMap,pointShadows);
 
+    const glm::mat4 model{backPackTransform()};
+    for (const std::uint32_t mesh : visibleMeshes)
+        backpackBatch.add(mesh,model);
+    if (depthPrepassed)
+        glDepthMask(GL_FALSE);
+    backpackBatch.draw(indirectShader); // one multi-draw per texture binding set instead of one draw per mesh
+    glDepthMask(GL_TRUE);
+}
+// the static shadow casters a light reaches (a cascade's Frustum or a point light's BoundingSphere):
+// the backpack meshes and the static cube
+template<typename Volume>
+void renderStaticShadowCasters(const Shader& depthShader,const PositionStream& backpackPositions,const Model& backpack,const ArrayBuffer& lightBuffer,const Volume& reach){
+    PROFILE_FUNCTION();
+
+    const glm::mat4 model{backPackTransform()};
+    depthShader.setMat4("transform",model);
+    glBindVertexArray(backpackPositions.getVAO());
+    for (std::uint32_t mesh{0}; mesh < backpack.meshes.size(); ++mesh)
+    {
+        if (reach.intersects(backpack.meshes[mesh].bounds.transformed(model)))
+            backpackPositions.draw(mesh);
+    }
+
+    const glm::mat4 cube{staticCubeTransform()};
+    if (reach.intersects(AABB{glm::vec3(-0.5f),glm::vec3(0.5f)}.transformed(cube)))
+    {
+        depthShader.setMat4("transform",cube);
         glBindVertexArray(lightBuffer.getVAO());
-        glDrawArraysInstanced(GL_TRIANGLES, 0, 36,100);
+        glDrawArrays(GL_TRIANGLES,0,36);
     }
-    auto model = glm::mat4(1.0f);
-    model = glm::translate(model,glm::vec3(0.0f,5.0f,0.0f));
-    model = glm::scale(model,glm::vec3(2.0f,2.0f,2.0f));
-    lightShader.setMat4("transform",model);
+    glBindVertexArray(0);
+}
+
+// the moving light cubes,drawn into every cascade they are in;their instances are uploaded once a frame
+void renderDynamicShadowCasters(const Shader& depthShader,const ArrayBuffer& lightBuffer,const std::vector<glm::vec3>& movingLight,InstanceBuffer& instanceBuffer,std::optional<InstanceBuffer::Range>& cubeInstances){
+    PROFILE_FUNCTION();
 
+    if (!cubeInstances)
+    {
+        static std::vector<InstanceBuffer::Instance> instances; // keeps its capacity between frames
+        instances.clear();
+        for (const glm::vec3& light : movingLight)
+        {
+            const glm::mat4 lightModel{lightCubeTransform(light)};
+            for (int cube{0}; cube < cubesPerLight; ++cube)
+                instances.push_back({.transform = glm::translate(lightModel,glm::vec3(static_cast<float>(cube)))});
+        }
+        cubeInstances = instanceBuffer.upload(instances);
+    }
+
+    depthShader.setMat4("transform",glm::mat4(1.0f)); // the instances carry the transforms
     glBindVertexArray(lightBuffer.getVAO());
-    glActiveTexture(GL_TEXTURE0);
-    glDrawArrays(GL_TRIANGLES,0,36);
+    InstanceBuffer::bindAttributes(*cubeInstances);
+    glDrawArraysInstanced(GL_TRIANGLES,0,36,cubeInstances->count);
+    InstanceBuffer::unbindAttributes();
+    glBindVertexArray(0);
+}
+
+// returns the cubes' instances,for renderLightCubeVelocity
+InstanceBuffer::Range renderLightCubes(const Shader& lightShader,const Camera& camera,const ArrayBuffer& lightBuffer,const std::vector<glm::vec3>& movingLight,const std::vector<glm::vec3>& previousLight,std::span<const std::uint8_t> visible,InstanceBuffer& instanceBuffer,RenderQueue& renderQueue) {
+    PROFILE_FUNCTION();
+
+    lightShader.use();
+    lightShader.setInt("skybox",0);
+    lightShader.setVec3("cameraPos",camera.Position);
 
+    static std::vector<InstanceBuffer::Instance> instances; // keeps its capacity between frames
+    instances.clear();
+    float nearest{std::numeric_limits<float>::max()};
+
+    for (std::size_t i{0}; i < movingLight.size(); ++i) {
+        if (!visible[i])
+            continue;
+        const glm::mat4 lightModel{lightCubeTransform(movingLight[i])};
+        const glm::vec3 displacement{lightModel[3] - lightCubeTransform(previousLight[i])[3]}; // the cubes only move with their light
+        for (int cube{0}; cube < cubesPerLight; ++cube) // a line of cubes along the diagonal
+            instances.push_back({.transform = glm::translate(lightModel,glm::vec3(static_cast<float>(cube))),.displacement = displacement});
+        nearest = std::min(nearest,viewDepth(camera,glm::vec3(lightModel[3])));
+    }
+    if (visible[movingLight.size()]) {
+        const glm::mat4 model{staticCubeTransform()};
+        instances.push_back({.transform = model});
+        nearest = std::min(nearest,viewDepth(camera,glm::vec3(model[3])));
+    }
+    if (instances.empty())
+        return {};
+
+    // every visible cube in one draw
+    const InstanceBuffer::Range cubeInstances{instanceBuffer.upload(instances)};
+    renderQueue.submit(RenderQueue::Pass::opaque,nearest,
+        {.shader = &lightShader,.vao = lightBuffer.getVAO(),.vertexCount = 36,.instanceData = cubeInstances});
+    return cubeInstances;
 }
-void renderPlane(const Shader& lightShader,const ArrayBuffer& planeBuffer,const uint floorTexture) {
 
-    glBindVertexArray(planeBuffer.getVAO());
-    glBindTexture(GL_TEXTURE_2D,floorTexture);
+// the light cubes again,with AntiAliasing's velocity shader
+void renderLightCubeVelocity(const Shader& velocityShader,const ArrayBuffer& lightBuffer,const InstanceBuffer::Range& cubeInstances)
+{
+    PROFILE_FUNCTION();
+
+    if (!cubeInstances.count)
+        return;
+    velocityShader.setMat4("transform",glm::mat4(1.0f)); // the instances carry the transforms
+    glBindVertexArray(lightBuffer.getVAO());
+    InstanceBuffer::bindAttributes(cubeInstances);
+    glDrawArraysInstanced(GL_TRIANGLES,0,36,cubeInstances.count);
+    InstanceBuffer::unbindAttributes();
+    glBindVertexArray(0);
+}
+void renderPlane(const Shader& lightShader,const Camera& camera,const ArrayBuffer& planeBuffer,const uint floorTexture,RenderQueue& renderQueue) {
+    PROFILE_FUNCTION();
+
     auto model = glm::mat4(1.0f);
-    lightShader.setMat4("transform",model);
-    glDrawArrays(GL_TRIANGLES,0,6);
+    renderQueue.submit(RenderQueue::Pass::opaque,viewDepth(camera,glm::vec3(model[3])),
+        {.shader = &lightShader,.vao = planeBuffer.getVAO(),.texture = floorTexture,.vertexCount = 6,.transform = model,
+         .bounds = AABB{glm::vec3(-5.0f,-0.5f,-5.0f),glm::vec3(5.0f,-0.5f,5.0f)}.transformed(model)});
 
 }
 
-void renderSkybox(const Shader& skyboxShader,const ArrayBuffer& cubeMapBuffer,glm::mat4& view,const uint cubemapTexture) {
+void renderSkybox(const Shader& skyboxShader,const ArrayBuffer& cubeMapBuffer,glm::mat4& view,const uint cubemapTexture,RenderQueue& renderQueue) {
+    PROFILE_FUNCTION();
 
     skyboxShader.use();
     view = glm::mat4(glm::mat3(view));
 
     skyboxShader.setMat4("view",view);
-    glDepthMask(GL_FALSE);
-    glBindVertexArray(cubeMapBuffer.getVAO());
-    glBindTexture(GL_TEXTURE_CUBE_MAP,cubemapTexture);
-    glDrawArrays(GL_TRIANGLES,0,36);
-    glDepthMask(GL_TRUE);
+    renderQueue.submit(RenderQueue::Pass::skybox,0.0f,
+        {.shader = &skyboxShader,.vao = cubeMapBuffer.getVAO(),.texture = cubemapTexture,.textureTarget = GL_TEXTURE_CUBE_MAP,.vertexCount = 36});
 
 }
 
-void renderWindows(const Shader& stencilShader,const Camera& camera,const ArrayBuffer& grassBuffer,const uint grassTexture) {
+void renderWindows(const Shader& stencilShader,const Camera& camera,const ArrayBuffer& grassBuffer,const uint grassTexture,std::span<const std::uint8_t> visible,TransparencySorter& windowSorter) {
+    PROFILE_FUNCTION();
 
     stencilShader.use();
     glBindVertexArray(grassBuffer.getVAO());
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D,grassTexture);
 
-    std::map<float,glm::vec3> sortedWindows;
-
-    for (glm::vec3& pos : TemporaryVertices::vegetation) {
-        float distance = glm::length(camera.Position - pos);
-        sortedWindows[distance] = pos;
+    windowSorter.begin(camera.Position);
+    for (std::size_t i{0}; i < TemporaryVertices::vegetation.size(); ++i) {
+        if (visible[i])
+            windowSorter.add(TemporaryVertices::vegetation[i],static_cast<std::uint32_t>(i));
     }
-    for(auto it = sortedWindows.rbegin(); it != sortedWindows.rend(); ++it)
+    for (const std::uint32_t window : windowSorter.backToFront())
     {
         auto model = glm::mat4(1.0f);
-        model = glm::translate(model, it->second);
+        model = glm::translate(model, TemporaryVertices::vegetation[window]);
         stencilShader.setMat4("transform", model);
         glDrawArrays(GL_TRIANGLES, 0, 6);
     }
 
 }
 
-void renderQuad(const Shader& frameBufferShader,const ArrayBuffer& quadBuffer,const uint textureFramebuffer) {
+void renderWindowsOIT(const Shader& oitShader,const ArrayBuffer& grassBuffer,const uint grassTexture,std::span<const std::uint8_t> visible,InstanceBuffer& instanceBuffer,const WeightedBlendedOIT& oit) {
+    PROFILE_FUNCTION();
 
-    frameBufferShader.use();
-    frameBufferShader.setBool("gammaCorrected",Globals::gammaCorrected);
-    glBindVertexArray(quadBuffer.getVAO());
-    glBindTexture(GL_TEXTURE_2D,textureFramebuffer);
-    glDrawArrays(GL_TRIANGLES,0,6);
+    static std::vector<InstanceBuffer::Instance> instances; // keeps its capacity between frames
+    instances.clear();
+    for (std::size_t i{0}; i < TemporaryVertices::vegetation.size(); ++i) {
+        if (visible[i])
+            instances.push_back({.transform = glm::translate(glm::mat4(1.0f),TemporaryVertices::vegetation[i])});
+    }
+    if (instances.empty())
+        return;
+
+    oit.begin();
+    oitShader.use();
+    oitShader.setMat4("transform",glm::mat4(1.0f)); // the instances carry the transforms
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D,grassTexture);
+
+    glBindVertexArray(grassBuffer.getVAO());
+    InstanceBuffer::bindAttributes(instanceBuffer.upload(instances));
+    glDrawArraysInstanced(GL_TRIANGLES,0,6,static_cast<int>(instances.size())); // every window in one draw
+    InstanceBuffer::unbindAttributes();
+    glBindVertexArray(0);
+    oit.end();
+}
+
+// the effects of the chain,in order;only gamma is on at the start,the sharpen kernel was the old frameBufferShader.fs
+void setupPostProcess(PostProcess& postProcess) {
+
+    postProcess.addKernel("sharpen",{-1.0f,-1.0f,-1.0f,
+                                     -1.0f, 9.0f,-1.0f,
+                                     -1.0f,-1.0f,-1.0f},PostProcess::Resolution::full,false);
+    postProcess.addSeparable("blur",PostProcess::gaussian(8,4.0f),PostProcess::Resolution::half,false);
+    postProcess.addPixel("toneMap",
+                         "uniform float exposure;\n"
+                         "vec3 toneMap(vec3 color)\n"
+                         "{\n"
+                         "    color *= exposure;\n"
+                         "    return clamp((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14),0.0,1.0); // ACES fit\n"
+                         "}",
+                         [](const Shader& shader){ shader.setFloat("exposure",1.0f); },false);
+    postProcess.addPixel("grade",
+                         "uniform float saturation;\n"
+                         "uniform float contrast;\n"
+                         "uniform vec3 tint;\n"
+                         "vec3 grade(vec3 color)\n"
+                         "{\n"
+                         "    float luminance = dot(color,vec3(0.2126,0.7152,0.0722));\n"
+                         "    color = mix(vec3(luminance),color,saturation);\n"
+                         "    return max((color - 0.5) * contrast + 0.5,0.0) * tint;\n"
+                         "}",
+                         [](const Shader& shader){
+                             shader.setFloat("saturation",1.2f);
+                             shader.setFloat("contrast",1.1f);
+                             shader.setVec3("tint",1.0f,0.97f,0.92f);
+                         },false);
+    postProcess.addPixel("gamma",
+                         "vec3 gamma(vec3 color)\n"
+                         "{\n"
+                         "    return pow(color,vec3(1.0 / 2.2));\n"
+                         "}",
+                         {},Globals::gammaCorrected);
+}
+
+// the post-processing passes,from the resolved scene to the screen,which may be bigger
+void renderQuad(PostProcess& postProcess,FrameGraph& frameGraph,const ArrayBuffer& quadBuffer,const FrameGraph::Handle scene,
+                const unsigned int sceneWidth,const unsigned int sceneHeight,const FrameGraph::Handle screen) {
+    PROFILE_FUNCTION();
 
+    for (std::size_t i{0}; i < postEffectNames.size(); ++i)
+        postProcess.setEnabled(postEffectNames[i],Globals::postEffects[i]);
+    postProcess.setEnabled("gamma",Globals::gammaCorrected);
+    postProcess.addTo(frameGraph,scene,sceneWidth,sceneHeight,screen,Globals::SCREEN_WIDTH,Globals::SCREEN_HEIGHT,quadBuffer.getVAO());
+
+}
+
+// the internal format of a framebuffer's attachment,texture or renderbuffer
+GLenum attachmentFormatOf(const uint framebuffer,const GLenum attachment) {
+
+    int type{GL_NONE};
+    int name{0};
+    glBindFramebuffer(GL_FRAMEBUFFER,framebuffer);
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER,attachment,GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE,&type);
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER,attachment,GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME,&name);
+    glBindFramebuffer(GL_FRAMEBUFFER,0);
+
+    int format{attachment == GL_COLOR_ATTACHMENT0 ? GL_RGBA8 : GL_DEPTH24_STENCIL8};
+    if (type == GL_RENDERBUFFER)
+    {
+        glBindRenderbuffer(GL_RENDERBUFFER,static_cast<uint>(name));
+        glGetRenderbufferParameteriv(GL_RENDERBUFFER,GL_RENDERBUFFER_INTERNAL_FORMAT,&format);
+        glBindRenderbuffer(GL_RENDERBUFFER,0);
+    }
+    else if (type == GL_TEXTURE)
+    {
+        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE,static_cast<uint>(name));
+        glGetTexLevelParameteriv(GL_TEXTURE_2D_MULTISAMPLE,0,GL_TEXTURE_INTERNAL_FORMAT,&format);
+        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE,0);
+    }
+    return static_cast<GLenum>(format);
 }
\ No newline at end of file
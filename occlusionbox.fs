@@ -0,0 +1,7 @@
+#version 330 core
+
+// nothing to write,the color mask is off while the box is drawn and only the query counts samples
+
+void main()
+{
+}
@@ -0,0 +1,28 @@
+#version 330 core
+
+// bounding box of a mesh for OcclusionQueries,depth test only
+
+layout (location = 0) in vec3 aPos; // corner of the unit cube
+
+layout (std140) uniform Perspective
+{
+    mat4 projection;
+    mat4 view;
+
+};
+
+uniform mat4 transform;
+uniform vec3 boxMin;
+uniform vec3 boxMax;
+
+void main()
+{
+vec3 position = mix(boxMin,boxMax,aPos);
+gl_Position = projection * view * transform * vec4(position,1.0);
+
+// with the camera inside the box the near faces get clipped away and the far ones may sit behind
+// whatever is in front of the mesh,so the box is pushed onto the near plane to always pass
+vec3 camera = vec3(inverse(view * transform)[3]);
+if (all(greaterThanEqual(camera,boxMin)) && all(lessThanEqual(camera,boxMax)))
+    gl_Position.z = -gl_Position.w;
+}
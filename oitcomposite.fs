@@ -0,0 +1,27 @@
+#version 330 core
+
+// resolves the WeightedBlendedOIT targets and blends them over the opaque scene (glBlendFunc(GL_ONE,GL_SRC_ALPHA))
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2DMS accumulation;
+uniform sampler2DMS revealage;
+uniform int samples;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec3 color = vec3(0.0);
+    float revealed = 0.0;
+    for (int i = 0; i < samples; i++)
+    {
+        vec4 accum = texelFetch(accumulation,texel,i);
+        float sampleRevealed = exp(-texelFetch(revealage,texel,i).r);
+        color += accum.rgb / max(accum.a,1e-5) * (1.0 - sampleRevealed);
+        revealed += sampleRevealed;
+    }
+
+    FragColor = vec4(color / float(samples),revealed / float(samples));
+}
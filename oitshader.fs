@@ -0,0 +1,28 @@
+#version 330 core
+
+// transparent surfaces for WeightedBlendedOIT,drawn in any order with additive blending
+
+layout (location = 0) out vec4 accumulation;
+layout (location = 1) out float revealage;
+
+in TEX_COORDS
+{
+    vec2 TexCoord;
+    vec3 ABNORMAL;
+    vec3 FragPos;
+    flat ivec4 Layers;
+}tex_coords;
+
+uniform sampler2D grass;
+
+void main()
+{
+    vec4 texColor = texture(grass,tex_coords.TexCoord);
+    float alpha = texColor.a;
+
+    // closer and more opaque surfaces weigh more (equation 10 of the paper)
+    float weight = clamp(pow(min(1.0,alpha * 10.0) + 0.01,3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9,3.0),1e-2,3e3);
+
+    accumulation = vec4(texColor.rgb * alpha,alpha) * weight;
+    revealage = -log(max(1.0 - alpha,1e-4)); // summed by the blend,exp() of minus the sum in oitcomposite.fs
+}
@@ -0,0 +1,37 @@
+#version 330 core
+
+// layered rendering of PointShadowAtlas: every triangle is projected on the six faces of the light's cube in
+// one pass and emitted into the layer of each face it can be seen in (gl_Layer),the others are skipped here
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 18) out;
+
+uniform mat4 faceMatrices[6]; // +X,-X,+Y,-Y,+Z,-Z
+uniform int firstLayer;       // of the light in the atlas
+
+void main()
+{
+    for(int face = 0; face < 6; ++face)
+    {
+        vec4 clip[3];
+        for(int i = 0; i < 3; ++i)
+            clip[i] = faceMatrices[face] * gl_in[i].gl_Position;
+
+        // outside the face when all three vertices are beyond the same clip plane
+        bool outside = false;
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            outside = outside || (clip[0][axis] > clip[0].w && clip[1][axis] > clip[1].w && clip[2][axis] > clip[2].w)
+                              || (clip[0][axis] < -clip[0].w && clip[1][axis] < -clip[1].w && clip[2][axis] < -clip[2].w);
+        }
+        if(outside)
+            continue;
+
+        for(int i = 0; i < 3; ++i)
+        {
+            gl_Layer = firstLayer + face;
+            gl_Position = clip[i];
+            EmitVertex();
+        }
+        EndPrimitive();
+    }
+}
@@ -0,0 +1,13 @@
+#version 330 core
+
+// point light shadow casters (PointShadowAtlas): positions only,in world space;pointshadow.gs projects them on the faces
+layout (location = 0) in vec3 aPos;
+layout (location = 8) in mat4 aInstanceTransform; // per instance (InstanceBuffer),identity for plain draws
+
+uniform mat4 transform;
+
+void main()
+{
+mat4 model = transform * aInstanceTransform;
+gl_Position = model * vec4(aPos, 1.0);
+}
@@ -6,6 +6,8 @@ struct Material {
     sampler2D texture_diffuse1;
     sampler2D texture_specular1;
     sampler2D texture_normal1;
+    sampler2DArray diffuseLayers;
+    sampler2DArray specularLayers;
     float shininess;
 };
 
@@ -51,8 +53,35 @@ uniform DirLight dirLight;
 uniform PointLight pointLights[NR_POINT_LIGHTS];
 uniform SpotLight spotLight;
 
+// clustered point lights (ClusteredLights),used instead of pointLights when clusteredLights is set
+uniform bool clusteredLights;
+uniform samplerBuffer clusterLights;   // four texels per light
+uniform usamplerBuffer clusterIndices; // offset << 8 | count per cluster,then the light indices
+uniform uvec3 clusterGrid;
+uniform uvec2 clusterTileSize;
+uniform float clusterDepthScale;
+uniform float clusterDepthBias;
+
+// cascaded shadow map of the directional light (CascadedShadowMap)
+uniform bool shadows;
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 cascadeMatrices[4];
+uniform vec4 cascadeSplits;     // view depth where each cascade ends
+uniform vec4 cascadeTexelSizes; // world size of a shadow map texel in each cascade
+
+// omnidirectional shadows of the first NR_POINT_LIGHTS point lights (PointShadowAtlas),six layers a light
+uniform sampler2DArrayShadow pointShadowMap;
+uniform vec4 pointShadows[NR_POINT_LIGHTS]; // where the light's map was drawn from and its far plane;w is 0 without one
+uniform float pointShadowNear;
+
+PointLight fetchClusterLight(int index);
+uint clusterOfFragment();
+float viewDepthOfFragment();
+float dirShadow(vec3 position,float viewDepth,vec3 normal,vec3 lightDirection);
+float pointShadow(int index,vec3 position,vec3 normal);
+
 vec3 calculateDirLight(DirLight light,vec3 normal,vec3 viewDir);
-vec3 calculatePointLight(PointLight light,vec3 normal,vec3 viewDir,vec3 FragPos);
+vec3 calculatePointLight(PointLight light,vec3 normal,vec3 viewDir,vec3 FragPos,float shadow);
 vec3 calculateSpotLight(SpotLight light,vec3 normal,vec3 viewDirection,vec3 FragPos);
 
 out vec4 FragColor;
@@ -60,17 +89,26 @@ out vec4 FragColor;
 in vec2 TexCoord;
 in vec3 Normal;
 in vec3 FragPos;
+flat in ivec4 Layers; // layer of the diffuse,specular,normal and height map in its array;-1 when the map is a plain sampler2D
 
 uniform vec3 objectColor;
 uniform vec3 viewPos;
 uniform bool hasFlashed;
 uniform bool blinnPhong;
 
+vec3 diffuseMap;
+vec3 specularMap;
+
 float near = 0.1;
 float far  = 100.0;
 
 void main()
 {
+diffuseMap = Layers.x < 0 ? vec3(texture(material.texture_diffuse1,TexCoord))
+                          : vec3(texture(material.diffuseLayers,vec3(TexCoord,Layers.x)));
+specularMap = Layers.y < 0 ? vec3(texture(material.texture_specular1,TexCoord))
+                           : vec3(texture(material.specularLayers,vec3(TexCoord,Layers.y)));
+
 vec3 objectNormal = normalize(Normal);
 // vec3 objectNormal = normalize(material.texture_normal1);
 vec3 viewDirection = normalize(viewPos - FragPos);
@@ -79,8 +117,25 @@ vec3 resultingLight;
 
 resultingLight += calculateDirLight(dirLight,objectNormal,viewDirection);
 
-for(int i = 0; i <= NR_POINT_LIGHTS;++i)
-    resultingLight += calculatePointLight(pointLights[i],objectNormal,viewDirection,FragPos);
+if(clusteredLights)
+{
+    uint cluster = texelFetch(clusterIndices,int(clusterOfFragment())).r;
+    int first = int(clusterGrid.x * clusterGrid.y * clusterGrid.z + (cluster >> 8));
+    int count = int(cluster & 0xFFu);
+    for(int i = 0; i < count; ++i)
+    {
+        int index = int(texelFetch(clusterIndices,first + i).r);
+        vec4 positionRange = texelFetch(clusterLights,index * 4);
+        if(distance(positionRange.xyz,FragPos) > positionRange.w)
+            continue; // the light reaches the cluster,not this fragment
+        resultingLight += calculatePointLight(fetchClusterLight(index),objectNormal,viewDirection,FragPos,pointShadow(index,FragPos,objectNormal));
+    }
+}
+else
+{
+    for(int i = 0; i < NR_POINT_LIGHTS;++i)
+        resultingLight += calculatePointLight(pointLights[i],objectNormal,viewDirection,FragPos,pointShadow(i,FragPos,objectNormal));
+}
 
 if(hasFlashed)
     resultingLight += calculateSpotLight(spotLight,objectNormal,viewDirection,FragPos);
@@ -90,6 +145,101 @@ FragColor = vec4(resultingLight ,1.0);
 
 }
 
+PointLight fetchClusterLight(int index)
+{
+    vec4 positionRange = texelFetch(clusterLights,index * 4);
+    vec4 diffuseConstant = texelFetch(clusterLights,index * 4 + 1);
+    vec4 specularLinear = texelFetch(clusterLights,index * 4 + 2);
+    vec4 ambientQuadratic = texelFetch(clusterLights,index * 4 + 3);
+
+    PointLight light;
+    light.position = positionRange.xyz;
+    light.diffuse = diffuseConstant.rgb;
+    light.constant = diffuseConstant.a;
+    light.specular = specularLinear.rgb;
+    light.linear = specularLinear.a;
+    light.ambient = ambientQuadratic.rgb;
+    light.quadratic = ambientQuadratic.a;
+    return light;
+}
+
+uint clusterOfFragment()
+{
+    uint slice = uint(clamp(log(viewDepthOfFragment()) * clusterDepthScale - clusterDepthBias,0.0,float(clusterGrid.z - 1u)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy) / clusterTileSize,clusterGrid.xy - 1u);
+    return (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
+}
+
+float viewDepthOfFragment()
+{
+    float ndcDepth = gl_FragCoord.z * 2.0 - 1.0;
+    return 2.0 * near * far / (far + near - ndcDepth * (far - near));
+}
+
+// 1.0 lit,0.0 in the shadow of the directional light: 3x3 hardware comparisons in the cascade the depth falls in
+float dirShadow(vec3 position,float viewDepth,vec3 normal,vec3 lightDirection)
+{
+    if(!shadows || viewDepth > cascadeSplits.w)
+        return 1.0;
+    int cascade = 0;
+    while(cascade < 3 && viewDepth > cascadeSplits[cascade])
+        ++cascade;
+
+    // normal offset against acne: a texel of the cascade away from the surface,two at grazing angles
+    float grazing = 1.0 - max(dot(normal,lightDirection),0.0);
+    vec3 offsetPosition = position + normal * cascadeTexelSizes[cascade] * (1.0 + grazing);
+    vec3 coords = (cascadeMatrices[cascade] * vec4(offsetPosition,1.0)).xyz * 0.5 + 0.5;
+    coords.z = min(coords.z,1.0);
+
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap,0).xy);
+    float lit = 0.0;
+    for(int x = -1; x <= 1; ++x)
+        for(int y = -1; y <= 1; ++y)
+            lit += texture(shadowMap,vec4(coords.xy + vec2(x,y) * texel,float(cascade),coords.z));
+    return lit / 9.0;
+}
+
+// 1.0 lit,0.0 in the shadow of point light index: the face of its cube the fragment is in,picked and addressed
+// like a cube map,and one hardware 2x2 comparison against it
+float pointShadow(int index,vec3 position,vec3 normal)
+{
+    if(index >= NR_POINT_LIGHTS || pointShadows[index].w == 0.0)
+        return 1.0;
+    vec3 lightPosition = pointShadows[index].xyz;
+    float texels = float(textureSize(pointShadowMap,0).x);
+
+    // normal offset against acne: a texel and a half of the face at that distance
+    vec3 v = position + normal * (3.0 * distance(position,lightPosition) / texels) - lightPosition;
+    vec3 a = abs(v);
+    float ma;
+    int face;
+    vec2 sc;
+    if(a.x >= a.y && a.x >= a.z)
+    {
+        ma = a.x;
+        face = v.x > 0.0 ? 0 : 1;
+        sc = vec2(v.x > 0.0 ? -v.z : v.z,-v.y);
+    }
+    else if(a.y >= a.z)
+    {
+        ma = a.y;
+        face = v.y > 0.0 ? 2 : 3;
+        sc = vec2(v.x,v.y > 0.0 ? v.z : -v.z);
+    }
+    else
+    {
+        ma = a.z;
+        face = v.z > 0.0 ? 4 : 5;
+        sc = vec2(v.z > 0.0 ? v.x : -v.x,-v.y);
+    }
+
+    float farPlane = pointShadows[index].w;
+    float nearPlane = pointShadowNear;
+    float depth = (farPlane + nearPlane) / (farPlane - nearPlane) - 2.0 * farPlane * nearPlane / ((farPlane - nearPlane) * ma); // what the face's projection gives
+    vec2 uv = clamp(sc / ma * 0.5 + 0.5,0.5 / texels,1.0 - 0.5 / texels);
+    return texture(pointShadowMap,vec4(uv,float(index * 6 + face),min(depth * 0.5 + 0.5,1.0)));
+}
+
 vec3 calculateDirLight(DirLight light,vec3 normal,vec3 viewDir)
 {
     vec3 lightDirection = normalize(-light.direction);
@@ -110,14 +260,14 @@ vec3 calculateDirLight(DirLight light,vec3 normal,vec3 viewDir)
 
     float diffuseStrength = max(dot(normal,lightDirection),0.0f);
 
-    vec3 ambient = light.ambient * vec3(texture(material.texture_diffuse1,TexCoord));
-    vec3 diffuse = light.diffuse * vec3(texture(material.texture_diffuse1,TexCoord)) * diffuseStrength;
-    vec3 specular = light.specular * vec3(texture(material.texture_specular1,TexCoord)) * specularStrength;
+    vec3 ambient = light.ambient * diffuseMap;
+    vec3 diffuse = light.diffuse * diffuseMap * diffuseStrength;
+    vec3 specular = light.specular * specularMap * specularStrength;
 
-    return (ambient + diffuse + specular);
+    return (ambient + (diffuse + specular) * dirShadow(FragPos,viewDepthOfFragment(),normal,lightDirection));
 }
 
-vec3 calculatePointLight(PointLight light,vec3 normal,vec3 viewDir,vec3 FragPos)
+vec3 calculatePointLight(PointLight light,vec3 normal,vec3 viewDir,vec3 FragPos,float shadow)
 {
     vec3 lightDirection = normalize(light.position - FragPos);
 
@@ -140,11 +290,11 @@ vec3 calculatePointLight(PointLight light,vec3 normal,vec3 viewDir,vec3 FragPos)
 
     float diffuseStrength = max(dot(normal,lightDirection),0.0f);
 
-    vec3 ambient = light.ambient * vec3(texture(material.texture_diffuse1,TexCoord)) * attenuation;
-    vec3 diffuse = light.diffuse * vec3(texture(material.texture_diffuse1,TexCoord)) * diffuseStrength * attenuation;
-    vec3 specular = light.specular * vec3(texture(material.texture_specular1,TexCoord)) * specularStrength * attenuation;
+    vec3 ambient = light.ambient * diffuseMap * attenuation;
+    vec3 diffuse = light.diffuse * diffuseMap * diffuseStrength * attenuation;
+    vec3 specular = light.specular * specularMap * specularStrength * attenuation;
 
-    return (ambient + diffuse + specular);
+    return (ambient + (diffuse + specular) * shadow);
 }
 
 vec3 calculateSpotLight(SpotLight light,vec3 normal,vec3 viewDirection,vec3 FragPos)
@@ -173,10 +323,10 @@ vec3 calculateSpotLight(SpotLight light,vec3 normal,vec3 viewDirection,vec3 Frag
 
     float diffuseStrength = max(dot(normal,lightDirection),0.0f);
 
-    vec3 ambient = light.ambient * vec3(texture(material.texture_diffuse1,TexCoord)) * attenuation * intensity;
-    vec3 diffuse = light.diffuse * vec3(texture(material.texture_diffuse1,TexCoord)) * diffuseStrength * attenuation * intensity;
+    vec3 ambient = light.ambient * diffuseMap * attenuation * intensity;
+    vec3 diffuse = light.diffuse * diffuseMap * diffuseStrength * attenuation * intensity;
     // for some reason any specularity makes the object very bright
-    vec3 specular = light.specular * vec3(texture(material.texture_specular1,TexCoord)) * specularStrength * attenuation * intensity ;
+    vec3 specular = light.specular * specularMap * specularStrength * attenuation * intensity ;
 
     return (ambient + diffuse + specular);
 }
@@ -7,12 +7,14 @@ in TEX_COORDS{
  vec2 TexCoord;
  vec3 ABNORMAL;
  vec3 FragPos;
+ flat ivec4 Layers;
 }tex_in[];
 
 uniform float time;
 out vec2 TexCoord;
 out vec3 Normal;
 out vec3 FragPos;
+flat out ivec4 Layers;
 
 vec3 normalCalculator()
 {
@@ -37,6 +39,7 @@ void main()
     TexCoord = tex_in[0].TexCoord;
     Normal = tex_in[0].ABNORMAL;
     FragPos = tex_in[0].FragPos;
+    Layers = tex_in[0].Layers;
     EmitVertex();
 
     //gl_Position = explode(gl_in[1].gl_Position,normal_gs);
@@ -45,6 +48,7 @@ void main()
     TexCoord = tex_in[1].TexCoord;
     Normal = tex_in[1].ABNORMAL;
     FragPos = tex_in[1].FragPos;
+    Layers = tex_in[1].Layers;
     EmitVertex();
 
     //gl_Position = explode(gl_in[2].gl_Position,normal_gs);
@@ -53,6 +57,7 @@ void main()
     TexCoord = tex_in[2].TexCoord;
     Normal = tex_in[2].ABNORMAL;
     FragPos = tex_in[2].FragPos;
+    Layers = tex_in[2].Layers;
     EmitVertex();
 
     EndPrimitive();
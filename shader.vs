@@ -5,6 +5,8 @@ layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTex;
 layout(location = 3) in vec3 aTangent;
 layout(location = 4) in vec3 aBitangent;
+layout(location = 8) in mat4 aInstanceTransform; // per instance (InstanceBuffer),identity for plain draws
+layout(location = 13) in uint aInstanceMaterial; // per instance,0 for plain draws
 
 
 
@@ -15,11 +17,14 @@ layout (std140) uniform Perspective
 
 };
 
+invariant gl_Position; // the depth pre-pass (depthprepass.vs) has to land on the same depths
+
 out TEX_COORDS
 {
     vec2 TexCoord;
     vec3 ABNORMAL;
     vec3 FragPos;
+    flat ivec4 Layers;
 }tex_coords;
 
 //out vec3 ourColor;
@@ -30,13 +35,16 @@ out vec3 FragPos;
 
 uniform mat4 transform;
 uniform mat3 inverseTransposeMatrix;
+uniform ivec4 materialLayers; // array layer of the diffuse,specular,normal and height map,-1 for a plain sampler2D
+                              // (the mesh's own;an instance's material picks the variant that many layers further)
 
 
 
 
 void main()
 {
-gl_Position = projection* view * transform * vec4(aPos, 1.0) ; // see how we directly give a vec3 to vec4's constructor
+mat4 model = transform * aInstanceTransform;
+gl_Position = projection* view * model * vec4(aPos, 1.0) ; // see how we directly give a vec3 to vec4's constructor
 
 
 //FragPos = vec3(transform*vec4(aPos,1.0f));
@@ -47,7 +55,8 @@ tex_coords.TexCoord = aTex; // texture
 //Normal = inverseTransposeMatrix * aNormal;
 //Normal =aNormal;
 tex_coords.ABNORMAL = aNormal;
-tex_coords.FragPos = vec3(transform*vec4(aPos,1.0f));
+tex_coords.FragPos = vec3(model*vec4(aPos,1.0f));
+tex_coords.Layers = materialLayers + ivec4(greaterThanEqual(materialLayers,ivec4(0))) * int(aInstanceMaterial);
 
 
 }
@@ -0,0 +1,67 @@
+#version 450 core
+#extension GL_ARB_shader_draw_parameters : enable
+
+// shader.vs for StaticBatch:the transform and material of every draw come out of storage buffers
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTex;
+layout(location = 3) in vec3 aTangent;
+layout(location = 4) in vec3 aBitangent;
+layout(location = 7) in uint aDrawIndex; // baseInstance of the command,only needed without gl_DrawIDARB
+
+layout (std140) uniform Perspective
+{
+    mat4 projection;
+    mat4 view;
+
+};
+
+invariant gl_Position; // the depth pre-pass (depthprepass.vs) has to land on the same depths
+
+struct DrawData
+{
+    mat4 transform;
+    uvec4 material;
+};
+
+layout (std430, binding = 0) readonly buffer Draws
+{
+    DrawData draws[];
+};
+
+layout (std430, binding = 1) readonly buffer Materials
+{
+    ivec4 materialLayers[];
+};
+
+uniform int drawOffset; // first command of the current glMultiDrawElementsIndirect
+
+out TEX_COORDS
+{
+    vec2 TexCoord;
+    vec3 ABNORMAL;
+    vec3 FragPos;
+    flat ivec4 Layers;
+}tex_coords;
+
+
+void main()
+{
+#ifdef GL_ARB_shader_draw_parameters
+int drawIndex = drawOffset + gl_DrawIDARB;
+#else
+int drawIndex = int(aDrawIndex);
+#endif
+
+mat4 transform = draws[drawIndex].transform;
+
+gl_Position = projection* view * transform * vec4(aPos, 1.0) ;
+
+tex_coords.TexCoord = aTex;
+tex_coords.ABNORMAL = aNormal;
+tex_coords.FragPos = vec3(transform*vec4(aPos,1.0f));
+tex_coords.Layers = materialLayers[draws[drawIndex].material.x];
+
+
+}
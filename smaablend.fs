@@ -0,0 +1,37 @@
+#version 330 core
+
+// AntiAliasing,SMAA 3 of 3: mixes every pixel with the neighbors that cover part of it,by the weights of
+// smaaweights.fs: its own R and B (the pixels above and on the left),G of the one below and A of the one on the right
+
+out vec4 FragColor;
+
+uniform sampler2D scene;   // the rendered area is its bottom left renderSize
+uniform sampler2D weights; // at the rendered size
+uniform vec2 renderSize;
+
+vec3 colorAt(ivec2 texel)
+{
+    return texelFetch(scene,clamp(texel,ivec2(0),ivec2(renderSize) - 1),0).rgb;
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 last = ivec2(renderSize) - 1;
+    vec4 own = texelFetch(weights,texel,0);
+    float fromBelow = texel.y > 0 ? texelFetch(weights,texel + ivec2(0,-1),0).g : 0.0;
+    float fromRight = texel.x < last.x ? texelFetch(weights,texel + ivec2(1,0),0).a : 0.0;
+    vec4 weight = vec4(own.r,own.b,fromBelow,fromRight); // above,left,below,right
+    float total = dot(weight,vec4(1.0));
+
+    vec3 color = colorAt(texel);
+    if (total == 0.0)
+    {
+        FragColor = vec4(color,1.0);
+        return;
+    }
+    float keep = max(1.0 - total,0.0);
+    vec3 blended = color * keep + colorAt(texel + ivec2(0,1)) * weight.x + colorAt(texel + ivec2(-1,0)) * weight.y
+                 + colorAt(texel + ivec2(0,-1)) * weight.z + colorAt(texel + ivec2(1,0)) * weight.w;
+    FragColor = vec4(blended / (keep + total),1.0);
+}
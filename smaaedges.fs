@@ -0,0 +1,47 @@
+#version 330 core
+
+// AntiAliasing,SMAA 1 of 3: the edges of every pixel,R with its left neighbor and G with the one above,
+// where the luma changes by more than threshold. Local contrast adaptation drops an edge next to one with
+// more than twice its contrast,which keeps the gradients of a bright edge from being taken for edges themselves
+
+out vec2 Edges;
+
+uniform sampler2D scene; // the rendered area is its bottom left renderSize
+uniform vec2 renderSize;
+
+const float threshold = 0.1;
+const float contrastAdaptation = 2.0;
+
+float luma(vec3 color) // like fxaa.fs
+{
+    return sqrt(dot(clamp(color,0.0,1.0),vec3(0.299,0.587,0.114)));
+}
+
+float lumaAt(ivec2 texel)
+{
+    return luma(texelFetch(scene,clamp(texel,ivec2(0),ivec2(renderSize) - 1),0).rgb);
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float center = lumaAt(texel);
+    float left = lumaAt(texel + ivec2(-1,0));
+    float up = lumaAt(texel + ivec2(0,1));
+    vec2 delta = abs(center - vec2(left,up));
+    vec2 edges = step(threshold,delta);
+    if (edges.x + edges.y == 0.0)
+    {
+        Edges = vec2(0.0);
+        return;
+    }
+
+    // the biggest contrast around both edges
+    float right = lumaAt(texel + ivec2(1,0));
+    float down = lumaAt(texel + ivec2(0,-1));
+    float leftLeft = lumaAt(texel + ivec2(-2,0));
+    float upUp = lumaAt(texel + ivec2(0,2));
+    float maxDelta = max(max(delta.x,delta.y),max(abs(center - right),abs(center - down)));
+    maxDelta = max(maxDelta,max(abs(left - leftLeft),abs(up - upUp)));
+    Edges = edges * step(maxDelta,contrastAdaptation * delta);
+}
@@ -0,0 +1,106 @@
+#version 330 core
+
+// AntiAliasing,SMAA 2 of 3: how much of every pixel on an edge the neighbor across it should cover.
+// The edge is followed both ways to its ends,and the edges crossing it there give its shape: a step up or down
+// at an end puts the line through the pixels at half a pixel above or below the edge. The parts of the pixel
+// between the edge and that line are the weights,computed from the line here instead of SMAA's precomputed
+// area texture (which is what the original MLAA did). The line runs
+//   from one step to the other end (L shape),from one step to the opposite one (Z),
+//   or from both steps to the middle (U).
+// Out: R the part of this pixel the one above covers,G the part of the one above this pixel covers,
+//      B and A the same with the left neighbor;smaablend.fs gathers them
+
+out vec4 Weights;
+
+uniform sampler2D edges; // smaaedges.fs,at the rendered size
+
+const int maxSearch = 16; // pixels each way,longer edges are treated as ending there
+
+ivec2 size;
+
+vec2 edgesAt(ivec2 texel)
+{
+    if (any(lessThan(texel,ivec2(0))) || any(greaterThanEqual(texel,size)))
+        return vec2(0.0);
+    return texelFetch(edges,texel,0).rg;
+}
+
+// how many pixels past texel the edge in channel goes on
+int search(ivec2 texel,ivec2 direction,int channel)
+{
+    int steps = 0;
+    for (int i = 1; i <= maxSearch; i++)
+    {
+        if (edgesAt(texel + direction * i)[channel] < 0.5)
+            break;
+        steps = i;
+    }
+    return steps;
+}
+
+// +1 for a step to the side away from the pixel,-1 for one to the pixel's side,0 for none (or both)
+float stepAt(float towardPixel,float awayFromPixel)
+{
+    return step(0.5,awayFromPixel) - step(0.5,towardPixel);
+}
+
+// the parts of a pixel at x (of an edge of edgeLength,x from the start) on both sides of the line from height h0
+// at the start to h1 at the end: x the part away from the pixel,y the part on its side
+vec2 coverage(float x,float edgeLength,float h0,float h1)
+{
+    float a = mix(h0,h1,x / edgeLength);
+    float b = mix(h0,h1,(x + 1.0) / edgeLength);
+    if (a * b >= 0.0)
+    {
+        float area = 0.5 * (a + b);
+        return area > 0.0 ? vec2(area,0.0) : vec2(0.0,-area);
+    }
+    float crossing = a / (a - b); // where it crosses the edge,in the pixel
+    vec2 parts = vec2(0.5 * crossing * abs(a),0.5 * (1.0 - crossing) * abs(b));
+    return a > 0.0 ? parts : parts.yx;
+}
+
+vec2 area(float x,float edgeLength,float step0,float step1)
+{
+    float h0 = 0.5 * step0;
+    float h1 = 0.5 * step1;
+    if (h0 == 0.0 && h1 == 0.0)
+        return vec2(0.0);
+    if (h0 == h1) // U,each half on its own
+    {
+        float middle = 0.5 * edgeLength;
+        return x + 0.5 < middle ? coverage(x,middle,h0,0.0) : coverage(x - middle,middle,0.0,h1);
+    }
+    return coverage(x,edgeLength,h0,h1); // Z,or L with one of them 0
+}
+
+void main()
+{
+    size = textureSize(edges,0);
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec2 edge = edgesAt(texel);
+    Weights = vec4(0.0);
+
+    if (edge.g > 0.5) // with the pixel above,the edge runs horizontally
+    {
+        int left = search(texel,ivec2(-1,0),1);
+        int right = search(texel,ivec2(1,0),1);
+        ivec2 start = texel - ivec2(left,0);
+        ivec2 end = texel + ivec2(right + 1,0);
+        float step0 = stepAt(edgesAt(start).r,edgesAt(start + ivec2(0,1)).r);
+        float step1 = stepAt(edgesAt(end).r,edgesAt(end + ivec2(0,1)).r);
+        vec2 parts = area(float(left),float(left + right + 1),step0,step1);
+        Weights.rg = parts.yx; // the line below the edge is the part of this pixel the one above covers
+    }
+    if (edge.r > 0.5) // with the pixel on the left,the edge runs vertically
+    {
+        int down = search(texel,ivec2(0,-1),0);
+        int up = search(texel,ivec2(0,1),0);
+        ivec2 start = texel - ivec2(0,down);
+        ivec2 end = texel + ivec2(0,up + 1);
+        float step0 = stepAt(edgesAt(start + ivec2(0,-1)).g,edgesAt(start + ivec2(-1,-1)).g);
+        float step1 = stepAt(edgesAt(end + ivec2(0,-1)).g,edgesAt(end + ivec2(-1,-1)).g);
+        vec2 parts = area(float(down),float(down + up + 1),step0,step1);
+        Weights.ba = parts.yx;
+    }
+}
@@ -8,6 +8,7 @@ in TEX_COORDS
     vec2 TexCoord;
     vec3 ABNORMAL;
     vec3 FragPos;
+    flat ivec4 Layers;
 }tex_coords;
 
 uniform sampler2D grass;
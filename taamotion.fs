@@ -0,0 +1,30 @@
+#version 330 core
+
+// TemporalAA: where every pixel of the scene was on screen last frame. Texture coordinates of the rendered area,
+// this frame's minus last frame's. What moves on its own (the light cubes) wrote its motion into velocity
+// (velocity.fs),the rest was cleared to 0 and gets the camera's motion,from its depth
+
+out vec2 Motion;
+
+uniform sampler2D sceneDepth;
+uniform sampler2D velocity;
+uniform vec2 renderSize;
+uniform vec2 jitter;                // in pixels,what the projection was shifted by this frame
+uniform mat4 inverseViewProjection; // this frame's,unjittered
+uniform mat4 previousViewProjection;
+
+void main()
+{
+    vec2 written = texelFetch(velocity,ivec2(gl_FragCoord.xy),0).rg;
+    if (written != vec2(0.0))
+    {
+        Motion = written;
+        return;
+    }
+
+    float depth = texelFetch(sceneDepth,ivec2(gl_FragCoord.xy),0).r;
+    vec2 uv = (gl_FragCoord.xy - jitter) / renderSize; // where the sample is without the jitter
+    vec4 world = inverseViewProjection * vec4(uv * 2.0 - 1.0,depth * 2.0 - 1.0,1.0);
+    vec4 previous = previousViewProjection * vec4(world.xyz / world.w,1.0);
+    Motion = uv - (previous.xy / previous.w * 0.5 + 0.5);
+}
@@ -0,0 +1,127 @@
+#version 330 core
+
+// TemporalAA: blends this frame's jittered samples into the history,reprojected with the motion of taamotion.fs.
+// Runs at the output size,which is bigger than the rendered one when upscaling. The blending happens on colors
+// compressed by 1 / (1 + max channel),so a single bright sample doesn't flicker through the average
+
+out vec4 FragColor;
+
+uniform sampler2D scene;      // the rendered area is its bottom left renderSize
+uniform sampler2D sceneDepth;
+uniform sampler2D motion;     // renderSize
+uniform sampler2D history;    // outputSize,the last result
+uniform vec2 renderSize;
+uniform vec2 outputSize;
+uniform vec2 jitter;          // in rendered pixels
+uniform float blend;
+uniform bool historyValid;
+
+const float boxScale = 1.25;  // of the standard deviation,the color box is the smaller of that and the min/max
+
+vec3 compress(vec3 color)
+{
+    return color / (1.0 + max(color.r,max(color.g,color.b)));
+}
+
+vec3 expand(vec3 color)
+{
+    return color / max(1.0 - max(color.r,max(color.g,color.b)),1e-4);
+}
+
+vec3 toYCoCg(vec3 color)
+{
+    return vec3(dot(color,vec3(0.25,0.5,0.25)),dot(color,vec3(0.5,0.0,-0.5)),dot(color,vec3(-0.25,0.5,-0.25)));
+}
+
+vec3 fromYCoCg(vec3 color)
+{
+    return vec3(color.x + color.y - color.z,color.x + color.z,color.x - color.y - color.z);
+}
+
+// Catmull-Rom from five bilinear taps,the four corners of the 4x4 dropped (they weigh next to nothing)
+vec3 sampleHistory(vec2 uv)
+{
+    vec2 position = uv * outputSize;
+    vec2 center = floor(position - 0.5) + 0.5;
+    vec2 f = position - center;
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+    vec2 uv0 = (center - 1.0) / outputSize;
+    vec2 uv3 = (center + 2.0) / outputSize;
+    vec2 uv12 = (center + w2 / w12) / outputSize;
+
+    vec3 color = texture(history,vec2(uv12.x,uv0.y)).rgb * (w12.x * w0.y)
+               + texture(history,vec2(uv0.x,uv12.y)).rgb * (w0.x * w12.y)
+               + texture(history,uv12).rgb * (w12.x * w12.y)
+               + texture(history,vec2(uv3.x,uv12.y)).rgb * (w3.x * w12.y)
+               + texture(history,vec2(uv12.x,uv3.y)).rgb * (w12.x * w3.y);
+    float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+    return max(color / weight,0.0); // the negative lobes can undershoot
+}
+
+// moves the color towards the center of the box until it is inside,which keeps its hue better than clamping each channel
+vec3 clipToBox(vec3 color,vec3 boxMin,vec3 boxMax)
+{
+    vec3 center = 0.5 * (boxMax + boxMin);
+    vec3 extents = 0.5 * (boxMax - boxMin) + 1e-4;
+    vec3 offset = color - center;
+    vec3 units = abs(offset / extents);
+    float largest = max(units.x,max(units.y,units.z));
+    return largest > 1.0 ? center + offset / largest : color;
+}
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / outputSize;
+    vec2 position = uv * renderSize; // in rendered pixels
+    ivec2 lastTexel = ivec2(renderSize) - 1;
+    ivec2 nearest = clamp(ivec2(floor(position + jitter)),ivec2(0),lastTexel); // the sample that landed closest
+
+    // the 3x3 samples around it: the box of their colors,and the motion of the closest one,
+    // so the edges of what moves take its motion instead of the background's
+    vec3 sum = vec3(0.0);
+    vec3 sumSquares = vec3(0.0);
+    vec3 boxMin = vec3(1e9);
+    vec3 boxMax = vec3(-1e9);
+    float closestDepth = 1.0;
+    ivec2 closestTexel = nearest;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            ivec2 texel = clamp(nearest + ivec2(x,y),ivec2(0),lastTexel);
+            vec3 color = toYCoCg(compress(texelFetch(scene,texel,0).rgb));
+            sum += color;
+            sumSquares += color * color;
+            boxMin = min(boxMin,color);
+            boxMax = max(boxMax,color);
+
+            float depth = texelFetch(sceneDepth,texel,0).r;
+            if (depth < closestDepth)
+            {
+                closestDepth = depth;
+                closestTexel = texel;
+            }
+        }
+    }
+    vec3 current = toYCoCg(compress(texelFetch(scene,nearest,0).rgb));
+
+    vec2 previousUV = uv - texelFetch(motion,closestTexel,0).xy;
+    if (!historyValid || any(lessThan(previousUV,vec2(0.0))) || any(greaterThan(previousUV,vec2(1.0))))
+    {
+        FragColor = vec4(expand(fromYCoCg(current)),1.0); // nothing to blend with
+        return;
+    }
+
+    vec3 mean = sum / 9.0;
+    vec3 deviation = sqrt(abs(sumSquares / 9.0 - mean * mean));
+    vec3 previous = clipToBox(toYCoCg(compress(sampleHistory(previousUV))),
+                              max(boxMin,mean - boxScale * deviation),min(boxMax,mean + boxScale * deviation));
+
+    vec2 toSample = vec2(nearest) + 0.5 - jitter - position; // from the pixel,in rendered pixels
+    float weight = exp(-2.29 * dot(toSample,toSample));      // a Gaussian close to Blackman-Harris
+    FragColor = vec4(expand(fromYCoCg(mix(previous,current,blend * weight))),1.0);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+
+// texture coordinates of the rendered area,this frame's minus last frame's,like taamotion.fs
+out vec2 Velocity;
+
+in vec4 Current;
+in vec4 Previous;
+
+void main()
+{
+    Velocity = (Current.xy / Current.w - Previous.xy / Previous.w) * 0.5;
+}
@@ -0,0 +1,35 @@
+#version 330 core
+
+// TemporalAA: the screen motion of what moves on its own (the light cubes),drawn again after the opaque passes
+// into the scene's velocity attachment. Positioned exactly like lightingshader.vs (invariant),so with depth
+// writes off and GL_LEQUAL only the fragments that are on screen write. The instances carry how far they
+// moved since the last frame (InstanceBuffer::Instance::displacement,in world space)
+layout (location = 0) in vec3 aPos;
+layout (location = 8) in mat4 aInstanceTransform;
+layout (location = 14) in vec3 aInstanceDisplacement;
+
+layout (std140) uniform Perspective
+{
+    mat4 projection;
+    mat4 view;
+
+};
+
+invariant gl_Position;
+
+uniform mat4 transform;
+uniform mat4 viewProjection;         // this frame's,unjittered
+uniform mat4 previousViewProjection;
+
+out vec4 Current;
+out vec4 Previous;
+
+void main()
+{
+mat4 model = transform * aInstanceTransform;
+vec3 Position = vec3(model * vec4(aPos,1.0));
+Current = viewProjection * vec4(Position,1.0);
+Previous = previousViewProjection * vec4(Position - aInstanceDisplacement,1.0);
+
+gl_Position = projection * view * vec4(Position, 1.0);
+}